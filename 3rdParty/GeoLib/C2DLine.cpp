@@ -25,7 +25,7 @@ finite line.
 
 using namespace std;
 
-_MEMORY_POOL_IMPLEMENATION(C2DLine)
+_MEMORY_POOLED_IMPLEMENTATION(C2DLine)
 
 /**--------------------------------------------------------------------------<BR>
 C2DLine::C2DLine
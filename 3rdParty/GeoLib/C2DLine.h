@@ -33,7 +33,7 @@ class CTransformation;
 class GeoLib_API C2DLine : public C2DLineBase
 {
 public:
-	_MEMORY_POOL_DECLARATION
+	_MEMORY_POOLED_DECLARATION
 
 	/// Constructor.
 	C2DLine(void);
@@ -0,0 +1,197 @@
+/*---------------------------------------------------------------------------
+Copyright (C) GeoLib.
+This code is used under license from GeoLib (www.geolib.co.uk). This or
+any modified versions of this cannot be resold to any other party.
+---------------------------------------------------------------------------*/
+
+
+/**--------------------------------------------------------------------------<BR>
+\file 2DLineArray.cpp
+\brief Implementation file for the C2DLineArray Class
+
+Implementation file for C2DLineArray, a class which represents an array of
+straight lines held by value.
+<P>---------------------------------------------------------------------------*/
+
+#include "StdAfx.h"
+#include "C2DLineArray.h"
+#include "C2DLineSet.h"
+#include "C2DRect.h"
+
+using namespace std;
+
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::C2DLineArray<BR>
+\brief Constructor.
+<P>---------------------------------------------------------------------------*/
+C2DLineArray::C2DLineArray(void) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::C2DLineArray<BR>
+\brief Copy constructor.
+<P>---------------------------------------------------------------------------*/
+C2DLineArray::C2DLineArray(const C2DLineArray& Other) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+	*this = Other;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::C2DLineArray<BR>
+\brief Constructor copies the lines of the set.
+<P>---------------------------------------------------------------------------*/
+C2DLineArray::C2DLineArray(const C2DLineSet& Other) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+	AddCopy(Other);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::~C2DLineArray<BR>
+\brief Destructor.
+<P>---------------------------------------------------------------------------*/
+C2DLineArray::~C2DLineArray(void)
+{
+	delete [] m_pData;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::operator=<BR>
+\brief Assignment.
+<P>---------------------------------------------------------------------------*/
+const C2DLineArray& C2DLineArray::operator=(const C2DLineArray& Other)
+{
+	if (this != &Other)
+	{
+		Clear();
+		Reserve(Other.m_nSize);
+		copy(Other.m_pData, Other.m_pData + Other.m_nSize, m_pData);
+		m_nSize = Other.m_nSize;
+	}
+	return *this;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::Reserve<BR>
+\brief Reserves space for the number of lines given.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::Reserve(unsigned int nCapacity)
+{
+	if (nCapacity <= m_nCapacity)
+		return;
+
+	sCoord* pData = new sCoord[nCapacity];
+	copy(m_pData, m_pData + m_nSize, pData);
+	delete [] m_pData;
+	m_pData = pData;
+	m_nCapacity = nCapacity;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::AddCopy<BR>
+\brief Adds a new line from the first point to the second.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::AddCopy(double x1, double y1, double x2, double y2)
+{
+	if (m_nSize == m_nCapacity)
+		Reserve(m_nSize ? 2 * m_nSize : 16);
+
+	sCoord& Line = m_pData[m_nSize++];
+	Line.x = x1;
+	Line.y = y1;
+	Line.i = x2 - x1;
+	Line.j = y2 - y1;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::AddCopy<BR>
+\brief Adds a new line.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::AddCopy(const C2DLine& Line)
+{
+	if (m_nSize == m_nCapacity)
+		Reserve(m_nSize ? 2 * m_nSize : 16);
+
+	sCoord& NewLine = m_pData[m_nSize++];
+	NewLine.x = Line.point.x;
+	NewLine.y = Line.point.y;
+	NewLine.i = Line.vector.i;
+	NewLine.j = Line.vector.j;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::AddCopy<BR>
+\brief Adds copies of the lines of the set.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::AddCopy(const C2DLineSet& Other)
+{
+	Reserve(m_nSize + Other.size());
+	for (unsigned int i = 0 ; i < Other.size(); i++)
+	{
+		AddCopy(Other[i]);
+	}
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::MakeCopy<BR>
+\brief Makes a copy of the lines of the set.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::MakeCopy(const C2DLineSet& Other)
+{
+	Clear();
+	AddCopy(Other);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::CopyTo<BR>
+\brief Adds copies of the lines to the set given.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::CopyTo(C2DLineSet& Other) const
+{
+	for (unsigned int i = 0 ; i < m_nSize; i++)
+	{
+		Other.Add(new C2DLine(GetAt(i)));
+	}
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::GetAt<BR>
+\brief Returns the line at the index given.
+<P>---------------------------------------------------------------------------*/
+C2DLine C2DLineArray::GetAt(unsigned int nIndx) const
+{
+	const sCoord& Line = m_pData[nIndx];
+	return C2DLine(C2DPoint(Line.x, Line.y), C2DVector(Line.i, Line.j));
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DLineArray::GetBoundingRect<BR>
+\brief Gets the bounding rectangle.
+<P>---------------------------------------------------------------------------*/
+void C2DLineArray::GetBoundingRect(C2DRect& Rect) const
+{
+	if (m_nSize == 0)
+	{
+		Rect.Clear();
+		return;
+	}
+
+	double dLeft = m_pData[0].x;
+	double dRight = m_pData[0].x;
+	double dTop = m_pData[0].y;
+	double dBottom = m_pData[0].y;
+
+	for (unsigned int i = 0 ; i < m_nSize; i++)
+	{
+		const sCoord& Line = m_pData[i];
+		double x1 = Line.x, x2 = Line.x + Line.i;
+		double y1 = Line.y, y2 = Line.y + Line.j;
+		dLeft = min(dLeft, min(x1, x2));
+		dRight = max(dRight, max(x1, x2));
+		dTop = max(dTop, max(y1, y2));
+		dBottom = min(dBottom, min(y1, y2));
+	}
+
+	Rect.Set(dLeft, dTop, dRight, dBottom);
+}
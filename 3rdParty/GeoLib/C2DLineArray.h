@@ -0,0 +1,93 @@
+/*---------------------------------------------------------------------------
+Copyright (C) GeoLib.
+This code is used under license from GeoLib (www.geolib.co.uk). This or
+any modified versions of this cannot be resold to any other party.
+---------------------------------------------------------------------------*/
+
+
+/**--------------------------------------------------------------------------<BR>
+\file 2DLineArray.h
+\brief Declaration file for the C2DLineArray Class
+
+Declaration file for C2DLineArray, a class which represents an array of straight
+lines held by value.
+
+\class C2DLineArray.
+\brief Class which represents an array of straight lines held by value.
+
+Class which holds its lines contiguously as a point and a vector each, as in
+C2DLine, rather than pointers to C2DLine objects like C2DLineSet does.
+<P>---------------------------------------------------------------------------*/
+
+#ifndef _GEOLIB_C2DLINEARRAY_H
+#define _GEOLIB_C2DLINEARRAY_H
+
+#include "C2DLine.h"
+
+class C2DLineSet;
+class C2DRect;
+
+class GeoLib_API C2DLineArray
+{
+public:
+	/// The point and vector of one line.
+	struct sCoord
+	{
+		double x;
+		double y;
+		double i;
+		double j;
+	};
+
+	/// Constructor.
+	C2DLineArray(void);
+	/// Copy constructor.
+	C2DLineArray(const C2DLineArray& Other);
+	/// Constructor copies the lines of the set.
+	explicit C2DLineArray(const C2DLineSet& Other);
+	/// Destructor.
+	~C2DLineArray(void);
+	/// Assignment.
+	const C2DLineArray& operator=(const C2DLineArray& Other);
+
+	/// Returns the size.
+	unsigned int size(void) const { return m_nSize;}
+	/// Reserves space for the number of lines given.
+	void Reserve(unsigned int nCapacity);
+	/// Removes all the lines.
+	void Clear(void) { m_nSize = 0;}
+
+	/// Adds a new line from the first point to the second.
+	void AddCopy(double x1, double y1, double x2, double y2);
+	/// Adds a new line.
+	void AddCopy(const C2DLine& Line);
+	/// Adds copies of the lines of the set.
+	void AddCopy(const C2DLineSet& Other);
+	/// Makes a copy of the lines of the set.
+	void MakeCopy(const C2DLineSet& Other);
+	/// Adds copies of the lines to the set given.
+	void CopyTo(C2DLineSet& Other) const;
+
+	/// Returns the line at the index given.
+	C2DLine GetAt(unsigned int nIndx) const;
+	/// Returns a reference to the point and vector at the index given.
+	sCoord& operator[] (unsigned int nIndx) { return m_pData[nIndx];}
+	/// Returns a reference to the point and vector at the index given.
+	const sCoord& operator[] (unsigned int nIndx) const { return m_pData[nIndx];}
+	/// Returns the lines, a point and a vector each.
+	const sCoord* GetData(void) const { return m_pData;}
+
+	/// Returns the bounding rect.
+	void GetBoundingRect(C2DRect& Rect) const;
+
+private:
+	/// The lines.
+	sCoord* m_pData;
+	/// The number of lines.
+	unsigned int m_nSize;
+	/// The number of lines there is space for.
+	unsigned int m_nCapacity;
+};
+
+
+#endif
@@ -24,25 +24,7 @@ Implementation file for C2DPoint, a class which represents a cartesian point.
 
 using namespace std;
 
-//_MEMORY_POOL_IMPLEMENATION(C2DPoint)
-
-
-//void* C2DPoint::operator new(size_t)
-//{
-//	return ::new C2DPoint;
-// }
-//
-//
-//void C2DPoint::operator delete(void* p)
-//{
-//	::delete p;
-//}
-//
-//
-//void* C2DPoint::operator new(size_t, const char*,int)
-//{
-//	return ::new C2DPoint;
-//}
+_MEMORY_POOLED_IMPLEMENTATION(C2DPoint)
 
 
 /**--------------------------------------------------------------------------<BR>
@@ -29,7 +29,7 @@ class C2DPointSet;
 class GeoLib_API C2DPoint : public C2DBase
 {
 public:
-    _MEMORY_POOL_DECLARATION
+    _MEMORY_POOLED_DECLARATION
 
 	/// Constructor.
 	C2DPoint(void);
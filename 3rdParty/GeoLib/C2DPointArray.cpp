@@ -0,0 +1,357 @@
+/*---------------------------------------------------------------------------
+Copyright (C) GeoLib.
+This code is used under license from GeoLib (www.geolib.co.uk). This or
+any modified versions of this cannot be resold to any other party.
+---------------------------------------------------------------------------*/
+
+
+/**--------------------------------------------------------------------------<BR>
+\file 2DPointArray.cpp
+\brief Implementation file for the C2DPointArray Class
+
+Implementation file for C2DPointArray, a class which represents an array of
+points held by value.
+<P>---------------------------------------------------------------------------*/
+
+#include "StdAfx.h"
+#include "C2DPointArray.h"
+#include "C2DPointSet.h"
+#include "C2DRect.h"
+#include <cfloat>
+
+using namespace std;
+
+typedef C2DPointArray::sCoord sCoord;
+
+/**--------------------------------------------------------------------------<BR>
+Cross<BR>
+\brief Cross product of O->A and O->B; negative if O, A, B turn to the right.
+<P>---------------------------------------------------------------------------*/
+static double Cross(const sCoord& O, const sCoord& A, const sCoord& B)
+{
+	return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
+}
+
+/**--------------------------------------------------------------------------<BR>
+sClosestPair<BR>
+\brief Divide and conquer search for the closest pair, on copies of the points
+sorted by x, with their index. The recursion leaves each range sorted by y, for
+the strip search of its parent. Distances are squared until the end.
+<P>---------------------------------------------------------------------------*/
+struct sClosestPair
+{
+	struct sPoint
+	{
+		double x;
+		double y;
+		unsigned int nIndex;
+	};
+
+	vector<sPoint> Points;
+	vector<sPoint> Temp;
+	double dMinDist2;
+	unsigned int nIndex1;
+	unsigned int nIndex2;
+
+	static bool LessX(const sPoint& a, const sPoint& b) { return a.x < b.x;}
+	static bool LessY(const sPoint& a, const sPoint& b) { return a.y < b.y;}
+
+	void Update(const sPoint& a, const sPoint& b)
+	{
+		double dx = a.x - b.x;
+		double dy = a.y - b.y;
+		double dDist2 = dx * dx + dy * dy;
+		if (dDist2 < dMinDist2)
+		{
+			dMinDist2 = dDist2;
+			nIndex1 = a.nIndex;
+			nIndex2 = b.nIndex;
+		}
+	}
+
+	void Search(unsigned int nFirst, unsigned int nLast)
+	{
+		sPoint* pPoints = &Points[0];
+
+		if (nLast - nFirst <= 3)
+		{
+			for (unsigned int i = nFirst; i < nLast; i++)
+				for (unsigned int j = i + 1; j < nLast; j++)
+					Update(pPoints[i], pPoints[j]);
+			sort(pPoints + nFirst, pPoints + nLast, LessY);
+			return;
+		}
+
+		unsigned int nMid = (nFirst + nLast) / 2;
+		double dMidX = pPoints[nMid].x;
+		Search(nFirst, nMid);
+		Search(nMid, nLast);
+
+		sPoint* pTemp = &Temp[0];
+		merge(pPoints + nFirst, pPoints + nMid, pPoints + nMid, pPoints + nLast, pTemp, LessY);
+		copy(pTemp, pTemp + (nLast - nFirst), pPoints + nFirst);
+
+		// The strip either side of the middle, by y; Temp is free again.
+		unsigned int nStrip = 0;
+		for (unsigned int i = nFirst; i < nLast; i++)
+		{
+			const sPoint& pt = pPoints[i];
+			double dx = pt.x - dMidX;
+			if (dx * dx >= dMinDist2)
+				continue;
+			for (unsigned int j = nStrip; j > 0; j--)
+			{
+				double dy = pt.y - pTemp[j - 1].y;
+				if (dy * dy >= dMinDist2)
+					break;
+				Update(pt, pTemp[j - 1]);
+			}
+			pTemp[nStrip++] = pt;
+		}
+	}
+};
+
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::C2DPointArray<BR>
+\brief Constructor.
+<P>---------------------------------------------------------------------------*/
+C2DPointArray::C2DPointArray(void) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::C2DPointArray<BR>
+\brief Copy constructor.
+<P>---------------------------------------------------------------------------*/
+C2DPointArray::C2DPointArray(const C2DPointArray& Other) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+	*this = Other;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::C2DPointArray<BR>
+\brief Constructor copies the points of the set.
+<P>---------------------------------------------------------------------------*/
+C2DPointArray::C2DPointArray(const C2DPointSet& Other) : m_pData(0), m_nSize(0), m_nCapacity(0)
+{
+	AddCopy(Other);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::~C2DPointArray<BR>
+\brief Destructor.
+<P>---------------------------------------------------------------------------*/
+C2DPointArray::~C2DPointArray(void)
+{
+	delete [] m_pData;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::operator=<BR>
+\brief Assignment.
+<P>---------------------------------------------------------------------------*/
+const C2DPointArray& C2DPointArray::operator=(const C2DPointArray& Other)
+{
+	if (this != &Other)
+	{
+		Clear();
+		Reserve(Other.m_nSize);
+		copy(Other.m_pData, Other.m_pData + Other.m_nSize, m_pData);
+		m_nSize = Other.m_nSize;
+	}
+	return *this;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::Reserve<BR>
+\brief Reserves space for the number of points given.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::Reserve(unsigned int nCapacity)
+{
+	if (nCapacity <= m_nCapacity)
+		return;
+
+	sCoord* pData = new sCoord[nCapacity];
+	copy(m_pData, m_pData + m_nSize, pData);
+	delete [] m_pData;
+	m_pData = pData;
+	m_nCapacity = nCapacity;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::AddCopy<BR>
+\brief Adds copies of the points of the set.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::AddCopy(const C2DPointSet& Other)
+{
+	Reserve(m_nSize + Other.size());
+	for (unsigned int i = 0 ; i < Other.size(); i++)
+	{
+		const C2DPoint& pt = Other[i];
+		m_pData[m_nSize].x = pt.x;
+		m_pData[m_nSize].y = pt.y;
+		m_nSize++;
+	}
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::MakeCopy<BR>
+\brief Makes a copy of the points of the set.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::MakeCopy(const C2DPointSet& Other)
+{
+	Clear();
+	AddCopy(Other);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::CopyTo<BR>
+\brief Adds copies of the points to the set given.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::CopyTo(C2DPointSet& Other) const
+{
+	for (unsigned int i = 0 ; i < m_nSize; i++)
+	{
+		Other.AddCopy(m_pData[i].x, m_pData[i].y);
+	}
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::ExtractConvexHull<BR>
+\brief Extracts the convex hull from the points given, clockwise from the left
+most, as C2DPointSet does. Uses Andrew's monotone chain.
+
+For points in general position the result is the same as the set's. Otherwise
+it differs: the hull holds its vertices only, leaving points on an edge and
+repeated points in Other, and starts at the top of the left most points.
+C2DPointSet starts at the first left most point given, and may keep points on
+an edge or repeated ones, depending on the order it sorts them in.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::ExtractConvexHull( C2DPointArray& Other)
+{
+	Clear();
+
+	if (Other.size() < 4)
+	{
+		*this = Other;
+		Other.Clear();
+		return;
+	}
+
+	const sCoord* pData = Other.m_pData;
+	unsigned int nCount = Other.size();
+
+	vector<unsigned int> Order(nCount);
+	for (unsigned int i = 0 ; i < nCount; i++)
+		Order[i] = i;
+	sort(Order.begin(), Order.end(), [pData](unsigned int a, unsigned int b)
+		{ return pData[a].x < pData[b].x || (pData[a].x == pData[b].x && pData[a].y > pData[b].y); });
+
+	// Upper chain left to right, then lower chain back, keeping right turns only.
+	vector<unsigned int> Hull(2 * nCount);
+	unsigned int k = 0;
+	for (unsigned int i = 0 ; i < nCount; i++)
+	{
+		while (k >= 2 && Cross(pData[Hull[k - 2]], pData[Hull[k - 1]], pData[Order[i]]) >= 0)
+			k--;
+		Hull[k++] = Order[i];
+	}
+	for (unsigned int i = nCount - 1, nUpper = k + 1; i > 0; i--)
+	{
+		while (k >= nUpper && Cross(pData[Hull[k - 2]], pData[Hull[k - 1]], pData[Order[i - 1]]) >= 0)
+			k--;
+		Hull[k++] = Order[i - 1];
+	}
+	k--;	// The left most again.
+	if (k == 2 && pData[Hull[0]].x == pData[Hull[1]].x && pData[Hull[0]].y == pData[Hull[1]].y)
+		k = 1;	// All the points are the same.
+
+	vector<bool> bOnHull(nCount, false);
+	Reserve(k);
+	for (unsigned int i = 0 ; i < k; i++)
+	{
+		m_pData[m_nSize++] = pData[Hull[i]];
+		bOnHull[Hull[i]] = true;
+	}
+
+	unsigned int nKept = 0;
+	for (unsigned int i = 0 ; i < nCount; i++)
+	{
+		if (!bOnHull[i])
+			Other.m_pData[nKept++] = pData[i];
+	}
+	Other.m_nSize = nKept;
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::GetBoundingRect<BR>
+\brief Gets the bounding rectangle.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::GetBoundingRect(C2DRect& Rect) const
+{
+	if (m_nSize == 0)
+	{
+		Rect.Clear();
+		return;
+	}
+
+	double dLeft = m_pData[0].x;
+	double dRight = m_pData[0].x;
+	double dTop = m_pData[0].y;
+	double dBottom = m_pData[0].y;
+
+	for (unsigned int i = 1 ; i < m_nSize; i++)
+	{
+		dLeft = min(dLeft, m_pData[i].x);
+		dRight = max(dRight, m_pData[i].x);
+		dTop = max(dTop, m_pData[i].y);
+		dBottom = min(dBottom, m_pData[i].y);
+	}
+
+	Rect.Set(dLeft, dTop, dRight, dBottom);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::GetClosestPair<BR>
+\brief Gets the closest pair of points, by their index in the array.
+<P>---------------------------------------------------------------------------*/
+double C2DPointArray::GetClosestPair(unsigned int& nIndex1, unsigned int& nIndex2) const
+{
+	if (m_nSize < 2)
+	{
+		assert(false);
+		nIndex1 = nIndex2 = 0;
+		return 0;
+	}
+
+	sClosestPair Search;
+	Search.Points.resize(m_nSize);
+	Search.Temp.resize(m_nSize);
+	Search.dMinDist2 = DBL_MAX;
+	Search.nIndex1 = 0;
+	Search.nIndex2 = 1;
+
+	for (unsigned int i = 0 ; i < m_nSize; i++)
+	{
+		Search.Points[i].x = m_pData[i].x;
+		Search.Points[i].y = m_pData[i].y;
+		Search.Points[i].nIndex = i;
+	}
+	sort(Search.Points.begin(), Search.Points.end(), sClosestPair::LessX);
+
+	Search.Search(0, m_nSize);
+
+	nIndex1 = min(Search.nIndex1, Search.nIndex2);
+	nIndex2 = max(Search.nIndex1, Search.nIndex2);
+	return sqrt(Search.dMinDist2);
+}
+
+/**--------------------------------------------------------------------------<BR>
+C2DPointArray::SortLeftToRight<BR>
+\brief Sorts left to right.
+<P>---------------------------------------------------------------------------*/
+void C2DPointArray::SortLeftToRight(void)
+{
+	sort(m_pData, m_pData + m_nSize, [](const sCoord& a, const sCoord& b) { return a.x < b.x; });
+}
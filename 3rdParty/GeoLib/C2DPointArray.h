@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------
+Copyright (C) GeoLib.
+This code is used under license from GeoLib (www.geolib.co.uk). This or
+any modified versions of this cannot be resold to any other party.
+---------------------------------------------------------------------------*/
+
+
+/**--------------------------------------------------------------------------<BR>
+\file 2DPointArray.h
+\brief Declaration file for the C2DPointArray Class
+
+Declaration file for C2DPointArray, a class which represents an array of points
+held by value.
+
+\class C2DPointArray.
+\brief Class which represents an array of points held by value.
+
+Class which holds the coordinates of its points contiguously, x and y in turn,
+rather than pointers to C2DPoint objects like C2DPointSet does. Copies to and
+from a C2DPointSet in one pass, and has the point set algorithms that are
+dominated by reading the points.
+<P>---------------------------------------------------------------------------*/
+
+#ifndef _GEOLIB_C2DPOINTARRAY_H
+#define _GEOLIB_C2DPOINTARRAY_H
+
+#include "C2DPoint.h"
+
+class C2DPointSet;
+class C2DRect;
+
+class GeoLib_API C2DPointArray
+{
+public:
+	/// The coordinates of one point.
+	struct sCoord
+	{
+		double x;
+		double y;
+	};
+
+	/// Constructor.
+	C2DPointArray(void);
+	/// Copy constructor.
+	C2DPointArray(const C2DPointArray& Other);
+	/// Constructor copies the points of the set.
+	explicit C2DPointArray(const C2DPointSet& Other);
+	/// Destructor.
+	~C2DPointArray(void);
+	/// Assignment.
+	const C2DPointArray& operator=(const C2DPointArray& Other);
+
+	/// Returns the size.
+	unsigned int size(void) const { return m_nSize;}
+	/// Reserves space for the number of points given.
+	void Reserve(unsigned int nCapacity);
+	/// Removes all the points.
+	void Clear(void) { m_nSize = 0;}
+
+	/// Adds a new point.
+	void AddCopy(double x, double y) { if (m_nSize == m_nCapacity) Reserve(m_nSize ? 2 * m_nSize : 16); m_pData[m_nSize].x = x; m_pData[m_nSize].y = y; m_nSize++;}
+	/// Adds a new point.
+	void AddCopy(const C2DPoint& Point) { AddCopy(Point.x, Point.y);}
+	/// Adds copies of the points of the set.
+	void AddCopy(const C2DPointSet& Other);
+	/// Makes a copy of the points of the set.
+	void MakeCopy(const C2DPointSet& Other);
+	/// Adds copies of the points to the set given.
+	void CopyTo(C2DPointSet& Other) const;
+
+	/// Returns the point at the index given.
+	C2DPoint GetAt(unsigned int nIndx) const { return C2DPoint(m_pData[nIndx].x, m_pData[nIndx].y);}
+	/// Sets the point at the index given.
+	void SetAt(unsigned int nIndx, double x, double y) { m_pData[nIndx].x = x; m_pData[nIndx].y = y;}
+	/// Returns a reference to the coordinates at the index given.
+	sCoord& operator[] (unsigned int nIndx) { return m_pData[nIndx];}
+	/// Returns a reference to the coordinates at the index given.
+	const sCoord& operator[] (unsigned int nIndx) const { return m_pData[nIndx];}
+	/// Returns the coordinates, x and y in turn.
+	const sCoord* GetData(void) const { return m_pData;}
+
+	/// Removes the vertices of the convex hull from the points given.
+	void ExtractConvexHull( C2DPointArray& Other);
+	/// Returns the bounding rect.
+	void GetBoundingRect(C2DRect& Rect) const;
+	/// Gets the closest pair of points in the array.
+	double GetClosestPair(unsigned int& nIndex1, unsigned int& nIndex2) const;
+	/// Sorts from left to right.
+	void SortLeftToRight(void);
+
+private:
+	/// The points.
+	sCoord* m_pData;
+	/// The number of points.
+	unsigned int m_nSize;
+	/// The number of points there is space for.
+	unsigned int m_nCapacity;
+};
+
+
+#endif
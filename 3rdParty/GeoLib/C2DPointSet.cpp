@@ -14,14 +14,25 @@ Implementation file for C2DPointSet, a class which represents a set of points.
 
 #include "StdAfx.h"
 #include "C2DPointSet.h"
+#include "C2DPointArray.h"
 #include "Sort.h"
 #include "C2DLine.h"
 #include "C2DBaseSet.h"
 #include "C2DRect.h"
 #include "C2DCircle.h"
+#include <unordered_map>
 
 using namespace std;
 
+/**--------------------------------------------------------------------------<BR>
+CellKey<BR>
+\brief Hash key of a grid cell used by RemoveRepeatedPoints.
+<P>---------------------------------------------------------------------------*/
+static unsigned long long CellKey(long long x, long long y)
+{
+	return (unsigned long long)x * 73856093ull ^ (unsigned long long)y * 19349663ull;
+}
+
 _MEMORY_POOL_IMPLEMENATION(C2DPointSet)
 
 /**--------------------------------------------------------------------------<BR>
@@ -427,29 +438,85 @@ unsigned int C2DPointSet::GetFurthestPoint(unsigned int nIndex, double& dDist) c
 /**--------------------------------------------------------------------------<BR>
 C2DPointSet::RemoveRepeatedPoints<BR>
 \brief Removes repeated points from the set.
+Keeps the first of each group of equal points. Points are hashed in a grid 
+whose cell is the equality tolerance of the largest coordinate, so that equal 
+points fall in neighbouring cells. Linear in the expected case.
 <P>---------------------------------------------------------------------------*/
 void C2DPointSet::RemoveRepeatedPoints(void)
 {
-	if (size() < 2)
+	C2DBaseData& Data = *reinterpret_cast<C2DBaseData*>(m_Data);
+
+	const unsigned int nSize = (unsigned int)Data.size();
+	if (nSize < 2)
 		return;
 
-	unsigned int i = 0;
-	while (i < size())
+	double dMaxX = 0;
+	double dMaxY = 0;
+	for (unsigned int i = 0 ; i < nSize; i++)
+	{
+		const C2DPoint* pt = GetAt(i);
+		dMaxX = max(dMaxX, fabs(pt->x));
+		dMaxY = max(dMaxY, fabs(pt->y));
+	}
+
+	// Equal points differ by less than the tolerance relative to their coordinates.
+	const double dCellX = dMaxX > 0 ? dMaxX * conEqualityTolerance : 1;
+	const double dCellY = dMaxY > 0 ? dMaxY * conEqualityTolerance : 1;
+
+	unordered_map<unsigned long long, int> Heads;
+	Heads.reserve(nSize);
+	std::vector<int> Next;
+	Next.reserve(nSize);
+	std::vector<long long> CellX, CellY;
+	CellX.reserve(nSize);
+	CellY.reserve(nSize);
+
+	C2DBaseData Kept;
+	Kept.reserve(nSize);
+
+	for (unsigned int i = 0 ; i < nSize; i++)
 	{
-		unsigned int r = i + 1;
-		while (r < size())
+		C2DPoint* pt = GetAt(i);
+		const long long cx = (long long)floor(pt->x / dCellX);
+		const long long cy = (long long)floor(pt->y / dCellY);
+
+		bool bRepeated = false;
+		for (long long dx = -1; dx <= 1 && !bRepeated; dx++)
 		{
-			if ( (*GetAt(i)) == (*GetAt(r)))
-			{
-				DeleteAt(r);
-			}
-			else
+			for (long long dy = -1; dy <= 1 && !bRepeated; dy++)
 			{
-				r++;
+				unordered_map<unsigned long long, int>::const_iterator it = 
+					Heads.find(CellKey(cx + dx, cy + dy));
+				if (it == Heads.end())
+					continue;
+				for (int k = it->second; k >= 0; k = Next[k])
+				{
+					if (CellX[k] == cx + dx && CellY[k] == cy + dy &&
+						(*dynamic_cast<C2DPoint*>(Kept[k])) == (*pt))
+					{
+						bRepeated = true;
+						break;
+					}
+				}
 			}
 		}
-		i++;
+
+		if (bRepeated)
+		{
+			delete pt;
+			continue;
+		}
+
+		const unsigned long long Key = CellKey(cx, cy);
+		unordered_map<unsigned long long, int>::iterator it = Heads.find(Key);
+		Next.push_back(it == Heads.end() ? -1 : it->second);
+		Heads[Key] = (int)Kept.size();
+		CellX.push_back(cx);
+		CellY.push_back(cy);
+		Kept.push_back(pt);
 	}
+
+	Data.swap(Kept);
 }
 
 /**--------------------------------------------------------------------------<BR>
@@ -497,136 +564,16 @@ void C2DPointSet::SortByAngleToLeft( const C2DLine& Line)
 
 }
 
-/**--------------------------------------------------------------------------<BR>
-struct sPointIndex
-\brief Structure to hold a point reference and its corresponding index.
-<P>---------------------------------------------------------------------------*/
-struct sPointIndex
-{
-	const C2DPoint* pt;
-	unsigned int usIndex;
-};
-
-class PointIndexSet : public vector<sPointIndex*>
-{
-};
-
-
 /**--------------------------------------------------------------------------<BR>
 C2DPointSet::GetClosestPair<BR>
-\brief Private function to help finding closest pair.
-<P>---------------------------------------------------------------------------*/
-double C2DPointSet::GetClosestPair(PointIndexSet& Pts, unsigned int& nIndex1, unsigned int& nIndex2)
-{
-	if (Pts.size() > 2)
-	{
-		PointIndexSet Pts1;
-		PointIndexSet Pts2;
-		
-		unsigned int nHalfWay = Pts.size() / 2;
-		double dHalfWay = Pts[ nHalfWay ]->pt->x;
-		
-		for ( unsigned int i = 0; i <= nHalfWay ; i++)
-		{
-			Pts1.push_back( Pts[i] );
-		}
-		for ( unsigned int i = nHalfWay; i < Pts.size() ; i++)
-		{
-			Pts2.push_back( Pts[i] );
-		}
-		unsigned int n1_1;
-		unsigned int n1_2;	
-		unsigned int n2_1;
-		unsigned int n2_2;
-
-		double d1 = C2DPointSet::GetClosestPair(Pts1, n1_1, n1_2);
-		double d2 = C2DPointSet::GetClosestPair(Pts2, n2_1, n2_2);
-
-		double dMinDist;
-		if (d1 < d2)
-		{
-			dMinDist = d1;
-			nIndex1 = n1_1;
-			nIndex2 = n1_2;
-		}
-		else
-		{
-			dMinDist = d2;
-			nIndex1 = n2_1 + nHalfWay;
-			nIndex2 = n2_2 + nHalfWay;
-		}
-
-		double dMin = dHalfWay - dMinDist;
-		double dMax = dHalfWay + dMinDist;
-		unsigned int i = Pts1.size() - 2; // don't start on last as that was included in the other set
-		while ( i >= 0 && Pts1[i]->pt->x > dMin)
-		{
-			unsigned int j = 1;	// don't start on last as that was included in the other set
-			while ( j < Pts2.size() && Pts2[j]->pt->x < dMax)
-			{
-				if ( abs( Pts2[j]->pt->y - Pts1[i]->pt->y ) < dMinDist )
-				{
-					double dDist = Pts2[j]->pt->Distance( *Pts1[i]->pt );
-					if (dDist < dMinDist)
-					{
-						dMinDist = dDist;
-						dMin = dHalfWay - dMinDist;
-						dMax = dHalfWay + dMinDist;
-						nIndex1 = i;
-						nIndex2 = j + nHalfWay;
-					}
-				}
-				j++;
-			}
-			i--;
-		}
-		return dMinDist;
-
-	}
-	else if (Pts.size() == 2)
-	{
-		nIndex1 = 0;
-		nIndex2 = 1;
-		return Pts[0]->pt->Distance( *Pts[1]->pt );
-	}
-	else
-	{
-		assert(false);
-		return 0;
-	}
-}
-
-/**--------------------------------------------------------------------------<BR>
-C2DPointSet::GetClosestPair<BR>
-\brief Gets the closest pair of points.
+\brief Gets the closest pair of points, on a contiguous copy of them.
 <P>---------------------------------------------------------------------------*/
 double C2DPointSet::GetClosestPair(unsigned int& nIndex1, unsigned int& nIndex2) const
 {
-	PointIndexSet Pts;
-	std::vector<double> xValues;
-
-	for (unsigned int i = 0 ; i < size() ; i++)
-	{
-		sPointIndex* pPointIndex = new sPointIndex;
-		pPointIndex->pt = GetAt(i);
-		pPointIndex->usIndex = i;
-		Pts.push_back( pPointIndex );
-		xValues.push_back(pPointIndex->pt->x);
-	}
-
-	// Sort them all according to the left most point of the line rects.
-	GeoSort::PQuickSort< std::vector<double>, double, std::vector<sPointIndex*>, sPointIndex*>( xValues, Pts);
-
-	double dResult = C2DPointSet::GetClosestPair(Pts, nIndex1, nIndex2);
-
-	for (unsigned int i = 0 ; i < Pts.size() ; i++)
-	{
-		delete Pts[i];
-	}
-
-	return dResult;
-
+	C2DPointArray Points(*this);
+	return Points.GetClosestPair(nIndex1, nIndex2);
 }
+
 /**--------------------------------------------------------------------------<BR>
 C2DPointSet::SortLeftToRight<BR>
 \brief Sorts left to right.
@@ -27,8 +27,6 @@ sorting functions and a convex hull algorithm.
 
 class C2DBaseSet;
 class C2DCircle;
-struct sPointIndex;
-class PointIndexSet;
 
 class GeoLib_API C2DPointSet :  public C2DBaseSet
 {
@@ -113,8 +111,6 @@ public:
 private:
 	/// Returns the furthest point from the one given.
 	unsigned int GetFurthestPoint(unsigned int nIndex, double& dDist) const;
-	/// Gets the closts pair of points in the set.
-	static double GetClosestPair(PointIndexSet& Pts, unsigned int& nIndex1, unsigned int& nIndex2);
 
 };
 
@@ -21,7 +21,7 @@ vertical sides. C2DPoints represent the top left and bottom right.
 
 using namespace std;
 
-_MEMORY_POOL_IMPLEMENATION(C2DRect)
+_MEMORY_POOLED_IMPLEMENTATION(C2DRect)
 
 /**--------------------------------------------------------------------------<BR>
 C2DRect::C2DRect <BR>
@@ -27,7 +27,7 @@ represent the top left and bottom right.
 class GeoLib_API C2DRect : public C2DBase
 {
 public:
-	_MEMORY_POOL_DECLARATION
+	_MEMORY_POOLED_DECLARATION
 
 	/// Constructor.
 	C2DRect(void);
@@ -25,11 +25,13 @@ any modified versions of this cannot be resold to any other party.
 #include "C2DHoledPolygon.h"
 #include "C2DHoledPolygonSet.h"
 #include "C2DLine.h"
+#include "C2DLineArray.h"
 #include "C2DLineBase.h"
 #include "C2DLineBaseSet.h"
 #include "C2DLineBaseSetSet.h"
 #include "C2DLineSet.h"
 #include "C2DPoint.h"
+#include "C2DPointArray.h"
 #include "C2DPointSet.h"
 #include "C2DPolyArc.h"
 #include "C2DPolyArcSet.h"
@@ -11,126 +11,182 @@ heap to speed things up.
 
 #include <vector>
 #include <cstdio>
-
-#if 0
-#define _MEMORY_POOL_DECLARATION_PURE	                                                \
-    virtual void* operator new(unsigned int) = 0;                                       \
-    virtual void* operator new(unsigned int, const char*,int) = 0;                      \
-    virtual void operator delete(void* p) = 0;                                          \
-
-#define _MEMORY_POOL_DECLARATION                                                        \
-    void* operator new(size_t);                                                         \
-    void* operator new(size_t, const char*,int);                                        \
-    void operator delete(void* p);                                                      \
-
-#define _MEMORY_POOL_IMPLEMENATION(_TYPE)                                               \
-    void* _TYPE::operator new(size_t)                                                   \
-    {return CMemoryPool<_TYPE>::Allocate();}                                            \
-    void _TYPE::operator delete(void* p)                                                \
-    {CMemoryPool<_TYPE>::Deallocate(p);}                                                \
-    void* _TYPE::operator new(size_t, const char*,int)                                  \
-    {return CMemoryPool<_TYPE>::Allocate();}                                            \
-
-#define _MEMORY_SIMPLE_IMPLEMENATION(_TYPE)                                             \
-    void* _TYPE::operator new(size_t)                                                   \
-    {return ::new _TYPE;}                                                               \
-    void _TYPE::operator delete(void* p)                                                \
-    {::delete p;}                                                                       \
-    void* _TYPE::operator new(size_t, const char*,int)                                  \
-    {return ::new _TYPE;}                                                               \
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// The original hooks, left empty: the classes using them allocate with the global new.
+#define _MEMORY_POOL_DECLARATION_PURE
+#define _MEMORY_POOL_DECLARATION
+#define _MEMORY_POOL_IMPLEMENATION(_TYPE)
+#define _MEMORY_SIMPLE_IMPLEMENATION(_TYPE)
+
+// Hooks of the classes allocated from a CMemoryPool: put the declaration in the
+// class and the implementation in its .cpp. Define GEOLIB_NO_MEMORY_POOL to turn
+// them off, e.g. to compare against the global new. ReleasePool() frees the
+// blocks of the class, see CMemoryPool::Release(); it is implemented in the .cpp
+// so that it reaches the pool of the library, not a copy in the caller's module.
+#ifndef GEOLIB_NO_MEMORY_POOL
+#define _MEMORY_POOLED_DECLARATION                                                      \
+    static void* operator new(size_t nSize);                                            \
+    static void operator delete(void* p, size_t nSize);                                 \
+    static void* operator new(size_t, void* p) {return p;}                              \
+    static void operator delete(void*, void*) {}                                        \
+    static bool ReleasePool(void);                                                      \
+
+#define _MEMORY_POOLED_IMPLEMENTATION(_TYPE)                                            \
+    void* _TYPE::operator new(size_t nSize)                                             \
+    {return CMemoryPool<_TYPE>::Allocate(nSize);}                                       \
+    void _TYPE::operator delete(void* p, size_t nSize)                                  \
+    {CMemoryPool<_TYPE>::Deallocate(p, nSize);}                                         \
+    bool _TYPE::ReleasePool(void)                                                       \
+    {return CMemoryPool<_TYPE>::Release();}                                             \
 
 #else
-#define _MEMORY_POOL_DECLARATION_PURE	                                              
-#define _MEMORY_POOL_DECLARATION                                                      
-#define _MEMORY_POOL_IMPLEMENATION(_TYPE)                                             
-#define _MEMORY_SIMPLE_IMPLEMENATION(_TYPE)                                           
+#define _MEMORY_POOLED_DECLARATION                                                      \
+    static bool ReleasePool(void) {return true;}                                        \
+
+#define _MEMORY_POOLED_IMPLEMENTATION(_TYPE)
 #endif
 
 
-#define _BLOCK_SIZE 1000 // = 10kb / byte
+/**--------------------------------------------------------------------------<BR>
+CMemoryPool <BR>
+Allocates objects of one type from large blocks, and recycles them.
 
+Each thread allocates from and frees into its own cache, without locking. The
+caches trade free objects with a shared depot in batches, so the one lock is
+taken once per batch at most. Memory stays in the pool until Release().
 
+Allocations of another size, i.e. of a derived class that has no pool of its
+own, are passed on to the global new.
+<P>---------------------------------------------------------------------------*/
 template <class TYPE>
 class CMemoryPool
 {
 public:
-	/// Constructor
-	CMemoryPool(void);
-	/// Destructor
-	~CMemoryPool(void);
-	/// Allocated
-	static void* Allocate(void);
-	/// Deallocate
-	static void Deallocate(void* pData);
-
+	/// Allocates one object.
+	static void* Allocate(size_t nSize = sizeof(TYPE));
+	/// Recycles one object.
+	static void Deallocate(void* pData, size_t nSize = sizeof(TYPE));
+	/// Frees all the blocks if no object is alive. No other thread may use the pool meanwhile.
+	static bool Release(void);
+	/// The blocks taken from the heap so far.
+	static size_t GetBlockCount(void);
+
+	/// Objects per block
+	static const size_t BlockSize = 1024;
+	/// Objects traded between a thread and the depot at a time
+	static const size_t BatchSize = 64;
 
-//	static CMemoryPool<TYPE>& GetInstance(void);
 private:
-
-	void Clear(void);
-
-	void* PAllocate(void);
-	/// Deallocate
-	void PDeallocate(void* pData);
-
-	struct sList
+	union sList
 	{
-		TYPE cObject;
 		sList* pNext;
+		alignas(TYPE) char Object[sizeof(TYPE)];
+	};
+
+	/// A chain of free objects.
+	struct sChain
+	{
+		sList* pHead;
+		size_t nCount;
 	};
 
-	sList* m_pList;
+	/// The free objects of one thread.
+	struct sCache
+	{
+		sCache(bool& bGone);
+		~sCache(void);
 
-	std::vector<char*> m_Blocks;
+		sList* pList;
+		size_t nFree;
+		ptrdiff_t nLive;    ///< Allocated less freed by this thread; may be negative
+		bool& bGone;        ///< Set on destruction
+	};
 
-	static CMemoryPool<TYPE>* m_spInstance;
+	struct sShared
+	{
+		std::mutex Mutex;               ///< Guards everything below
+		std::vector<sChain> Depot;
+		std::vector<char*> Blocks;
+		std::vector<sCache*> Caches;
+		ptrdiff_t nRetiredLive = 0;     ///< nLive of the threads that have exited
+		size_t nBlocks = 0;
+	};
 
-	static unsigned int m_snCount;
+	static sShared& GetShared(void);
+	static sCache* GetCache(void);
+	static void Refill(sList*& pList, size_t& nFree);
+	static void Spill(sCache& Cache);
 };
 
+
 template<class TYPE>
-CMemoryPool<TYPE>* CMemoryPool<TYPE>::m_spInstance = NULL;
+const size_t CMemoryPool<TYPE>::BlockSize;
 
 template<class TYPE>
-unsigned int CMemoryPool<TYPE>::m_snCount = 0;
+const size_t CMemoryPool<TYPE>::BatchSize;
+
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::CMemoryPool <BR>
-Constructor.
+CMemoryPool<TYPE>::GetShared <BR>
+The state shared by all threads. Never destroyed, as objects may be freed
+during static destruction.
 <P>---------------------------------------------------------------------------*/
-CMemoryPool<TYPE>::CMemoryPool(void)
+typename CMemoryPool<TYPE>::sShared& CMemoryPool<TYPE>::GetShared(void)
 {
-	m_pList = NULL;
+	static sShared* pShared = new sShared;
+	return *pShared;
 }
 
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::CMemoryPool <BR>
-Constructor.
+CMemoryPool<TYPE>::GetCache <BR>
+The cache of the calling thread; NULL once the thread is exiting and the
+cache is gone, e.g. while the main thread runs static destructors.
 <P>---------------------------------------------------------------------------*/
-CMemoryPool<TYPE>::~CMemoryPool(void)
+typename CMemoryPool<TYPE>::sCache* CMemoryPool<TYPE>::GetCache(void)
 {
-	Clear();
+	thread_local bool bGone = false;
+	if (bGone)
+		return NULL;
+	thread_local sCache Cache(bGone);
+	return &Cache;
 }
 
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::Clear <BR>
-Clear.
+CMemoryPool<TYPE>::sCache::sCache <BR>
+Constructor registers the cache, for Release().
 <P>---------------------------------------------------------------------------*/
-void CMemoryPool<TYPE>::Clear(void)
+CMemoryPool<TYPE>::sCache::sCache(bool& bGone) : pList(NULL), nFree(0), nLive(0), bGone(bGone)
 {
-	for (unsigned int i = 0; i < m_Blocks.size(); i++)
-	{
-		delete[] m_Blocks[i];
-	}
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
+	Shared.Caches.push_back(this);
+}
 
-	m_Blocks.clear();
 
-	m_pList = NULL;
+template<class TYPE>
+/**--------------------------------------------------------------------------<BR>
+CMemoryPool<TYPE>::sCache::~sCache <BR>
+Destructor hands the free objects of an exiting thread to the depot.
+<P>---------------------------------------------------------------------------*/
+CMemoryPool<TYPE>::sCache::~sCache(void)
+{
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
+	if (pList)
+		Shared.Depot.push_back({ pList, nFree });
+	Shared.nRetiredLive += nLive;
+	Shared.Caches.erase(std::find(Shared.Caches.begin(), Shared.Caches.end(), this));
+	bGone = true;
 }
 
 
@@ -139,89 +195,183 @@ template<class TYPE>
 CMemoryPool<TYPE>::Allocate <BR>
 Allocates memory.
 <P>---------------------------------------------------------------------------*/
-void* CMemoryPool<TYPE>::Allocate(void)
+void* CMemoryPool<TYPE>::Allocate(size_t nSize)
 {
-	if (m_spInstance == NULL)
-		m_spInstance = new CMemoryPool<TYPE>;
+	if (nSize != sizeof(TYPE))
+		return ::operator new(nSize);
+
+	sCache* pCache = GetCache();
+	if (pCache == NULL)
+	{
+		// Take one and give the rest back
+		sList* pList;
+		size_t nFree;
+		Refill(pList, nFree);
+		sShared& Shared = GetShared();
+		std::lock_guard<std::mutex> Lock(Shared.Mutex);
+		if (pList->pNext)
+			Shared.Depot.push_back({ pList->pNext, nFree - 1 });
+		Shared.nRetiredLive++;
+		return pList;
+	}
 
-	m_snCount++;
+	if (pCache->pList == NULL)
+		Refill(pCache->pList, pCache->nFree);
 
-	return m_spInstance->PAllocate();
+	// Take it off the top of the list
+	sList* pList = pCache->pList;
+	pCache->pList = pList->pNext;
+	pCache->nFree--;
+	pCache->nLive++;
+	return pList;
 }
 
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::Allocate <BR>
-Allocates memory.
+CMemoryPool<TYPE>::Deallocate <BR>
+Deallocates/recycles memory.
 <P>---------------------------------------------------------------------------*/
-void CMemoryPool<TYPE>::Deallocate(void* pData)
+void CMemoryPool<TYPE>::Deallocate(void* pData, size_t nSize)
 {
-	if (m_spInstance)
+	if (pData == NULL)
+		return;
+
+	if (nSize != sizeof(TYPE))
 	{
-		m_spInstance->PDeallocate(pData);
-		m_snCount--;
-		if (m_snCount == 0)
-		{
-			delete m_spInstance;
-			m_spInstance = NULL;
-		}
+		::operator delete(pData);
+		return;
+	}
+
+	sList* pList = (sList*)pData;
+	sCache* pCache = GetCache();
+	if (pCache == NULL)
+	{
+		sShared& Shared = GetShared();
+		std::lock_guard<std::mutex> Lock(Shared.Mutex);
+		pList->pNext = NULL;
+		Shared.Depot.push_back({ pList, 1 });
+		Shared.nRetiredLive--;
+		return;
 	}
+
+	// Insert it for reallocation.
+	pList->pNext = pCache->pList;
+	pCache->pList = pList;
+	pCache->nFree++;
+	pCache->nLive--;
+
+	if (pCache->nFree >= 2 * BatchSize)
+		Spill(*pCache);
 }
 
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::Allocate <BR>
-Allocates memory.
+CMemoryPool<TYPE>::Refill <BR>
+Takes a batch from the depot, or from a new block, for an empty cache.
 <P>---------------------------------------------------------------------------*/
-void* CMemoryPool<TYPE>::PAllocate(void)
+void CMemoryPool<TYPE>::Refill(sList*& pList, size_t& nFree)
 {
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
 
-	// If we have no data then create some
-	if (m_pList == NULL)
+	if (!Shared.Depot.empty())
 	{
-		// Create a load of items - just allocate the memory
-	//	sList* pData = new sList[_BLOCK_SIZE];
-
-		char* pData = new char[sizeof(sList) * _BLOCK_SIZE];
-		// Record this for later deletion
-		m_Blocks.push_back(pData);
-		// Create a linked list for allocation
-		sList* pList = (sList*) pData;
-		// Initialise the head
-		m_pList = pList;
-		// Create the linked list
-		for (unsigned int i = 1; i < _BLOCK_SIZE; i++)
+		pList = Shared.Depot.back().pHead;
+		nFree = Shared.Depot.back().nCount;
+		Shared.Depot.pop_back();
+		return;
+	}
+
+	// Create a load of items - just allocate the memory
+	sList* pBlock = (sList*) new char[sizeof(sList) * BlockSize];
+	Shared.Blocks.push_back((char*)pBlock);
+	Shared.nBlocks++;
+
+	// Link it into batches; the first one goes to the cache
+	for (size_t i = 0; i < BlockSize; i += BatchSize)
+	{
+		const size_t nCount = std::min(BatchSize, BlockSize - i);
+		for (size_t j = 0; j + 1 < nCount; j++)
+			pBlock[i + j].pNext = &pBlock[i + j + 1];
+		pBlock[i + nCount - 1].pNext = NULL;
+
+		if (i == 0)
 		{
-		//	pData++;
-			pData += sizeof(sList);
-			pList->pNext = (sList*) pData;
-			pList = pList->pNext;
+			pList = pBlock;
+			nFree = nCount;
+		}
+		else
+		{
+			Shared.Depot.push_back({ &pBlock[i], nCount });
 		}
-		// Terminate the list
-		pList->pNext = NULL;
 	}
-	// Get the return value
-	sList* pList = m_pList;
-	// Take it off the top of the list
-	m_pList = m_pList->pNext;
-	// Return it.
-	return pList;
 }
 
 
 template<class TYPE>
 /**--------------------------------------------------------------------------<BR>
-CMemoryPool<TYPE>::Allocate <BR>
-Deallocates/recycles memory.
+CMemoryPool<TYPE>::Spill <BR>
+Moves a batch from a full cache to the depot.
 <P>---------------------------------------------------------------------------*/
-void CMemoryPool<TYPE>::PDeallocate(void* pData)
+void CMemoryPool<TYPE>::Spill(sCache& Cache)
 {
-	// Cast this to a list entry
-	sList* pList = (sList*)pData;
-	// Insert it for reallocation.
-	pList->pNext = m_pList;
+	sList* pHead = Cache.pList;
+	sList* pLast = pHead;
+	for (size_t i = 1; i < BatchSize; i++)
+		pLast = pLast->pNext;
+	Cache.pList = pLast->pNext;
+	Cache.nFree -= BatchSize;
+	pLast->pNext = NULL;
+
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
+	Shared.Depot.push_back({ pHead, BatchSize });
+}
 
-	m_pList = pList;
+
+template<class TYPE>
+/**--------------------------------------------------------------------------<BR>
+CMemoryPool<TYPE>::Release <BR>
+Frees all the blocks at once, if no object is alive.
+<P>---------------------------------------------------------------------------*/
+bool CMemoryPool<TYPE>::Release(void)
+{
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
+
+	ptrdiff_t nLive = Shared.nRetiredLive;
+	for (size_t i = 0; i < Shared.Caches.size(); i++)
+		nLive += Shared.Caches[i]->nLive;
+	if (nLive != 0)
+		return false;
+
+	for (size_t i = 0; i < Shared.Caches.size(); i++)
+	{
+		Shared.Caches[i]->pList = NULL;
+		Shared.Caches[i]->nFree = 0;
+	}
+
+	for (size_t i = 0; i < Shared.Blocks.size(); i++)
+	{
+		delete[] Shared.Blocks[i];
+	}
+
+	Shared.Blocks.clear();
+	Shared.Depot.clear();
+	return true;
+}
+
+
+template<class TYPE>
+/**--------------------------------------------------------------------------<BR>
+CMemoryPool<TYPE>::GetBlockCount <BR>
+The blocks taken from the heap so far, released or not.
+<P>---------------------------------------------------------------------------*/
+size_t CMemoryPool<TYPE>::GetBlockCount(void)
+{
+	sShared& Shared = GetShared();
+	std::lock_guard<std::mutex> Lock(Shared.Mutex);
+	return Shared.nBlocks;
 }
@@ -4,6 +4,7 @@
 #include <vvr/scene.h>
 #include <vvr/mesh.h>
 #include <vvr/palette.h>
+#include <vvr/bvh.h>
 #include <iostream>
 #include <fstream>
 #include <iostream>
@@ -11,8 +12,15 @@
 #include <string>
 #include <set>
 #include <vector>
+#include <memory>
 #include <MathGeoLib.h>
 
+/*--------------------------------------------------------------------------------------*/
+static const vvr::Colour Pallete[6] = {
+    vvr::red, vvr::green, vvr::blue, vvr::magenta,
+    vvr::orange, vvr::yellow,
+};
+
 /*--------------------------------------------------------------------------------------*/
 class BoxesScene : public vvr::Scene
 {
@@ -23,7 +31,11 @@ public:
     void resize() override;
     void keyEvent(unsigned char key, bool up, int modif) override;
     void setBoxFromCurrentView();
+    void createField();
     vvr::Canvas     mCanvas;
+    vvr::CullingGroup mField;
+    std::vector<std::unique_ptr<vvr::Aabb3D>> mFieldBoxes;
+    bool            mShowField;
     vvr::Aabb3D*    mAabb1;
     vvr::Aabb3D*    mAabb2;
     vvr::Obb3D*     mBox;
@@ -34,6 +46,7 @@ BoxesScene::BoxesScene()
     m_bg_col = vvr::Colour("768E77");
     m_perspective_proj = false;
     m_fullscreen = false;
+    mShowField = false;
     mBox = new vvr::Obb3D();
     mAabb1 = new vvr::Aabb3D(0, 0, 0, 10, 10, 10, vvr::red);
     mAabb2 = new vvr::Aabb3D(-10, -10, -10, 5, 5, 5, vvr::green);
@@ -52,6 +65,26 @@ void BoxesScene::resize()
         mCanvas.add(mAabb2)->hide();
         mCanvas.add(mBox)->show();
         setBoxFromCurrentView();
+        createField();
+    }
+}
+
+void BoxesScene::createField()
+{
+    //! A large grid of boxes, most of which are off screen when zoomed in.
+    const int n = 16;
+    const float step = getSceneWidth() / n;
+    const float size = step / 3;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+                const vec lo = vec(i, j, k) * step - vec(n * step / 2, n * step / 2, n * step / 2);
+                vvr::Aabb3D *box = new vvr::Aabb3D(lo.x, lo.y, lo.z,
+                    lo.x + size, lo.y + size, lo.z + size, Pallete[(i + j + k) % 6]);
+                mFieldBoxes.emplace_back(box);
+                mField.add(box);
+            }
+        }
     }
 }
 
@@ -59,6 +92,7 @@ void BoxesScene::draw()
 {
     getGlobalAxes().drawif();
     mCanvas.draw();
+    if (mShowField) drawCulled(mField);
 }
 
 void BoxesScene::setBoxFromCurrentView()
@@ -87,6 +121,10 @@ void BoxesScene::keyEvent(unsigned char key, bool up, int modif)
         mAabb2->toggle();
         break;
 
+    case 'f':
+        mShowField = !mShowField;
+        break;
+
     case 'o':
         mBox->toggle();
 
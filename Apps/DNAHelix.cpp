@@ -31,6 +31,7 @@ private:
     float m_c;
     double m_sec;
     vvr::Animation m_anim;
+    vvr::InstanceBatch m_spheres;
 };
 
 /*--------------------------------------------------------------------------------------*/
@@ -57,6 +58,8 @@ void HelixScene::draw()
     const float degs_from = 360 * 2;
     const double phase = m_anim.t();
 
+    m_spheres.clear();
+
     for (float degs = -degs_from; degs < degs_from; degs += 10)
     {
         const float t = DegToRad(phase + degs);
@@ -66,17 +69,19 @@ void HelixScene::draw()
         p[0].y = m_c * t;
         vvr::Sphere3D s1(p[0].x, p[0].y, p[0].z, m_r / 8, vvr::darkRed);
         s1.filled = true;
-        s1.draw();
+        m_spheres.add(s1);
 
         p[1].x = m_r * Cos(phase + t + DegToRad(90 * 2));
         p[1].z = m_r * Sin(phase + t + DegToRad(90 * 2));
         p[1].y = m_c * t;
         vvr::Sphere3D s2(p[1].x, p[1].y, p[1].z, m_r / 8, vvr::darkGreen);
         s2.filled = true;
-        s2.draw();
+        m_spheres.add(s2);
 
         vvr::LineSeg3D(p[0].x, p[0].y, p[0].z, p[1].x, p[1].y, p[1].z, vvr::Colour(34, 34, 34)).draw();
     }
+
+    m_spheres.draw();
 }
 
 bool HelixScene::idle()
@@ -3,18 +3,63 @@
 #include <vvr/settings.h>
 #include <vvr/animation.h>
 #include <vvr/scene.h>
+#include <vvr/fft.h>
 #include <GeoLib.h>
 #include <MathGeoLib.h>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#define FOURIER_CONTOURS "resources/contours/contours.txt"
 
 struct Fcomp
 {
-    double l;
-    double w;
+    double l;   // Radius, curve units
+    double w;   // Degrees per second
+    double ph;  // Phase, radians
 };
 
+/**
+ * Epicycles tracing a closed curve: the curve is resampled uniformly by arc
+ * length and transformed as x + iy; every bin is a circle turning at its own
+ * frequency. The largest ones come first, after the constant term.
+ */
+static std::vector<Fcomp> epicycles(const std::vector<C2DPoint> &pts, size_t samples, double period)
+{
+    std::vector<Fcomp> fc;
+    if (pts.size() < 2) return fc;
+
+    std::vector<double> dist(pts.size() + 1, 0);
+    for (size_t i = 0; i < pts.size(); i++) {
+        dist[i + 1] = dist[i] + pts[i].Distance(pts[(i + 1) % pts.size()]);
+    }
+    if (dist.back() <= 0) return fc;
+
+    vvr::dsp::Spectrum z(samples);
+    for (size_t k = 0, i = 0; k < samples; k++) {
+        const double s = dist.back() * k / samples;
+        while (dist[i + 1] < s) i++;
+        const C2DPoint &a = pts[i];
+        const C2DPoint &b = pts[(i + 1) % pts.size()];
+        const double len = dist[i + 1] - dist[i];
+        const double t = len > 0 ? (s - dist[i]) / len : 0;
+        z[k] = vvr::dsp::Complex(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y));
+    }
+
+    const vvr::dsp::Spectrum Z = vvr::dsp::fft(z);
+    for (size_t k = 0; k < samples; k++) {
+        const double f = k <= samples / 2 ? (double)k : (double)k - samples;
+        const vvr::dsp::Complex c = Z[k] / (double)samples;
+        fc.push_back({ std::abs(c), f * 360 / period, std::arg(c) });
+    }
+    std::sort(fc.begin() + 1, fc.end(), [](const Fcomp &a, const Fcomp &b) { return a.l > b.l; });
+    return fc;
+}
+
 struct FourierScene : public vvr::Scene
 {
     FourierScene();
@@ -22,15 +67,31 @@ private:
     const char* getName() const override { return "Fourier Series Animation"; }
     void draw() override;
     void reset() override;
+    void resize() override;
     bool idle() override;
     void mousePressed(int x, int y, int modif) override;
     void mouseMoved(int x, int y, int modif) override;
+    void mouseReleased(int x, int y, int modif) override;
     void mouseWheel(int dir, int modif) override;
     void arrowEvent(vvr::ArrowDir dir, int modif) override;
+    void loadContours(const std::string &filename);
+    void setCurve(std::vector<C2DPoint> pts);
+    void setComponents(size_t num);
     vvr::Animation m_anim;
     vvr::Canvas m_lines;
+    vvr::Canvas m_circles;
     vvr::Canvas m_trace;
+    vvr::Canvas m_curve;
     std::vector<Fcomp> fc;
+    std::vector<Fcomp> m_coeffs;
+    std::vector<C2DPoint> m_pts;            // Normalized curve
+    std::vector<std::vector<C2DPoint>> m_contours;
+    std::vector<C2DPoint> m_drawn;
+    size_t m_contour;
+    size_t m_num;
+    double m_scale;
+    double m_period;
+    int m_cycle;
 };
 
 FourierScene::FourierScene()
@@ -38,27 +99,119 @@ FourierScene::FourierScene()
     vvr::Shape::PointSize = 2;
     vvr::Shape::LineWidth = 1.5;
     m_bg_col = vvr::grey;
-    fc.push_back({  10,   25 });
-    fc.push_back({ 150,   50 });
-    fc.push_back({  50,  150 });
-    fc.push_back({  15,  600 });
-    for (auto i=0; i<fc.size(); i++) {
-        m_lines.add(new vvr::LineSeg2D);
+    m_scale = 250;
+    m_period = 10;
+    m_num = 50;
+    m_contour = 0;
+    loadContours(vvr::get_base_path() + FOURIER_CONTOURS);
+
+    if (!m_contours.empty()) {
+        setCurve(m_contours[m_contour]);
+    }
+    else {
+        fc.push_back({  10 / 225.0,   25, 0 });
+        fc.push_back({ 150 / 225.0,   50, 0 });
+        fc.push_back({  50 / 225.0,  150, 0 });
+        fc.push_back({  15 / 225.0,  600, 0 });
+        m_coeffs = fc;
+        setComponents(fc.size());
     }
     reset();
 }
 
+void FourierScene::loadContours(const std::string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "r");
+    if (!file) {
+        std::cerr << "Could not open " << filename << std::endl;
+        return;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "CONTOUR-LINE", 12) == 0) {
+            m_contours.emplace_back();
+            continue;
+        }
+        float x, y;
+        if (!m_contours.empty() && sscanf(line, "%f %f", &x, &y) == 2) {
+            m_contours.back().push_back(C2DPoint(x, y));
+        }
+    }
+    fclose(file);
+
+    m_contours.erase(std::remove_if(m_contours.begin(), m_contours.end(),
+        [](const std::vector<C2DPoint> &c) { return c.size() < 3; }), m_contours.end());
+}
+
+void FourierScene::setCurve(std::vector<C2DPoint> pts)
+{
+    //! Centered on the origin, within the unit circle.
+    C2DPoint c(0, 0);
+    for (const C2DPoint &p : pts) { c.x += p.x; c.y += p.y; }
+    c.x /= pts.size();
+    c.y /= pts.size();
+    double r = 0;
+    for (const C2DPoint &p : pts) r = std::max(r, p.Distance(c));
+    if (r <= 0) return;
+    for (C2DPoint &p : pts) p = C2DPoint((p.x - c.x) / r, (p.y - c.y) / r);
+
+    m_pts = pts;
+    m_coeffs = epicycles(m_pts, 256, m_period);
+    setComponents(m_num);
+}
+
+void FourierScene::setComponents(size_t num)
+{
+    if (m_coeffs.empty()) return;
+    m_num = std::max<size_t>(1, std::min(num, m_coeffs.size()));
+    fc.assign(m_coeffs.begin(), m_coeffs.begin() + m_num);
+
+    m_lines.clear();
+    m_circles.clear();
+    for (size_t i = 0; i < fc.size(); i++) {
+        m_lines.add(new vvr::LineSeg2D);
+        m_circles.add(new vvr::Circle2D(0, 0, 1, vvr::DarkGray));
+    }
+
+    m_curve.clear();
+    for (size_t i = 0; i < m_pts.size(); i++) {
+        const C2DPoint &a = m_pts[i];
+        const C2DPoint &b = m_pts[(i + 1) % m_pts.size()];
+        m_curve.add(new vvr::LineSeg2D(a.x * m_scale, a.y * m_scale, b.x * m_scale, b.y * m_scale, vvr::white));
+    }
+
+    m_trace.clear();
+}
+
 void FourierScene::reset()
 {
     std::cout << "Reset" << std::endl;
     vvr::Scene::reset();
     m_trace.clear();
     m_anim.reset();
+    m_cycle = 0;
+}
+
+void FourierScene::resize()
+{
+    vvr::Scene::resize();
+
+    if (m_first_resize) {
+        std::cout << "Drag the mouse to draw a closed curve." << std::endl;
+        std::cout << "Press 'up'/'down' for more/fewer epicycles." << std::endl;
+        std::cout << "Press 'left'/'right' to change contour." << std::endl;
+    }
+
+    m_scale = 0.4 * std::min(getViewportWidth(), getViewportHeight());
+    setComponents(m_num);
 }
 
 void FourierScene::draw()
 {
     enterPixelMode();
+    m_curve.draw();
+    m_circles.draw();
     m_trace.draw();
     m_lines.draw();
     exitPixelMode();
@@ -68,14 +221,25 @@ bool FourierScene::idle()
 {
     m_anim.update(true);
     const float t = m_anim.t();
+
+    //! One period draws the whole curve; start over on the next.
+    const int cycle = (int)std::floor(t / m_period);
+    if (cycle != m_cycle) {
+        m_cycle = cycle;
+        m_trace.clear();
+    }
+
     C2DVector e(0, 0);
     size_t i = 0;
 
     for (vvr::Drawable *d : m_lines.getDrawables())
     {
         auto &ln = *static_cast<vvr::LineSeg2D*>(d);
-        C2DVector v(fc[i].l, 0);
-        v.TurnLeft(t * math::DegToRad(fc[i].w));
+        auto &cr = *static_cast<vvr::Circle2D*>(m_circles.getDrawables()[i]);
+        const double a = fc[i].ph + t * math::DegToRad(fc[i].w);
+        const C2DVector v(m_scale * fc[i].l * cos(a), m_scale * fc[i].l * sin(a));
+        cr.SetCentre(C2DPoint(e.i, e.j));
+        cr.SetRadius(m_scale * fc[i].l);
         ln.x1 = e.i; ln.y1 = e.j; e += v;
         ln.x2 = e.i; ln.y2 = e.j;
         ++i;
@@ -87,10 +251,23 @@ bool FourierScene::idle()
 
 void FourierScene::mousePressed(int x, int y, int modif)
 {
+    m_drawn.clear();
+    m_drawn.push_back(C2DPoint(x, y));
 }
 
 void FourierScene::mouseMoved(int x, int y, int modif)
 {
+    //! Every sample since the last frame, not just the latest.
+    for (const vvr::InputEvent &e : getMotionSamples()) {
+        m_drawn.push_back(C2DPoint(e.x, e.y));
+    }
+}
+
+void FourierScene::mouseReleased(int x, int y, int modif)
+{
+    if (m_drawn.size() < 8) return;
+    setCurve(m_drawn);
+    reset();
 }
 
 void FourierScene::mouseWheel(int dir, int modif)
@@ -102,6 +279,25 @@ void FourierScene::mouseWheel(int dir, int modif)
 
 void FourierScene::arrowEvent(vvr::ArrowDir dir, int modif)
 {
+    switch (dir) {
+    case vvr::UP:
+        setComponents(m_num + std::max<size_t>(1, m_num / 4));
+        std::cout << fc.size() << " of " << m_coeffs.size() << " epicycles" << std::endl;
+        break;
+    case vvr::DOWN:
+        setComponents(m_num - std::max<size_t>(1, m_num / 5));
+        std::cout << fc.size() << " of " << m_coeffs.size() << " epicycles" << std::endl;
+        break;
+    case vvr::LEFT:
+    case vvr::RIGHT:
+        if (m_contours.empty()) break;
+        m_contour = (m_contour + (dir == vvr::RIGHT ? 1 : m_contours.size() - 1)) % m_contours.size();
+        setCurve(m_contours[m_contour]);
+        reset();
+        break;
+    default:
+        break;
+    }
 }
 
 /*---[Invoke]---------------------------------------------------------------------------*/
@@ -160,6 +160,10 @@ void Simple3DScene::load3DModels()
     m_mesh_1->update();
     m_mesh_2->update();
     m_mesh_3->update();
+
+    for (auto mesh : { m_mesh_1, m_mesh_2, m_mesh_3 }) {
+        mesh->buildLods(3);
+    }
 }
 
 void Simple3DScene::draw()
@@ -169,8 +173,8 @@ void Simple3DScene::draw()
     //! Draw meshes
     for (auto mesh : { m_mesh_1, m_mesh_2, m_mesh_3 })
     {
-        if (m_style_flag & FLAG_SHOW_SOLID) mesh->draw(m_obj_col, vvr::SOLID);
-        if (m_style_flag & FLAG_SHOW_WIRE) mesh->draw(vvr::black, vvr::WIRE);
+        if (m_style_flag & FLAG_SHOW_SOLID) mesh->draw(m_obj_col, vvr::SOLID, getFrustum());
+        if (m_style_flag & FLAG_SHOW_WIRE) mesh->draw(vvr::black, vvr::WIRE, getFrustum());
         if (m_style_flag & FLAG_SHOW_NORMALS) mesh->draw(vvr::black, vvr::NORMALS);
         if (m_style_flag & FLAG_SHOW_AXES) mesh->draw(vvr::black, vvr::AXES);
         if (m_style_flag & FLAG_SHOW_AABB) mesh->draw(vvr::black, vvr::BOUND);
@@ -1,4 +1,6 @@
 #include <vvr/bspline.h>
+#include <vvr/curve.h>
+#include <vvr/bvh.h>
 #include <vvr/scene.h>
 #include <vvr/utils.h>
 #include <vvr/drawing.h>
@@ -20,59 +22,61 @@
 namespace vvr
 {
     /*---[Curve3D]----------------------------------------------------------------------*/
+    /**
+     * Draws and picks any curve that has a CurveSampler. The samples and a
+     * hierarchy over their segments are rebuilt only when the curve changes.
+     */
     template<typename T>
     struct Curve3D : public Drawable
     {
         typedef T curve_t;
-        typedef typename curve_t::point_t point_t;
+        typedef CurveSampler<curve_t> sampler_t;
 
         Curve3D(curve_t &curve) : curve(curve) {}
 
-        /**
-         * @TODO Make a template from this, giving the potential to specialize
-         *  for curves that need special treatment in discretization.
-         *  e.g.: Hilbert curve, or a simple polyline with known number of pts.
-         */
-        void discretize(size_t num_pts) const
+        void discretize() const
         {
-            if (num_pts<2) num_pts = 2;
-            auto range = curve.range();
-            double dt = (range.second - range.first) / (num_pts - 1);
-            pts.resize(num_pts);
-            for (size_t i = 0; i < num_pts; i++) {
-                pts[i] = curve.eval(range.first + dt * i);
-            }
+            const unsigned r = sampler_t::revision(curve);
+            CurveSampling cs = sampling;
+            cs.tolerance = tolerance * pixel_size;
+            if (r == rev && cs.tolerance == tol && !pts.empty()) return;
+            rev = r;
+            tol = cs.tolerance;
+            sampler_t::sample(curve, cs, pts);
+            bvh.build(pts.data(), pts.size());
         }
 
         void draw() const override
         {
-            discretize(32);
+            discretize();
+            if (pts.empty()) return;
             for (auto it = pts.begin(); it < pts.end() - 1; ++it) {
                 LineSeg3D(math::LineSegment(it[0], it[1]), colour).draw();
-                if (disp_pts) it->draw();
+                if (disp_pts) Point3D(*it).draw();
             }
-            if (disp_pts) pts.back().draw();
+            if (disp_pts) Point3D(pts.back()).draw();
         }
 
         real pickdist(int x, int y) const override
         {
-            vec p(x,y,0);
+            discretize();
             const real maxdsq = vvr_square(vvr::Shape::PointSize);
-            real d = std::numeric_limits<real>::max();
-            for (size_t i=0; i<pts.size()-1; ++i) {
-                math::LineSegment ls(pts[i], pts[i+1]);
-                d = std::min(d, ls.DistanceSq(p));
-            }
-            return ((d < maxdsq) ? d: -1);
+            return bvh.closest(vec(x, y, 0), maxdsq);
         }
 
     public:
         Colour colour;
         bool disp_pts = false;
+        real tolerance = 0.25;      ///< Max distance of the drawn curve from the true one, in pixels
+        real pixel_size = 1;        ///< Curve units per pixel
+        CurveSampling sampling;
 
     private:
         curve_t &curve;
-        mutable std::vector<point_t> pts;
+        mutable std::vector<vec> pts;
+        mutable PolylineBvh bvh;
+        mutable unsigned rev = 0;
+        mutable real tol = 0;
     };
 
     /*---[CurveBsp]---------------------------------------------------------------------*/
@@ -0,0 +1,129 @@
+#include <pixel_convert.h>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+/*---[NdiViewer pixel conversion]-------------------------------------------------------*/
+namespace {
+
+    const int Width = 1920;
+    const int Height = 1080;
+
+    //! A random 1080p frame in `layout`, planes one after the other as NDI sends them.
+    struct Frame
+    {
+        std::vector<uint8_t> src, dst;
+        ConvertJob job;
+
+        Frame(PixelLayout layout, RgbOrder order, ConvertIsa isa, DstLayout dstLayout = DstLayout::Rgb)
+            : src((size_t)Width * Height * 4), dst((size_t)Width * Height * 4)
+        {
+            std::mt19937 gen(7);
+            for (auto &b : src) b = (uint8_t)gen();
+
+            const uint8_t *p = src.data();
+            const int w = Width, h = Height;
+            switch (layout) {
+            case PixelLayout::UYVY: job.planes[0] = { p, w * 2, h }; break;
+            case PixelLayout::UYVA: job.planes[0] = { p, w * 2, h }; job.planes[1] = { p + w * 2 * h, w, h }; break;
+            case PixelLayout::NV12: job.planes[0] = { p, w, h }; job.planes[1] = { p + w * h, w, h / 2 }; break;
+            case PixelLayout::YV12:
+                job.planes[0] = { p, w, h };
+                job.planes[1] = { p + w * h, w / 2, h / 2 };
+                job.planes[2] = { p + w * h * 5 / 4, w / 2, h / 2 };
+                break;
+            case PixelLayout::P216: job.planes[0] = { p, w * 2, h }; job.planes[1] = { p + w * 2 * h, w * 2, h }; break;
+            default: job.planes[0] = { p, w * 4, h }; break;
+            }
+
+            job.layout = layout;
+            job.width = w;
+            job.height = h;
+            job.dst = dst.data();
+            job.dstStride = w * 4;
+            job.order = order;
+            job.isa = isa;
+
+            //! Y, then UV, each with P016's two bytes per sample
+            job.dstLayout = dstLayout;
+            if (dstLayout != DstLayout::Rgb) {
+                const int bytes = dstLayout == DstLayout::P016 ? 2 : 1;
+                job.dstStride = w * bytes;
+                job.dstUv = dst.data() + (size_t)w * h * 2;
+                job.dstUvStride = w * bytes;
+            }
+        }
+    };
+
+    const char *layoutNames[] = { "UYVY", "UYVA", "NV12", "YV12", "P216", "BGRA", "BGRX", "RGBA", "RGBX" };
+    const char *dstLayoutNames[] = { "RGB", "NV12", "P016" };
+
+    //! Every YUV layout and planar target that convert, on every instruction set
+    void planarArgs(benchmark::internal::Benchmark *b)
+    {
+        for (int layout = 0; layout <= (int)PixelLayout::P216; layout++)
+            for (int dst = (int)DstLayout::NV12; dst <= (int)DstLayout::P016; dst++)
+                if (canConvert((PixelLayout)layout, (DstLayout)dst))
+                    for (int isa = 0; isa <= (int)ConvertIsa::AVX2; isa++) b->Args({ layout, dst, isa });
+    }
+
+}
+
+//! Args: layout, output order, instruction set
+static void BM_PixelConvert(benchmark::State &state)
+{
+    const ConvertIsa isa = (ConvertIsa)state.range(2);
+    if (isa > bestConvertIsa()) {
+        state.SkipWithError("Instruction set not supported by this CPU");
+        return;
+    }
+
+    Frame f((PixelLayout)state.range(0), (RgbOrder)state.range(1), isa);
+    for (auto _ : state) {
+        convertRows(f.job, 0, Height);
+        benchmark::DoNotOptimize(f.dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(std::string(layoutNames[state.range(0)]) + (state.range(1) ? "->RGBA " : "->BGRA ") + convertIsaName(isa));
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+    state.SetBytesProcessed(state.iterations() * Width * Height * 4);
+}
+BENCHMARK(BM_PixelConvert)->ArgsProduct({ benchmark::CreateDenseRange(0, 8, 1), { 0, 1 }, { 0, 1, 2 } })
+    ->Unit(benchmark::kMicrosecond);
+
+//! Args: layout, planar target, instruction set
+static void BM_PixelConvertPlanar(benchmark::State &state)
+{
+    const ConvertIsa isa = (ConvertIsa)state.range(2);
+    if (isa > bestConvertIsa()) {
+        state.SkipWithError("Instruction set not supported by this CPU");
+        return;
+    }
+
+    const DstLayout dstLayout = (DstLayout)state.range(1);
+    Frame f((PixelLayout)state.range(0), RgbOrder::BGRA, isa, dstLayout);
+    for (auto _ : state) {
+        convertRows(f.job, 0, Height);
+        benchmark::DoNotOptimize(f.dst.data());
+        benchmark::ClobberMemory();
+    }
+    const int bytes = dstLayout == DstLayout::P016 ? 2 : 1;
+    state.SetLabel(std::string(layoutNames[state.range(0)]) + "->" + dstLayoutNames[state.range(1)] + " " + convertIsaName(isa));
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+    state.SetBytesProcessed(state.iterations() * Width * Height * 3 / 2 * bytes);
+}
+BENCHMARK(BM_PixelConvertPlanar)->Apply(planarArgs)->Unit(benchmark::kMicrosecond);
+
+//! UYVY to BGRA, best instruction set, in row bands on that many threads
+static void BM_PixelConvertBands(benchmark::State &state)
+{
+    Frame f(PixelLayout::UYVY, RgbOrder::BGRA, ConvertIsa::Best);
+    for (auto _ : state) {
+        convert(f.job, (int)state.range(0));
+        benchmark::DoNotOptimize(f.dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+    state.SetBytesProcessed(state.iterations() * Width * Height * 4);
+}
+BENCHMARK(BM_PixelConvertBands)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMicrosecond);
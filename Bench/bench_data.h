@@ -0,0 +1,110 @@
+#ifndef VVR_BENCH_DATA_H
+#define VVR_BENCH_DATA_H
+
+#include <vvr/dsp.h>
+#include <vvr/utils.h>
+#include <MathGeoLib.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic data generators and resource fixtures shared by the benchmarks.
+ * Everything is seeded, so that runs of different builds see the same inputs.
+ */
+namespace vvr { namespace bench {
+
+    inline std::string resource(const std::string &relpath)
+    {
+        return vvr::get_base_path() + "resources/" + relpath;
+    }
+
+    inline std::vector<math::vec> random_points(size_t n, unsigned seed = 7, float extent = 100)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> u(-extent, extent);
+        std::vector<math::vec> pts(n);
+        for (auto &p : pts) p = math::vec(u(gen), u(gen), u(gen));
+        return pts;
+    }
+
+    template <typename point>
+    std::vector<point> random_points_2d(size_t n, unsigned seed = 7, float extent = 100)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> u(-extent, extent);
+        std::vector<point> pts(n);
+        for (auto &p : pts) { p.x = u(gen); p.y = u(gen); }
+        return pts;
+    }
+
+    //! Points on a circle: the worst case for hull sizes.
+    template <typename point>
+    std::vector<point> circle_points_2d(size_t n, float radius = 100)
+    {
+        std::vector<point> pts(n);
+        for (size_t i = 0; i < n; i++) {
+            const double a = 2 * 3.14159265358979 * i / n;
+            pts[i].x = (float)(radius * cos(a));
+            pts[i].y = (float)(radius * sin(a));
+        }
+        return pts;
+    }
+
+    //! Sum of sines plus gaussian noise and a few spikes.
+    inline dsp::Signal noisy_signal(size_t n, unsigned seed = 7)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<double> noise(0, 0.1);
+        dsp::Signal s(n);
+        for (size_t i = 0; i < n; i++) {
+            s[i] = sin(i * 0.01) + 0.5 * sin(i * 0.037) + noise(gen);
+            if (i % 997 == 0) s[i] += 3;
+        }
+        return s;
+    }
+
+    //! Same format as the ContourEditor app.
+    inline std::vector<std::vector<math::vec>> load_contours(const std::string &filename)
+    {
+        std::vector<std::vector<math::vec>> contours;
+        FILE *file = fopen(filename.c_str(), "r");
+        if (!file) return contours;
+        char line[1024];
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, "CONTOUR-LINE", 12) == 0) {
+                contours.emplace_back();
+                continue;
+            }
+            float x, y;
+            if (!contours.empty() && sscanf(line, "%f %f", &x, &y) == 2) {
+                contours.back().push_back(math::vec(x, y, 0));
+            }
+        }
+        fclose(file);
+        return contours;
+    }
+
+    /**
+     * Silences std::cout for its lifetime; some library code reports timings itself.
+     * Keep it outside of what the benchmark reporter prints.
+     */
+    class QuietCout
+    {
+        struct NullBuf : std::streambuf {
+            int overflow(int c) override { return c; }
+        } m_null;
+        std::streambuf *m_old;
+    public:
+        QuietCout() : m_old(std::cout.rdbuf(&m_null)) { }
+        ~QuietCout() { std::cout.rdbuf(m_old); }
+    };
+
+}}
+
+#endif
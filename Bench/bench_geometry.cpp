@@ -0,0 +1,237 @@
+#include "bench_data.h"
+#include <GeoLib.h>
+#include <vvr/geom.h>
+#include <vvr/kdtree.h>
+#include <vvr/bvh.h>
+#include <benchmark/benchmark.h>
+
+using namespace vvr::bench;
+
+/*---[KD-Tree]--------------------------------------------------------------------------*/
+static void BM_KDTreeBuild(benchmark::State &state)
+{
+    const math::VecArray src = random_points(state.range(0));
+    QuietCout quiet; // KDTree reports its own timings
+    for (auto _ : state) {
+        state.PauseTiming();
+        math::VecArray pts(src);
+        state.ResumeTiming();
+        vvr::KDTree tree(pts);
+        benchmark::DoNotOptimize(tree.root());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KDTreeBuild)->RangeMultiplier(4)->Range(1 << 10, 1 << 18)->Unit(benchmark::kMillisecond);
+
+/*---[Polyline picking]-----------------------------------------------------------------*/
+//! Closest segment of a random walk, as Curve3D::pickdist() does.
+static void BM_PolylineClosest(benchmark::State &state)
+{
+    const std::vector<math::vec> steps = random_points(state.range(0));
+    std::vector<math::vec> pts(1, math::vec::zero);
+    for (const math::vec &s : steps) pts.push_back(pts.back() + s * 0.05f);
+    const std::vector<math::vec> queries = random_points(256, 11, 20);
+    vvr::PolylineBvh bvh;
+    bvh.build(pts.data(), pts.size());
+    for (auto _ : state) {
+        for (const math::vec &q : queries) {
+            benchmark::DoNotOptimize(bvh.closest(q, 4.0f));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_PolylineClosest)->RangeMultiplier(4)->Range(1 << 6, 1 << 16)->Complexity(benchmark::oLogN);
+
+/*---[Convex hull]----------------------------------------------------------------------*/
+static void BM_ConvexHull(benchmark::State &state)
+{
+    const auto pts = random_points_2d<math::float2>(state.range(0));
+    for (auto _ : state) {
+        auto hull = vvr::convex_hull(pts);
+        benchmark::DoNotOptimize(hull.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ConvexHull)->RangeMultiplier(4)->Range(1 << 8, 1 << 20)->Complexity(benchmark::oNLogN);
+
+static void BM_ConvexDiameter(benchmark::State &state)
+{
+    const auto hull = vvr::convex_hull(circle_points_2d<math::float2>(state.range(0)));
+    size_t i1 = 0, i2 = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(vvr::convex_diameter(hull, i1, i2));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ConvexDiameter)->RangeMultiplier(4)->Range(1 << 6, 1 << 16)->Complexity(benchmark::oN);
+
+static void BM_ConvexWidth(benchmark::State &state)
+{
+    const auto hull = vvr::convex_hull(circle_points_2d<math::float2>(state.range(0)));
+    size_t i1 = 0, i2 = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(vvr::convex_width(hull, i1, i2));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ConvexWidth)->RangeMultiplier(4)->Range(1 << 6, 1 << 16)->Complexity(benchmark::oN);
+
+//! Hulls of the contour lines of a real terrain.
+static void BM_ConvexHullContours(benchmark::State &state)
+{
+    const auto contours = load_contours(resource("contours/contoursHuge.txt"));
+    if (contours.empty()) {
+        state.SkipWithError("contoursHuge.txt not found");
+        return;
+    }
+    std::vector<std::vector<math::float2>> lines;
+    size_t n = 0;
+    for (const auto &c : contours) {
+        lines.emplace_back();
+        for (const auto &v : c) lines.back().push_back(math::float2(v.x, v.y));
+        n += c.size();
+    }
+    for (auto _ : state) {
+        for (const auto &line : lines) {
+            auto hull = vvr::convex_hull(line);
+            benchmark::DoNotOptimize(hull.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ConvexHullContours);
+
+/*---[GeoLib]---------------------------------------------------------------------------*/
+static void BM_RemoveRepeatedPoints(benchmark::State &state)
+{
+    //! A quarter of the points are duplicates.
+    const auto pts = random_points_2d<math::float2>(state.range(0) * 3 / 4);
+    for (auto _ : state) {
+        state.PauseTiming();
+        C2DPointSet set;
+        for (size_t i = 0; i < (size_t)state.range(0); i++) {
+            const auto &p = pts[i % pts.size()];
+            set.AddCopy(p.x, p.y);
+        }
+        state.ResumeTiming();
+        set.RemoveRepeatedPoints();
+        benchmark::DoNotOptimize(set.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RemoveRepeatedPoints)->RangeMultiplier(4)->Range(1 << 8, 1 << 16)->Complexity();
+
+static void BM_PolygonContains(benchmark::State &state)
+{
+    srand(7);
+    C2DPolygon poly;
+    poly.CreateRandom(C2DRect(-100, 100, 100, -100), state.range(0), state.range(0));
+    const auto queries = random_points_2d<math::float2>(1024, 11);
+    for (auto _ : state) {
+        int inside = 0;
+        for (const auto &q : queries) inside += poly.Contains(C2DPoint(q.x, q.y));
+        benchmark::DoNotOptimize(inside);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_PolygonContains)->RangeMultiplier(4)->Range(16, 4096);
+
+static void BM_PolygonUnion(benchmark::State &state)
+{
+    srand(7);
+    C2DPolygon a, b;
+    a.CreateRandom(C2DRect(-100, 100, 60, -60), state.range(0), state.range(0));
+    b.CreateRandom(C2DRect(-60, 60, 100, -100), state.range(0), state.range(0));
+    for (auto _ : state) {
+        C2DHoledPolygonSet result;
+        a.GetUnion(b, result, CGrid::DynamicGrid);
+        benchmark::DoNotOptimize(result.size());
+    }
+}
+BENCHMARK(BM_PolygonUnion)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMicrosecond);
+
+/*---[GeoLib point containers]----------------------------------------------------------*/
+//! Arg 1 picks the container: C2DPointSet (0), or C2DPointArray (1).
+namespace {
+
+    struct Points
+    {
+        C2DPointSet set;
+        C2DPointArray array;
+
+        explicit Points(size_t n)
+        {
+            for (const auto &p : random_points_2d<math::float2>(n)) set.AddCopy(p.x, p.y);
+            array.MakeCopy(set);
+        }
+    };
+
+    void label_container(benchmark::State &state)
+    {
+        state.SetLabel(state.range(1) ? "array" : "set");
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+}
+
+static void BM_PointsBoundingRect(benchmark::State &state)
+{
+    Points pts(state.range(0));
+    C2DRect rect;
+    for (auto _ : state) {
+        if (state.range(1)) pts.array.GetBoundingRect(rect);
+        else pts.set.GetBoundingRect(rect);
+        benchmark::DoNotOptimize(rect);
+    }
+    label_container(state);
+}
+BENCHMARK(BM_PointsBoundingRect)->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 18, 8), { 0, 1 } });
+
+static void BM_PointsSortLeftToRight(benchmark::State &state)
+{
+    Points pts(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        C2DPointSet set;
+        C2DPointArray array;
+        if (state.range(1)) array = pts.array;
+        else set.AddCopy(pts.set);
+        state.ResumeTiming();
+        if (state.range(1)) array.SortLeftToRight();
+        else set.SortLeftToRight();
+    }
+    label_container(state);
+}
+BENCHMARK(BM_PointsSortLeftToRight)->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 16, 8), { 0, 1 } });
+
+static void BM_PointsConvexHull(benchmark::State &state)
+{
+    Points pts(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        C2DPointSet set, set_hull;
+        C2DPointArray array, array_hull;
+        if (state.range(1)) array = pts.array;
+        else set.AddCopy(pts.set);
+        state.ResumeTiming();
+        if (state.range(1)) array_hull.ExtractConvexHull(array);
+        else set_hull.ExtractConvexHull(set);
+    }
+    label_container(state);
+}
+BENCHMARK(BM_PointsConvexHull)->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 14, 4), { 0, 1 } });
+
+static void BM_PointsClosestPair(benchmark::State &state)
+{
+    Points pts(state.range(0));
+    unsigned int i1, i2;
+    for (auto _ : state) {
+        const double d = state.range(1) ? pts.array.GetClosestPair(i1, i2) : pts.set.GetClosestPair(i1, i2);
+        benchmark::DoNotOptimize(d);
+    }
+    label_container(state);
+}
+BENCHMARK(BM_PointsClosestPair)->ArgsProduct({ benchmark::CreateRange(1 << 10, 1 << 16, 8), { 0, 1 } });
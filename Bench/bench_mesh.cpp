@@ -0,0 +1,106 @@
+#include "bench_data.h"
+#include <vvr/mesh.h>
+#include <benchmark/benchmark.h>
+
+using namespace vvr::bench;
+
+//! Fixtures from resources/obj, indexed by the benchmark argument.
+static const char *obj_fixtures[] = {
+    "obj/bunny_low.obj",
+    "obj/suzanne.obj",
+    "obj/dragon_low_low.obj",
+    "obj/armadillo_low_low.obj",
+};
+
+static vvr::Mesh::Ptr load_fixture(benchmark::State &state)
+{
+    const std::string file = resource(obj_fixtures[state.range(0)]);
+    state.SetLabel(obj_fixtures[state.range(0)]);
+    QuietCout quiet;
+    try {
+        return vvr::Mesh::Make(file);
+    }
+    catch (...) {
+        state.SkipWithError(("Could not load " + file).c_str());
+        return nullptr;
+    }
+}
+
+static void obj_args(benchmark::internal::Benchmark *b)
+{
+    for (int i = 0; i < (int)(sizeof(obj_fixtures) / sizeof(obj_fixtures[0])); i++) b->Arg(i);
+}
+
+/*---[Mesh]-----------------------------------------------------------------------------*/
+static void BM_MeshLoad(benchmark::State &state)
+{
+    if (!load_fixture(state)) return;
+    const std::string file = resource(obj_fixtures[state.range(0)]);
+    QuietCout quiet;
+    for (auto _ : state) {
+        auto mesh = vvr::Mesh::Make(file);
+        benchmark::DoNotOptimize(mesh.get());
+    }
+}
+BENCHMARK(BM_MeshLoad)->Apply(obj_args)->Unit(benchmark::kMillisecond);
+
+//! Normals and triangle planes, as after editing vertices.
+static void BM_MeshUpdate(benchmark::State &state)
+{
+    auto mesh = load_fixture(state);
+    if (!mesh) return;
+    for (auto _ : state) {
+        mesh->update();
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->getTriangles().size());
+}
+BENCHMARK(BM_MeshUpdate)->Apply(obj_args)->Unit(benchmark::kMicrosecond);
+
+static void BM_MeshTransform(benchmark::State &state)
+{
+    auto mesh = load_fixture(state);
+    if (!mesh) return;
+    const math::float3x4 rot = math::float3x4::RotateY(0.01f);
+    for (auto _ : state) {
+        mesh->transform(rot);
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->getVertices().size());
+}
+BENCHMARK(BM_MeshTransform)->Apply(obj_args)->Unit(benchmark::kMicrosecond);
+
+static void BM_MeshWeld(benchmark::State &state)
+{
+    auto mesh = load_fixture(state);
+    if (!mesh) return;
+    //! Unshare every vertex, which is what OBJ files without indices look like.
+    auto soup = vvr::Mesh::Make();
+    for (const vvr::Triangle &t : mesh->getTriangles()) {
+        const int base = soup->getVertices().size();
+        soup->getVertices().push_back(t.v1());
+        soup->getVertices().push_back(t.v2());
+        soup->getVertices().push_back(t.v3());
+        soup->getTriangles().push_back(vvr::Triangle(&soup->getVertices(), base, base + 1, base + 2));
+    }
+    soup->update(true);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto copy = vvr::Mesh::Make(*soup);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(copy->weld());
+    }
+    state.SetItemsProcessed(state.iterations() * soup->getVertices().size());
+}
+BENCHMARK(BM_MeshWeld)->Apply(obj_args)->Unit(benchmark::kMillisecond);
+
+static void BM_MeshSimplify(benchmark::State &state)
+{
+    auto mesh = load_fixture(state);
+    if (!mesh) return;
+    const size_t target = mesh->getTriangles().size() / 4;
+    for (auto _ : state) {
+        auto lod = mesh->simplified(target);
+        benchmark::DoNotOptimize(lod.get());
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->getTriangles().size());
+}
+BENCHMARK(BM_MeshSimplify)->Apply(obj_args)->Unit(benchmark::kMillisecond)->UseRealTime();
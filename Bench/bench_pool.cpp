@@ -0,0 +1,121 @@
+#include "bench_data.h"
+#include <GeoLib.h>
+#include <MemoryPool.h>
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/*---[Heap allocation counter]----------------------------------------------------------*/
+//! Counts the global new of this thread. Shared libraries call it too on
+//! Linux and macOS; on Windows, GeoLib.dll has its own, which isn't counted.
+static thread_local size_t t_heap_allocs = 0;
+
+void* operator new(size_t n)
+{
+    t_heap_allocs++;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+    //! Heap allocations per iteration, from the counter before the loop.
+    void report_allocs(benchmark::State &state, size_t before)
+    {
+        state.counters["heap_allocs"] = benchmark::Counter(
+            (double)(t_heap_allocs - before), benchmark::Counter::kAvgIterations);
+    }
+
+    //! As big as a C2DPoint, with a pool of its own.
+    struct PoolProbe { virtual ~PoolProbe() {} double x, y; };
+
+    //! Teardown of every run: hands the pool blocks back to the heap, so that
+    //! each run starts cold. The benchmark threads have joined by now, which
+    //! Release() requires.
+    void release_pools(const benchmark::State &)
+    {
+        bool released = CMemoryPool<PoolProbe>::Release();
+        released &= C2DPoint::ReleasePool();
+        released &= C2DLine::ReleasePool();
+        released &= C2DRect::ReleasePool();
+        if (!released) fprintf(stderr, "bench_pool: objects outlived their run, pools kept\n");
+    }
+
+}
+
+/*---[CMemoryPool]----------------------------------------------------------------------*/
+//! Allocates and frees batches of 1024, from the heap (0) or CMemoryPool (1), on each thread.
+static void BM_PoolAllocate(benchmark::State &state)
+{
+    const bool pooled = state.range(0);
+    std::vector<void*> ptrs(1024);
+    for (auto _ : state) {
+        if (pooled) {
+            for (auto &p : ptrs) p = CMemoryPool<PoolProbe>::Allocate();
+            for (auto p : ptrs) CMemoryPool<PoolProbe>::Deallocate(p);
+        } else {
+            for (auto &p : ptrs) p = ::operator new(sizeof(PoolProbe));
+            for (auto p : ptrs) ::operator delete(p);
+        }
+        benchmark::DoNotOptimize(ptrs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * ptrs.size());
+    state.SetLabel(pooled ? "pool" : "heap");
+}
+BENCHMARK(BM_PoolAllocate)->Arg(0)->Arg(1)->ThreadRange(1, 8)->UseRealTime()->Teardown(release_pools);
+
+/*---[GeoLib workloads]-----------------------------------------------------------------*/
+//! The heap_allocs counter shows what the pool saves: build with
+//! -DGEOLIB_MEMORY_POOL=OFF for the baseline.
+static void BM_PoolPolygonUnion(benchmark::State &state)
+{
+    srand(7);
+    C2DPolygon a, b;
+    a.CreateRandom(C2DRect(-100, 100, 60, -60), state.range(0), state.range(0));
+    b.CreateRandom(C2DRect(-60, 60, 100, -100), state.range(0), state.range(0));
+    const size_t before = t_heap_allocs;
+    for (auto _ : state) {
+        C2DHoledPolygonSet result;
+        a.GetUnion(b, result, CGrid::DynamicGrid);
+        benchmark::DoNotOptimize(result.size());
+    }
+    report_allocs(state, before);
+}
+BENCHMARK(BM_PoolPolygonUnion)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMicrosecond)->Teardown(release_pools);
+
+//! GeoLib has no triangulator; its convex decomposition stands in.
+static void BM_PoolConvexSubAreas(benchmark::State &state)
+{
+    const size_t before = t_heap_allocs;
+    for (auto _ : state) {
+        srand(7);
+        C2DPolygon poly;
+        poly.CreateRandom(C2DRect(-100, 100, 100, -100), state.range(0), state.range(0));
+        poly.CreateConvexSubAreas();
+        C2DPolygonSet areas;
+        poly.GetConvexSubAreas(areas);
+        benchmark::DoNotOptimize(areas.size());
+    }
+    report_allocs(state, before);
+}
+BENCHMARK(BM_PoolConvexSubAreas)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMicrosecond)->Teardown(release_pools);
+
+//! A point set filled one point at a time, then its hull.
+static void BM_PoolPointSetHull(benchmark::State &state)
+{
+    const auto pts = vvr::bench::random_points_2d<math::float2>(state.range(0));
+    const size_t before = t_heap_allocs;
+    for (auto _ : state) {
+        C2DPointSet set, hull;
+        for (const auto &p : pts) set.AddCopy(p.x, p.y);
+        hull.ExtractConvexHull(set);
+        benchmark::DoNotOptimize(hull.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    report_allocs(state, before);
+}
+BENCHMARK(BM_PoolPointSetHull)->RangeMultiplier(8)->Range(1 << 8, 1 << 17)->Teardown(release_pools);
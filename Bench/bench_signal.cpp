@@ -0,0 +1,177 @@
+#include "bench_data.h"
+#include <vvr/bspline.h>
+#include <vvr/dsp.h>
+#include <vvr/fft.h>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+
+using namespace vvr::bench;
+
+/*---[DSP]------------------------------------------------------------------------------*/
+static void BM_Smooth(benchmark::State &state)
+{
+    const vvr::dsp::Signal s = noisy_signal(state.range(0));
+    const size_t window = state.range(1);
+    for (auto _ : state) {
+        auto out = vvr::dsp::smooth(s, window);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Smooth)->ArgsProduct({ { 1 << 12, 1 << 16, 1 << 20 }, { 5, 51, 501 } });
+
+static void BM_Diff(benchmark::State &state)
+{
+    const vvr::dsp::Signal s = noisy_signal(state.range(0));
+    for (auto _ : state) {
+        auto out = vvr::dsp::diff(s, 1);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Diff)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+static void BM_Threshold(benchmark::State &state)
+{
+    const vvr::dsp::Signal s = noisy_signal(state.range(0));
+    for (auto _ : state) {
+        auto out = vvr::dsp::consecutive_threshold(vvr::dsp::threshold(s, 1.0), 8);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Threshold)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+//! The step detection chain, one function after the other vs as a fused pipeline.
+static void BM_Chain(benchmark::State &state)
+{
+    using namespace vvr::dsp;
+    const Signal s = noisy_signal(state.range(0));
+    for (auto _ : state) {
+        auto out = consecutive_threshold(threshold(smooth(diff(s, 1), 15), 0.5), 20);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Chain)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+static void BM_Pipeline(benchmark::State &state)
+{
+    using namespace vvr::dsp;
+    const Signal s = noisy_signal(state.range(0));
+    Signal out(s.size());
+    Pipeline p;
+    p.diff(1).smooth(15).threshold(0.5).consecutive_threshold(20);
+    for (auto _ : state) {
+        p.run(SignalView(s), SignalSpan(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pipeline)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+//! Streaming filters over 1024 sample chunks, as a live recording is fed.
+template <typename F>
+static void run_filter(benchmark::State &state, F filter)
+{
+    const vvr::dsp::Signal s = noisy_signal(state.range(0));
+    vvr::dsp::Signal out(s.size());
+    const size_t chunk = 1024;
+    for (auto _ : state) {
+        filter.reset();
+        for (size_t i = 0; i < s.size(); i += chunk) {
+            filter.process(s.data() + i, out.data() + i, std::min(chunk, s.size() - i));
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_MovingAverage(benchmark::State &state)
+{
+    run_filter(state, vvr::dsp::MovingAverage(state.range(1)));
+}
+BENCHMARK(BM_MovingAverage)->ArgsProduct({ { 1 << 16, 1 << 20 }, { 5, 51, 501 } });
+
+static void BM_MovingMedian(benchmark::State &state)
+{
+    run_filter(state, vvr::dsp::MovingMedian(state.range(1)));
+}
+BENCHMARK(BM_MovingMedian)->ArgsProduct({ { 1 << 16 }, { 5, 51, 501 } });
+
+static void BM_Biquad(benchmark::State &state)
+{
+    run_filter(state, vvr::dsp::Biquad::lowpass(20, 1000));
+}
+BENCHMARK(BM_Biquad)->RangeMultiplier(16)->Range(1 << 12, 1 << 20);
+
+/*---[FFT]------------------------------------------------------------------------------*/
+static void BM_Fft(benchmark::State &state)
+{
+    const size_t n = state.range(0);
+    const auto plan = vvr::dsp::FftPlan::get(n);
+    const vvr::dsp::Signal s = noisy_signal(n);
+    vvr::dsp::Spectrum x(s.begin(), s.end()), out(n);
+    for (auto _ : state) {
+        plan->forward(x.data(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+//! Powers of 2, mixed radix and a prime (Bluestein)
+BENCHMARK(BM_Fft)->Arg(1 << 10)->Arg(1 << 16)->Arg(1000)->Arg(60000)->Arg(65537);
+
+static void BM_Convolve(benchmark::State &state)
+{
+    const vvr::dsp::Signal s = noisy_signal(1 << 16);
+    const vvr::dsp::Signal kernel(state.range(0), 1.0 / state.range(0));
+    for (auto _ : state) {
+        auto out = vvr::dsp::convolve(s, kernel, true);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * s.size());
+}
+BENCHMARK(BM_Convolve)->RangeMultiplier(8)->Range(8, 4096);
+
+/*---[BSpline]--------------------------------------------------------------------------*/
+//! Clamped uniform cubic spline over 'n' control points.
+static void make_spline(vvr::BSpline<math::vec> &bsp, size_t n)
+{
+    const int degree = 3;
+    bsp.cps = random_points(n);
+    for (int i = 0; i < degree; i++) bsp.knots.push_back(0);
+    for (size_t i = 0; i <= n - degree; i++) bsp.knots.push_back((double)i / (n - degree));
+    for (int i = 0; i < degree; i++) bsp.knots.push_back(1);
+}
+
+static void BM_BSplineEval(benchmark::State &state)
+{
+    vvr::BSpline<math::vec> bsp;
+    make_spline(bsp, state.range(0));
+    const int samples = 256;
+    for (auto _ : state) {
+        for (int i = 0; i < samples; i++) {
+            benchmark::DoNotOptimize(bsp.eval((double)i / (samples - 1)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * samples);
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_BSplineEval)->RangeMultiplier(4)->Range(8, 512)->Complexity();
+
+static void BM_BSplineEvalMany(benchmark::State &state)
+{
+    vvr::BSpline<math::vec> bsp;
+    make_spline(bsp, state.range(0));
+    const int samples = 256;
+    std::vector<double> t(samples);
+    std::vector<math::vec> out(samples);
+    for (int i = 0; i < samples; i++) t[i] = (double)i / (samples - 1);
+    for (auto _ : state) {
+        bsp.eval_many(t.data(), samples, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * samples);
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_BSplineEvalMany)->RangeMultiplier(4)->Range(8, 512)->Complexity();
@@ -0,0 +1,86 @@
+#include <vvr/dsp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*--------------------------------------------------------------------------------------*/
+// Regression checks of vvr::dsp against brute force references. Run by ctest;
+// prints each failure and exits with non zero status if any.
+
+static int s_failures = 0;
+
+#define check(cond, ...) \
+    do { if (!(cond)) { s_failures++; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static double median_of_last(const std::vector<double> &x, size_t end, size_t window)
+{
+    const size_t begin = end > window ? end - window : 0;
+    std::vector<double> w(x.begin() + begin, x.begin() + end);
+    std::sort(w.begin(), w.end());
+    const size_t n = w.size();
+    return n % 2 ? w[n / 2] : (w[n / 2 - 1] + w[n / 2]) / 2;
+}
+
+static void check_moving_median(const char *name, const std::vector<double> &x)
+{
+    for (size_t window = 1; window <= 9; window++) {
+        vvr::dsp::MovingMedian mm(window);
+        for (size_t i = 0; i < x.size(); i++) {
+            const double got = mm.step(x[i]);
+            const double exp = median_of_last(x, i + 1, window);
+            check(got == exp, "MovingMedian(%zu) %s input, sample %zu: %g != %g", window, name, i, got, exp);
+        }
+    }
+}
+
+/*---[MovingMedian]---------------------------------------------------------------------*/
+static void check_moving_median()
+{
+    std::vector<double> up, down, flat, dups, noise;
+    srand(1);
+    for (int i = 0; i < 64; i++) {
+        up.push_back(i);
+        down.push_back(-i);
+        flat.push_back(1);
+        dups.push_back(rand() % 4);
+        noise.push_back(rand() / (double) RAND_MAX);
+    }
+    check_moving_median("increasing", up);
+    check_moving_median("decreasing", down);
+    check_moving_median("constant", flat);
+    check_moving_median("repeating", dups);
+    check_moving_median("random", noise);
+}
+
+/*---[smooth]---------------------------------------------------------------------------*/
+static void check_smooth()
+{
+    //! smooth() keeps a running sum, so it rounds differently than summing each window.
+    std::vector<double> x;
+    srand(2);
+    for (int i = 0; i < 1000; i++) x.push_back(1e3 * rand() / RAND_MAX);
+
+    for (size_t window : { 1, 4, 5, 51 }) {
+        const vvr::dsp::Signal y = vvr::dsp::smooth(x, window);
+        const size_t w = window % 2 ? window : window + 1;
+        for (size_t k = 0; k < x.size(); k++) {
+            double exp = 0;
+            if (k >= w / 2 && k + w / 2 < x.size()) {
+                for (size_t j = k - w / 2; j <= k + w / 2; j++) exp += x[j];
+                exp /= w;
+            }
+            check(std::fabs(y[k] - exp) <= 1e-9 * 1e3, "smooth(%zu), sample %zu: %g != %g", window, k, y[k], exp);
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------*/
+int main()
+{
+    check_moving_median();
+    check_smooth();
+    if (s_failures) printf("%d checks failed\n", s_failures);
+    return s_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include <GeoLib.h>
+#include <MemoryPool.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/*--------------------------------------------------------------------------------------*/
+// Checks of CMemoryPool::Release() and of the pools of the GeoLib classes. Run
+// by ctest; prints each failure and exits with non zero status if any.
+
+static int s_failures = 0;
+
+#define check(cond, ...) \
+    do { if (!(cond)) { s_failures++; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+struct Probe { virtual ~Probe() {} double x, y; };
+
+typedef CMemoryPool<Probe> ProbePool;
+
+static void fill(std::vector<void*> &objects, size_t n)
+{
+    objects.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        objects[i] = ProbePool::Allocate();
+        memset(objects[i], (int) i, sizeof(Probe));
+    }
+}
+
+static void empty(std::vector<void*> &objects)
+{
+    for (void *p : objects) ProbePool::Deallocate(p);
+    objects.clear();
+}
+
+/*---[Release]--------------------------------------------------------------------------*/
+static void check_release()
+{
+    const size_t n = 3 * ProbePool::BlockSize;
+    std::vector<void*> objects;
+
+    fill(objects, n);
+    void *last = objects.back();
+    objects.pop_back();
+    empty(objects);
+    check(!ProbePool::Release(), "Release() with an object alive");
+    ProbePool::Deallocate(last);
+    check(ProbePool::Release(), "Release() with no object alive");
+    check(ProbePool::Release(), "Release() of an empty pool");
+
+    //! The freed blocks must not be handed out again; ASan catches it if they are.
+    const size_t blocks = ProbePool::GetBlockCount();
+    fill(objects, n);
+    check(ProbePool::GetBlockCount() > blocks, "no new blocks after Release()");
+    empty(objects);
+    check(ProbePool::Release(), "Release() after reuse");
+}
+
+/*---[Threads]--------------------------------------------------------------------------*/
+static void check_release_threads()
+{
+    //! Allocated on some threads and freed on others, which then exit.
+    const size_t n = 2 * ProbePool::BlockSize;
+    std::vector<std::vector<void*>> objects(4);
+    std::vector<std::thread> threads;
+
+    for (auto &o : objects) threads.emplace_back([&o, n] { fill(o, n); });
+    for (auto &t : threads) t.join();
+    threads.clear();
+    check(!ProbePool::Release(), "Release() with the objects of exited threads alive");
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        auto &o = objects[(i + 1) % objects.size()];
+        threads.emplace_back([&o] { empty(o); });
+    }
+    for (auto &t : threads) t.join();
+    check(ProbePool::Release(), "Release() after freeing on other threads");
+
+    fill(objects[0], n);
+    empty(objects[0]);
+    check(ProbePool::Release(), "Release() after reuse");
+}
+
+/*---[GeoLib]---------------------------------------------------------------------------*/
+static void check_geolib()
+{
+    //! Goes through GeoLib's own pool, which on Windows lives in the DLL.
+#ifndef GEOLIB_NO_MEMORY_POOL
+    C2DPoint *pt = new C2DPoint(1, 2);
+    check(!C2DPoint::ReleasePool(), "C2DPoint::ReleasePool() with a point alive");
+    delete pt;
+#endif
+    check(C2DPoint::ReleasePool(), "C2DPoint::ReleasePool() with no point alive");
+
+    {
+        C2DPolygon a, b;
+        C2DHoledPolygonSet result;
+        srand(1);
+        a.CreateRandom(C2DRect(-100, 100, 60, -60), 64, 64);
+        b.CreateRandom(C2DRect(-60, 60, 100, -100), 64, 64);
+        a.GetUnion(b, result, CGrid::DynamicGrid);
+        check(result.size() > 0, "empty union");
+    }
+    check(C2DPoint::ReleasePool(), "C2DPoint::ReleasePool() after a union");
+    check(C2DLine::ReleasePool(), "C2DLine::ReleasePool() after a union");
+    check(C2DRect::ReleasePool(), "C2DRect::ReleasePool() after a union");
+}
+
+/*--------------------------------------------------------------------------------------*/
+int main()
+{
+    check_release();
+    check_release_threads();
+    check_geolib();
+    if (s_failures) printf("%d checks failed\n", s_failures);
+    return s_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
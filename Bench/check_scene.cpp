@@ -0,0 +1,124 @@
+#include <vvr/scene.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*--------------------------------------------------------------------------------------*/
+// Checks that a replayed SimRecording delivers the same input to a Scene as the
+// live run did. Run by ctest; prints each failure and exits with non zero
+// status if any.
+
+static int s_failures = 0;
+
+#define check(cond, ...) \
+    do { if (!(cond)) { s_failures++; printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+namespace vvr {
+
+    //! Drives a Scene the way GlWidget does, without a window.
+    class SceneCheck
+    {
+    public:
+        static void dispatch(Scene &scene, const InputEvent &e) { scene.dispatch(e); }
+        static bool advance(Scene &scene) { return scene.advance(); }
+    };
+
+}
+
+using vvr::InputEvent;
+using vvr::SceneCheck;
+
+//! Logs what each handler gets; motion handlers log their motion samples.
+class LogScene : public vvr::Scene
+{
+public:
+    std::vector<std::vector<InputEvent>> log;
+
+    void draw() override {}
+    void mousePressed(int x, int y, int modif) override { add(InputEvent::MousePress, x, y, modif); }
+    void mouseReleased(int x, int y, int modif) override { add(InputEvent::MouseRelease, x, y, modif); }
+    void mouseMoved(int x, int y, int modif) override { log.push_back(getMotionSamples()); }
+    void mouseHovered(int x, int y, int modif) override { log.push_back(getMotionSamples()); }
+    void keyEvent(unsigned char key, bool up, int modif) override { add(InputEvent::Key, key, up, modif); }
+
+private:
+    void add(InputEvent::Type type, int x, int y, int modif)
+    {
+        InputEvent e;
+        e.type = type;
+        e.x = x;
+        e.y = y;
+        e.modif = modif;
+        log.push_back(std::vector<InputEvent>(1, e));
+    }
+};
+
+static bool same(const InputEvent &a, const InputEvent &b)
+{
+    return a.type == b.type && a.x == b.x && a.y == b.y && a.modif == b.modif;
+}
+
+/*---[Replay]---------------------------------------------------------------------------*/
+static void check_replay()
+{
+    //! Strokes with runs of motion of any length between two frames, broken
+    //! up by key presses and modifier changes, and hovering in between.
+    LogScene live;
+    live.startRecording(7);
+    srand(3);
+    int x = 0, y = 0;
+    for (int frame = 0; frame < 200; frame++)
+    {
+        InputEvent e;
+        const int n = rand() % 6;
+        for (int i = 0; i < n; i++) {
+            x += rand() % 11 - 5;
+            y += rand() % 11 - 5;
+            e.x = x;
+            e.y = y;
+            switch (rand() % 12) {
+            case 0: e.type = InputEvent::MousePress; break;
+            case 1: e.type = InputEvent::MouseRelease; break;
+            case 2: e.type = InputEvent::Key; e.key = 'q'; e.up = rand() % 2; break;
+            case 3: e.modif ^= 1; break;
+            case 4: case 5: e.type = InputEvent::MouseHover; break;
+            default: e.type = InputEvent::MouseMove; break;
+            }
+            SceneCheck::dispatch(live, e);
+            e = InputEvent();
+            e.type = InputEvent::MouseMove;
+        }
+        SceneCheck::advance(live);
+    }
+
+    size_t runs = 0;
+    for (const auto &entry : live.log) runs += entry.size() > 1;
+    check(runs > 0, "no motion run of more than one sample");
+
+    const char *filename = "check_scene.rec";
+    check(live.getRecording()->save(filename), "could not write %s", filename);
+    vvr::SimRecording recording;
+    check(recording.load(filename), "could not read %s", filename);
+    remove(filename);
+
+    LogScene replay;
+    replay.startReplay(recording);
+    while (replay.isReplaying()) SceneCheck::advance(replay);
+
+    check(replay.log.size() == live.log.size(), "%zu events replayed, %zu live", replay.log.size(), live.log.size());
+    for (size_t i = 0; i < live.log.size() && i < replay.log.size(); i++) {
+        const auto &a = live.log[i];
+        const auto &b = replay.log[i];
+        bool equal = a.size() == b.size();
+        for (size_t k = 0; equal && k < a.size(); k++) equal = same(a[k], b[k]);
+        check(equal, "event %zu: %zu samples replayed, %zu live, or they differ", i, b.size(), a.size());
+    }
+}
+
+/*--------------------------------------------------------------------------------------*/
+int main()
+{
+    check_replay();
+    if (s_failures) printf("%d checks failed\n", s_failures);
+    return s_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
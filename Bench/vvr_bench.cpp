@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------------------------
+ * vvr_bench: Runs scene apps headless and collects their frame timings.
+ *
+ *   vvr_bench [--frames N] [--warmup N] [--size WxH] [--dt SEC] [--no-input] [--no-render]
+ *             [--out DIR] [--hw] [--list] [app...]
+ *
+ * Each app is started as "<app> --bench ..." on the Qt offscreen platform with the
+ * software rasterizer (unless --hw), so no display or GPU is needed. Reports are
+ * written to DIR/<app>.json and a summary table is printed. Without app names, all
+ * scene apps of the build are run.
+ *------------------------------------------------------------------------------------*/
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStringList>
+#include <cstdio>
+
+static QString app_executable(const QString &dir, const QString &app)
+{
+#if defined(Q_OS_WIN)
+    return dir + "/" + app + ".exe";
+#elif defined(Q_OS_MACOS)
+    return dir + "/" + app + ".app/Contents/MacOS/" + app;
+#else
+    return dir + "/" + app;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication qapp(argc, argv);
+
+    const QStringList all_apps = QString(VVR_SCENE_APPS).split(',', Qt::SkipEmptyParts);
+    QStringList apps;
+    QStringList forward;
+    QString out_dir = "bench";
+    bool software = true;
+
+    const QStringList args = qapp.arguments();
+    for (int i = 1; i < args.size(); i++)
+    {
+        const QString &arg = args[i];
+        const bool has_val = i + 1 < args.size();
+        if (arg == "--list") {
+            for (const QString &app : all_apps) printf("%s\n", qPrintable(app));
+            return 0;
+        }
+        else if (arg == "--hw") software = false;
+        else if (arg == "--out" && has_val) out_dir = args[++i];
+        else if (arg == "--no-input" || arg == "--no-render") forward << arg;
+        else if ((arg == "--frames" || arg == "--warmup" || arg == "--size" || arg == "--dt") && has_val) {
+            forward << arg << args[++i];
+        }
+        else if (arg.startsWith("-")) {
+            fprintf(stderr, "Unknown option: %s\n", qPrintable(arg));
+            return 2;
+        }
+        else apps << arg;
+    }
+    if (apps.isEmpty()) apps = all_apps;
+
+    QDir().mkpath(out_dir);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("QT_QPA_PLATFORM", "offscreen");
+    if (software) env.insert("LIBGL_ALWAYS_SOFTWARE", "1");
+
+    const QString bin_dir = QCoreApplication::applicationDirPath();
+    QJsonObject all_reports;
+    int failures = 0;
+
+    printf("%-20s %10s %10s %10s %10s\n", "app", "mean ms", "p95 ms", "max ms", "gpu ms");
+
+    for (const QString &app : apps)
+    {
+        const QString exe = app_executable(bin_dir, app);
+        const QString report_file = QFileInfo(out_dir + "/" + app + ".json").absoluteFilePath();
+        if (!QFileInfo::exists(exe)) {
+            fprintf(stderr, "%s: not found (%s)\n", qPrintable(app), qPrintable(exe));
+            failures++;
+            continue;
+        }
+
+        QProcess proc;
+        proc.setProcessEnvironment(env);
+        proc.setWorkingDirectory(bin_dir);
+        proc.setProcessChannelMode(QProcess::MergedChannels);
+        proc.start(exe, QStringList() << "--bench" << forward << "--bench-out" << report_file);
+
+        const int timeout_ms = 10 * 60 * 1000;
+        if (!proc.waitForFinished(timeout_ms) || proc.exitStatus() != QProcess::NormalExit || proc.exitCode() != 0) {
+            proc.kill();
+            fprintf(stderr, "%s: failed\n%s\n", qPrintable(app), proc.readAll().constData());
+            failures++;
+            continue;
+        }
+
+        QFile file(report_file);
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "%s: no report\n", qPrintable(app));
+            failures++;
+            continue;
+        }
+        const QJsonObject report = QJsonDocument::fromJson(file.readAll()).object();
+        const QJsonObject summary = report["summary"].toObject();
+        const QJsonObject frame = summary["frame_ms"].toObject();
+        const QJsonObject gpu = summary["gpu_ms"].toObject();
+
+        printf("%-20s %10.3f %10.3f %10.3f %10.3f\n", qPrintable(app),
+            frame["mean"].toDouble(), frame["p95"].toDouble(), frame["max"].toDouble(),
+            gpu.contains("mean") ? gpu["mean"].toDouble() : -1.0);
+        fflush(stdout);
+
+        all_reports[app] = summary;
+    }
+
+    QFile summary_file(out_dir + "/summary.json");
+    if (summary_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        summary_file.write(QJsonDocument(all_reports).toJson());
+    }
+
+    return failures ? 1 : 0;
+}
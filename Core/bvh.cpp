@@ -0,0 +1,557 @@
+#include <vvr/bvh.h>
+#include <MathGeoLib.h>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+using namespace vvr;
+using namespace std;
+using namespace math;
+
+static AABB unite(const AABB &a, const AABB &b)
+{
+    AABB c(a);
+    c.Enclose(b);
+    return c;
+}
+
+/*---[AabbTree]-------------------------------------------------------------------------*/
+AabbTree::AabbTree(float margin)
+    : m_root(-1)
+    , m_free(-1)
+    , m_leaf_count(0)
+    , m_margin(margin)
+{
+}
+
+void AabbTree::clear()
+{
+    m_nodes.clear();
+    m_root = -1;
+    m_free = -1;
+    m_leaf_count = 0;
+}
+
+int AabbTree::allocNode()
+{
+    int id;
+    if (m_free < 0) {
+        id = (int) m_nodes.size();
+        m_nodes.push_back(Node());
+    } else {
+        id = m_free;
+        m_free = m_nodes[id].parent;
+    }
+    Node &node = m_nodes[id];
+    node.data = nullptr;
+    node.parent = -1;
+    node.child1 = -1;
+    node.child2 = -1;
+    node.height = 0;
+    return id;
+}
+
+void AabbTree::freeNode(int id)
+{
+    m_nodes[id].parent = m_free;
+    m_nodes[id].height = -1;
+    m_free = id;
+}
+
+int AabbTree::insert(const AABB &aabb, void *data)
+{
+    const int leaf = allocNode();
+    const vec r(m_margin, m_margin, m_margin);
+    m_nodes[leaf].aabb = AABB(aabb.minPoint - r, aabb.maxPoint + r);
+    m_nodes[leaf].data = data;
+    insertLeaf(leaf);
+    m_leaf_count++;
+    return leaf;
+}
+
+void AabbTree::remove(int proxy)
+{
+    assert(m_nodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_leaf_count--;
+}
+
+bool AabbTree::update(int proxy, const AABB &aabb)
+{
+    assert(m_nodes[proxy].isLeaf());
+    if (m_nodes[proxy].aabb.Contains(aabb)) return false;
+
+    const vec r(m_margin, m_margin, m_margin);
+    removeLeaf(proxy);
+    m_nodes[proxy].aabb = AABB(aabb.minPoint - r, aabb.maxPoint + r);
+    insertLeaf(proxy);
+    return true;
+}
+
+void AabbTree::insertLeaf(int leaf)
+{
+    if (m_root < 0) {
+        m_root = leaf;
+        m_nodes[leaf].parent = -1;
+        return;
+    }
+
+    //! Find the best sibling, descending by the surface area heuristic.
+    const AABB leaf_aabb = m_nodes[leaf].aabb;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const int c1 = m_nodes[index].child1;
+        const int c2 = m_nodes[index].child2;
+        const float area = m_nodes[index].aabb.SurfaceArea();
+        const float combined = unite(m_nodes[index].aabb, leaf_aabb).SurfaceArea();
+        const float cost = 2 * combined;
+        const float inherit = 2 * (combined - area);
+
+        float cost1 = unite(leaf_aabb, m_nodes[c1].aabb).SurfaceArea() + inherit;
+        if (!m_nodes[c1].isLeaf()) cost1 -= m_nodes[c1].aabb.SurfaceArea();
+        float cost2 = unite(leaf_aabb, m_nodes[c2].aabb).SurfaceArea() + inherit;
+        if (!m_nodes[c2].isLeaf()) cost2 -= m_nodes[c2].aabb.SurfaceArea();
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? c1 : c2;
+    }
+
+    //! Create a new parent for the sibling and the leaf.
+    const int sibling = index;
+    const int old_parent = m_nodes[sibling].parent;
+    const int new_parent = allocNode();
+    m_nodes[new_parent].parent = old_parent;
+    m_nodes[new_parent].aabb = unite(leaf_aabb, m_nodes[sibling].aabb);
+    m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+    m_nodes[new_parent].child1 = sibling;
+    m_nodes[new_parent].child2 = leaf;
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+
+    if (old_parent < 0) {
+        m_root = new_parent;
+    } else if (m_nodes[old_parent].child1 == sibling) {
+        m_nodes[old_parent].child1 = new_parent;
+    } else {
+        m_nodes[old_parent].child2 = new_parent;
+    }
+
+    refitFrom(new_parent);
+}
+
+void AabbTree::removeLeaf(int leaf)
+{
+    if (leaf == m_root) {
+        m_root = -1;
+        return;
+    }
+
+    const int parent = m_nodes[leaf].parent;
+    const int grand_parent = m_nodes[parent].parent;
+    const int sibling = m_nodes[parent].child1 == leaf
+        ? m_nodes[parent].child2
+        : m_nodes[parent].child1;
+
+    if (grand_parent < 0) {
+        m_root = sibling;
+        m_nodes[sibling].parent = -1;
+        freeNode(parent);
+        return;
+    }
+
+    if (m_nodes[grand_parent].child1 == parent) {
+        m_nodes[grand_parent].child1 = sibling;
+    } else {
+        m_nodes[grand_parent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grand_parent;
+    freeNode(parent);
+    refitFrom(grand_parent);
+}
+
+void AabbTree::refitFrom(int id)
+{
+    while (id >= 0)
+    {
+        id = balance(id);
+        Node &node = m_nodes[id];
+        const Node &c1 = m_nodes[node.child1];
+        const Node &c2 = m_nodes[node.child2];
+        node.height = 1 + max(c1.height, c2.height);
+        node.aabb = unite(c1.aabb, c2.aabb);
+        id = node.parent;
+    }
+}
+
+int AabbTree::balance(int a)
+{
+    //! Rotate the taller grandchild up, if the children differ by more than 1 level.
+    Node &A = m_nodes[a];
+    if (A.isLeaf() || A.height < 2) return a;
+
+    const int b = A.child1;
+    const int c = A.child2;
+    const int balance = m_nodes[c].height - m_nodes[b].height;
+    if (balance >= -1 && balance <= 1) return a;
+
+    const int up = balance > 1 ? c : b;     // Child to rotate up
+    const int down = balance > 1 ? b : c;   // Child that stays under 'a'
+    const int f = m_nodes[up].child1;
+    const int g = m_nodes[up].child2;
+
+    //! Swap 'a' and 'up'
+    m_nodes[up].child1 = a;
+    m_nodes[up].parent = A.parent;
+    A.parent = up;
+
+    if (m_nodes[up].parent < 0) {
+        m_root = up;
+    } else if (m_nodes[m_nodes[up].parent].child1 == a) {
+        m_nodes[m_nodes[up].parent].child1 = up;
+    } else {
+        m_nodes[m_nodes[up].parent].child2 = up;
+    }
+
+    //! Keep the taller grandchild under 'up', move the other one under 'a'
+    const int keep = m_nodes[f].height > m_nodes[g].height ? f : g;
+    const int move = keep == f ? g : f;
+    m_nodes[up].child2 = keep;
+    if (balance > 1) A.child2 = move; else A.child1 = move;
+    m_nodes[move].parent = a;
+
+    A.aabb = unite(m_nodes[down].aabb, m_nodes[move].aabb);
+    A.height = 1 + max(m_nodes[down].height, m_nodes[move].height);
+    m_nodes[up].aabb = unite(A.aabb, m_nodes[keep].aabb);
+    m_nodes[up].height = 1 + max(A.height, m_nodes[keep].height);
+    return up;
+}
+
+void AabbTree::collectAll(int id, std::vector<int> &proxies) const
+{
+    if (m_nodes[id].isLeaf()) {
+        proxies.push_back(id);
+    } else {
+        collectAll(m_nodes[id].child1, proxies);
+        collectAll(m_nodes[id].child2, proxies);
+    }
+}
+
+void AabbTree::query(const Frustum &frustum, std::vector<int> &proxies) const
+{
+    if (m_root < 0) return;
+
+    Plane planes[6];
+    frustum.GetPlanes(planes);
+
+    //! Bit i of the mask is set while the box may still cross plane i.
+    std::vector<std::pair<int, unsigned>> stack;
+    stack.push_back({ m_root, 0x3Fu });
+
+    while (!stack.empty())
+    {
+        const int id = stack.back().first;
+        unsigned mask = stack.back().second;
+        stack.pop_back();
+
+        const Node &node = m_nodes[id];
+        const vec c = node.aabb.CenterPoint();
+        const vec h = node.aabb.HalfSize();
+        bool outside = false;
+
+        for (int i = 0; i < 6 && !outside; i++) {
+            if (!(mask & (1u << i))) continue;
+            const float d = planes[i].SignedDistance(c);
+            const float r = planes[i].normal.Abs().Dot(h);
+            if (d - r > 0) outside = true;           // Plane normals point outwards
+            else if (d + r < 0) mask &= ~(1u << i);  // Completely behind this plane
+        }
+
+        if (outside) continue;
+
+        if (!mask) {
+            collectAll(id, proxies);
+        } else if (node.isLeaf()) {
+            proxies.push_back(id);
+        } else {
+            stack.push_back({ node.child1, mask });
+            stack.push_back({ node.child2, mask });
+        }
+    }
+}
+
+void AabbTree::query(const AABB &aabb, std::vector<int> &proxies) const
+{
+    if (m_root < 0) return;
+
+    std::vector<int> stack;
+    stack.push_back(m_root);
+
+    while (!stack.empty())
+    {
+        const int id = stack.back();
+        stack.pop_back();
+        const Node &node = m_nodes[id];
+        if (!node.aabb.Intersects(aabb)) continue;
+        if (node.isLeaf()) {
+            proxies.push_back(id);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+/*---[PolylineBvh]----------------------------------------------------------------------*/
+static real distanceSq(const AABB &aabb, const vec &p)
+{
+    const vec q = p.Clamp(aabb.minPoint, aabb.maxPoint);
+    return q.DistanceSq(p);
+}
+
+void PolylineBvh::clear()
+{
+    m_nodes.clear();
+    m_pts.clear();
+}
+
+void PolylineBvh::build(const vec *pts, size_t num_pts)
+{
+    clear();
+    if (num_pts < 2) return;
+    m_pts.assign(pts, pts + num_pts);
+    m_nodes.reserve(2 * (num_pts - 1) / LeafSize + 2);
+    buildRange(0, (int)num_pts - 1);
+}
+
+int PolylineBvh::buildRange(int first, int count)
+{
+    const int id = (int)m_nodes.size();
+    m_nodes.push_back(Node());
+
+    if (count <= LeafSize) {
+        AABB aabb(m_pts[first], m_pts[first]);
+        for (int i = first + 1; i <= first + count; i++) {
+            aabb.Enclose(m_pts[i]);
+        }
+        m_nodes[id].aabb = aabb;
+        m_nodes[id].first = first;
+        m_nodes[id].count = count;
+        return id;
+    }
+
+    const int half = count / 2;
+    const int left = buildRange(first, half);
+    const int right = buildRange(first + half, count - half);
+    m_nodes[id].aabb = unite(m_nodes[left].aabb, m_nodes[right].aabb);
+    m_nodes[id].first = right;
+    m_nodes[id].count = 0;
+    return id;
+}
+
+real PolylineBvh::closest(const vec &p, real max_dsq, size_t *seg) const
+{
+    if (m_nodes.empty()) return -1;
+
+    real best = max_dsq;
+    int best_seg = -1;
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const Node &node = m_nodes[stack[--top]];
+        if (distanceSq(node.aabb, p) > best) continue;
+
+        if (node.count) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                const real d = LineSegment(m_pts[i], m_pts[i + 1]).DistanceSq(p);
+                if (d <= best) {
+                    best = d;
+                    best_seg = i;
+                }
+            }
+            continue;
+        }
+
+        //! Nearer child last, so that it's visited first and prunes more.
+        const int left = (int)(&node - m_nodes.data()) + 1;
+        const int right = node.first;
+        const bool left_first = distanceSq(m_nodes[left].aabb, p) <= distanceSq(m_nodes[right].aabb, p);
+        stack[top++] = left_first ? right : left;
+        stack[top++] = left_first ? left : right;
+    }
+
+    if (best_seg < 0) return -1;
+    if (seg) *seg = best_seg;
+    return best;
+}
+
+/*---[CullingGroup]---------------------------------------------------------------------*/
+bool CullingGroup::getBounds(const Entry &entry, AABB &aabb) const
+{
+    if (entry.mesh) {
+        aabb = entry.mesh->getAABB();
+        return true;
+    }
+    return entry.drw->getBounds(aabb);
+}
+
+void CullingGroup::add(Drawable *drw)
+{
+    if (m_index.count(drw)) return;
+
+    Entry entry;
+    entry.drw = drw;
+    entry.style = SOLID;
+    entry.proxy = -1;
+    entry.unbounded = -1;
+    const size_t index = m_entries.size();
+    AABB aabb;
+    if (getBounds(entry, aabb)) {
+        entry.proxy = m_tree.insert(aabb, reinterpret_cast<void*>(index));
+    }
+    m_index[drw] = index;
+    m_entries.push_back(entry);
+    if (entry.proxy < 0) addUnbounded(index);
+}
+
+void CullingGroup::add(Mesh::Ptr mesh, Colour col, Style style)
+{
+    auto it = m_index.find(mesh.get());
+    if (it != m_index.end()) {
+        m_entries[it->second].col = col;
+        m_entries[it->second].style = style;
+        return;
+    }
+
+    Entry entry;
+    entry.drw = nullptr;
+    entry.mesh = mesh;
+    entry.col = col;
+    entry.style = style;
+    entry.proxy = m_tree.insert(mesh->getAABB(), reinterpret_cast<void*>(m_entries.size()));
+    entry.unbounded = -1;
+    m_index[mesh.get()] = m_entries.size();
+    m_entries.push_back(entry);
+}
+
+void CullingGroup::remove(Drawable *drw)
+{
+    auto it = m_index.find(drw);
+    if (it == m_index.end()) return;
+    const size_t index = it->second;
+    m_index.erase(it);
+    removeAt(index);
+}
+
+void CullingGroup::remove(Mesh::Ptr mesh)
+{
+    auto it = m_index.find(mesh.get());
+    if (it == m_index.end()) return;
+    const size_t index = it->second;
+    m_index.erase(it);
+    removeAt(index);
+}
+
+void CullingGroup::removeAt(size_t index)
+{
+    if (m_entries[index].proxy >= 0) m_tree.remove(m_entries[index].proxy);
+    else removeUnbounded(index);
+
+    //! Move the last entry into the slot; only its proxy and index change.
+    const size_t last = m_entries.size() - 1;
+    if (index != last) {
+        Entry &moved = m_entries[index];
+        moved = std::move(m_entries[last]);
+        if (moved.proxy >= 0) m_tree.setData(moved.proxy, reinterpret_cast<void*>(index));
+        else m_unbounded[moved.unbounded] = index;
+        m_index[moved.mesh ? (const void*) moved.mesh.get() : (const void*) moved.drw] = index;
+    }
+    m_entries.pop_back();
+}
+
+void CullingGroup::addUnbounded(size_t index)
+{
+    m_entries[index].unbounded = (int)m_unbounded.size();
+    m_unbounded.push_back(index);
+}
+
+void CullingGroup::removeUnbounded(size_t index)
+{
+    const int slot = m_entries[index].unbounded;
+    m_unbounded[slot] = m_unbounded.back();
+    m_entries[m_unbounded[slot]].unbounded = slot;
+    m_unbounded.pop_back();
+    m_entries[index].unbounded = -1;
+}
+
+void CullingGroup::refit()
+{
+    //! Objects may have moved, or gained / lost their bounds.
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        Entry &entry = m_entries[i];
+        AABB aabb;
+        const bool bounded = getBounds(entry, aabb);
+        if (entry.proxy >= 0 && !bounded) {
+            m_tree.remove(entry.proxy);
+            entry.proxy = -1;
+            addUnbounded(i);
+        } else if (entry.proxy < 0 && bounded) {
+            removeUnbounded(i);
+            entry.proxy = m_tree.insert(aabb, reinterpret_cast<void*>(i));
+        } else if (bounded) {
+            m_tree.update(entry.proxy, aabb);
+        }
+    }
+}
+
+void CullingGroup::clear()
+{
+    m_tree.clear();
+    m_entries.clear();
+    m_index.clear();
+    m_unbounded.clear();
+    m_num_drawn = 0;
+}
+
+void CullingGroup::drawEntry(Entry &entry)
+{
+    if (entry.mesh) entry.mesh->draw(entry.col, entry.style);
+    else entry.drw->drawif();
+}
+
+void CullingGroup::draw(const Frustum &frustum, bool front_to_back)
+{
+    m_visible.clear();
+    m_tree.query(frustum, m_visible);
+    m_num_drawn = 0;
+
+    //! Proxy data holds the entry index
+    m_order.clear();
+    const vec eye = frustum.Pos();
+    for (int proxy : m_visible) {
+        const size_t ei = reinterpret_cast<size_t>(m_tree.getData(proxy));
+        const float d = front_to_back
+            ? m_tree.getFatAABB(proxy).CenterPoint().DistanceSq(eye)
+            : 0.0f;
+        m_order.push_back({ d, ei });
+    }
+
+    if (front_to_back) {
+        std::sort(m_order.begin(), m_order.end());
+    }
+
+    for (auto &o : m_order) {
+        drawEntry(m_entries[o.second]);
+        m_num_drawn++;
+    }
+
+    for (size_t ei : m_unbounded) {
+        drawEntry(m_entries[ei]);
+        m_num_drawn++;
+    }
+}
@@ -1,10 +1,13 @@
 #include <vvr/drawing.h>
 #include <vvr/mesh.h>
+#include <vvr/profiler.h>
 #include <MathGeoLib.h>
 #include <GeoLib.h>
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <functional>
+#include <mutex>
 #include <QtGui> //gl.h
 
 using vvr::real;
@@ -32,84 +35,190 @@ math::AABB vvr::aabbFromVertices(const std::vector<vec> &vertices)
     return math::AABB(lo, hi);
 }
 
-void drawSphere(int lats, int longs)
-{
-    for (int i = 0; i <= lats; i++) {
-        double lat0 = M_PI * (-0.5 + static_cast<double>(i-1) / lats);
-        double lat1 = M_PI * (-0.5 + static_cast<double>(i) / lats);
-        double z0  = sin(lat0);
-        double zr0 = cos(lat0);
-        double z1  = sin(lat1);
-        double zr1 = cos(lat1);
-        glBegin(GL_QUAD_STRIP);
-        for (int j = 0; j <= longs; j++) {
-            double lng = 2.0 * M_PI * static_cast<double>(j-1) / longs;
-            double x = cos(lng);
-            double y = sin(lng);
-            glNormal3d(x * zr0, y * zr0, z0);
-            glVertex3d(x * zr0, y * zr0, z0);
-            glNormal3d(x * zr1, y * zr1, z1);
-            glVertex3d(x * zr1, y * zr1, z1);
+/*---[Geometry cache]-------------------------------------------------------------------*/
+static const int SphereLats[vvr::LOD_COUNT] = { 6, 12, 24 };
+static const int SphereLongs[vvr::LOD_COUNT] = { 8, 15, 30 };
+static const int CylinderSegs[vvr::LOD_COUNT] = { 12, 24, 48 };
+
+static void addPart(vvr::UnitMesh &mesh, unsigned mode, int first)
+{
+    vvr::UnitMesh::Part part;
+    part.mode = mode;
+    part.first = first;
+    part.count = static_cast<int>(mesh.vertices.size()) - first;
+    mesh.parts.push_back(part);
+}
+
+static void tessellateSphere(vvr::UnitMesh &mesh, int lats, int longs)
+{
+    std::vector<float> xs(longs + 1), ys(longs + 1);
+    for (int j = 0; j <= longs; j++) {
+        math::SinCos(math::pi * 2 * j / longs, ys[j], xs[j]);
+    }
+
+    for (int i = 0; i < lats; i++) {
+        float z0, zr0, z1, zr1;
+        math::SinCos(math::pi * (-0.5f + static_cast<float>(i) / lats), z0, zr0);
+        math::SinCos(math::pi * (-0.5f + static_cast<float>(i + 1) / lats), z1, zr1);
+        for (int j = 0; j < longs; j++) {
+            const vec quad[4] = {
+                vec(xs[j] * zr0, ys[j] * zr0, z0),
+                vec(xs[j + 1] * zr0, ys[j + 1] * zr0, z0),
+                vec(xs[j + 1] * zr1, ys[j + 1] * zr1, z1),
+                vec(xs[j] * zr1, ys[j] * zr1, z1),
+            };
+            for (const vec &v : quad) {
+                mesh.vertices.push_back(v);
+                mesh.normals.push_back(v);
+            }
         }
-        glEnd();
     }
+
+    addPart(mesh, GL_QUADS, 0);
 }
 
-void drawBox(const vec &p1, const vec &p2, vvr::Colour col, char a)
+static void tessellateCylinder(vvr::UnitMesh &mesh, int segs)
 {
-    static vec p[8];
-    vec *v = p;
+    std::vector<float> xs(segs + 1), ys(segs + 1);
+    for (int i = 0; i <= segs; i++) {
+        math::SinCos(math::pi * 2 * i / segs, ys[i], xs[i]);
+    }
 
-    *v++ = vec(p1.x, p1.y, p1.z); //0
-    *v++ = vec(p1.x, p2.y, p1.z); //1
-    *v++ = vec(p1.x, p2.y, p2.z); //2
-    *v++ = vec(p1.x, p1.y, p2.z); //3
-    *v++ = vec(p2.x, p1.y, p1.z); //4
-    *v++ = vec(p2.x, p2.y, p1.z); //5
-    *v++ = vec(p2.x, p2.y, p2.z); //6
-    *v++ = vec(p2.x, p1.y, p2.z); //7
+    /* Base */
+    int first = static_cast<int>(mesh.vertices.size());
+    for (int i = 0; i < segs; i++) {
+        mesh.vertices.push_back(vec(xs[i], ys[i], 0));
+        mesh.normals.push_back(vec(0, 0, 1));
+    }
+    addPart(mesh, GL_POLYGON, first);
 
-    glPolygonMode(GL_FRONT_AND_BACK, a ? GL_FILL : GL_LINE);
-    glBegin(GL_QUADS);
+    /* Sides */
+    first = static_cast<int>(mesh.vertices.size());
+    for (int i = 0; i < segs; i++) {
+        const vec n0(xs[i], ys[i], 0);
+        const vec n1(xs[i + 1], ys[i + 1], 0);
+        mesh.vertices.push_back(n0);
+        mesh.vertices.push_back(vec(xs[i], ys[i], -1));
+        mesh.vertices.push_back(vec(xs[i + 1], ys[i + 1], -1));
+        mesh.vertices.push_back(n1);
+        mesh.normals.push_back(n0);
+        mesh.normals.push_back(n0);
+        mesh.normals.push_back(n1);
+        mesh.normals.push_back(n1);
+    }
+    addPart(mesh, GL_QUADS, first);
 
-    if (a) {
-        glColor4ub(col.r, col.g, col.b, a);
+    /* Top */
+    first = static_cast<int>(mesh.vertices.size());
+    for (int i = 0; i < segs; i++) {
+        mesh.vertices.push_back(vec(xs[i], ys[i], -1));
+        mesh.normals.push_back(vec(0, 0, -1));
     }
-    else {
-        glColor3ubv(col.data);
+    addPart(mesh, GL_POLYGON, first);
+}
+
+static void tessellateBox(vvr::UnitMesh &mesh)
+{
+    static const int faces[6][4] = {
+        { 0, 1, 2, 3 },
+        { 1, 2, 6, 5 },
+        { 4, 5, 6, 7 },
+        { 0, 4, 7, 3 },
+        { 2, 3, 7, 6 },
+        { 0, 1, 5, 4 },
+    };
+
+    static const vec p[8] = {
+        vec(0, 0, 0), vec(0, 1, 0), vec(0, 1, 1), vec(0, 0, 1),
+        vec(1, 0, 0), vec(1, 1, 0), vec(1, 1, 1), vec(1, 0, 1),
+    };
+
+    for (int f = 0; f < 6; f++) {
+        const vec n = (p[faces[f][1]] - p[faces[f][0]])
+            .Cross(p[faces[f][2]] - p[faces[f][0]]).Normalized();
+        const vec c = (p[faces[f][0]] + p[faces[f][2]]) * 0.5f;
+        const vec nout = n.Dot(c - vec(0.5f, 0.5f, 0.5f)) < 0 ? -n : n;
+        for (int k = 0; k < 4; k++) {
+            mesh.vertices.push_back(p[faces[f][k]]);
+            mesh.normals.push_back(nout);
+        }
+    }
+
+    addPart(mesh, GL_QUADS, 0);
+}
+
+static std::vector<vvr::UnitMesh> createUnitMeshes()
+{
+    std::vector<vvr::UnitMesh> meshes(vvr::UNIT_SHAPE_COUNT * vvr::LOD_COUNT);
+    for (int lod = 0; lod < vvr::LOD_COUNT; lod++) {
+        tessellateSphere(meshes[vvr::UNIT_SPHERE * vvr::LOD_COUNT + lod],
+            SphereLats[lod], SphereLongs[lod]);
+        tessellateCylinder(meshes[vvr::UNIT_CYLINDER * vvr::LOD_COUNT + lod],
+            CylinderSegs[lod]);
+        tessellateBox(meshes[vvr::UNIT_BOX * vvr::LOD_COUNT + lod]);
     }
+    return meshes;
+}
 
-    glVertex3fv(p[0].ptr());
-    glVertex3fv(p[1].ptr());
-    glVertex3fv(p[2].ptr());
-    glVertex3fv(p[3].ptr());
+const vvr::UnitMesh& vvr::getUnitMesh(UnitShape shape, Lod lod)
+{
+    static const std::vector<UnitMesh> meshes = createUnitMeshes();
+    return meshes[shape * LOD_COUNT + lod];
+}
 
-    glVertex3fv(p[1].ptr());
-    glVertex3fv(p[2].ptr());
-    glVertex3fv(p[6].ptr());
-    glVertex3fv(p[5].ptr());
+void vvr::UnitMesh::bind() const
+{
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(vec), vertices.data());
+    glNormalPointer(GL_FLOAT, sizeof(vec), normals.data());
+}
 
-    glVertex3fv(p[4].ptr());
-    glVertex3fv(p[5].ptr());
-    glVertex3fv(p[6].ptr());
-    glVertex3fv(p[7].ptr());
+void vvr::UnitMesh::unbind() const
+{
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-    glVertex3fv(p[0].ptr());
-    glVertex3fv(p[4].ptr());
-    glVertex3fv(p[7].ptr());
-    glVertex3fv(p[3].ptr());
+void vvr::UnitMesh::drawParts(unsigned part_mask) const
+{
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (part_mask & vvr_flag(i)) {
+            glDrawArrays(parts[i].mode, parts[i].first, parts[i].count);
+        }
+    }
+}
 
-    glVertex3fv(p[2].ptr());
-    glVertex3fv(p[3].ptr());
-    glVertex3fv(p[7].ptr());
-    glVertex3fv(p[6].ptr());
+static math::float4x4 boxTransform(const math::AABB &aabb)
+{
+    const vec size = aabb.Size();
+    math::float4x4 m = math::float4x4::Scale(size.x, size.y, size.z).ToFloat4x4();
+    m.SetTranslatePart(aabb.minPoint);
+    return m;
+}
 
-    glVertex3fv(p[0].ptr());
-    glVertex3fv(p[1].ptr());
-    glVertex3fv(p[5].ptr());
-    glVertex3fv(p[4].ptr());
+static math::float4x4 cylinderTransform(const vvr::Cylinder3D &cyl)
+{
+    math::float4x4 m = math::float4x4::RotateFromTo({ 0,0,1 }, cyl.normal);
+    m = m * math::float4x4::Scale(cyl.radius, cyl.radius, cyl.height).ToFloat4x4();
+    m.SetTranslatePart(cyl.basecenter);
+    return m;
+}
 
-    glEnd();
+static math::float4x4 sphereTransform(const math::Sphere &sphere)
+{
+    math::float4x4 m = math::float4x4::Scale(sphere.r, sphere.r, sphere.r).ToFloat4x4();
+    m.SetTranslatePart(sphere.pos);
+    return m;
+}
+
+static void drawUnitMesh(vvr::UnitShape shape, math::float4x4 m, unsigned part_mask = ~0u)
+{
+    m.Transpose();
+    glPushMatrix();
+    glMultMatrixf(m.ptr());
+    vvr::getUnitMesh(shape).draw(part_mask);
+    glPopMatrix();
 }
 
 void vvr::draw(C2DPointSet &point_set, Colour col)
@@ -293,68 +402,24 @@ void vvr::Triangle3D::drawShape() const
 
 void vvr::Cylinder3D::drawShape() const
 {
-    auto m = math::float4x4::RotateFromTo({ 0,0,1 }, normal);
-    m.SetTranslatePart(basecenter);
-    m.Transpose();
-
-    glPushMatrix();
-    glMultMatrixf(m.ptr());
-
-    /* Base */
-    glBegin(GL_POLYGON);
-    vec normalinv(-normal);
-    glNormal3fv(normalinv.ptr());
-    for (int i = 0; i <= 24; ++i) {
-        real x, y;
-        math::SinCos(math::pi * 2 / 24 * i, y, x);
-        glVertex3f(x*radius, y*radius, 0);
-    }
-    glEnd();
-
-    /* Sides */
-    if (sides)
-    {
-        glBegin(GL_TRIANGLE_STRIP);
-        for (int i = 0; i <= 24; ++i) {
-            real x, y;
-            math::SinCos(math::pi * 2 / 24 * i, y, x);
-            glNormal3f(x, y, 0);
-            glVertex3f(x*radius, y*radius, 0);
-            glVertex3f(x*radius, y*radius, -height);
-            math::SinCos(math::pi * 2 / 24 * (i + 1), y, x);
-            glNormal3f(x, y, 0);
-            glVertex3f(x*radius, y*radius, 0);
-            glVertex3f(x*radius, y*radius, -height);
-        }
-        glEnd();
-    }
-
-    /* Top */
-    glNormal3fv(normal.ptr());
-    glBegin(GL_POLYGON);
-    for (int i = 0; i <= 24; ++i) {
-        real x, y;
-        math::SinCos(math::pi * 2 / 24 * i, y, x);
-        glVertex3f(x*radius, y*radius, -height);
-    }
-    glEnd();
-
-    glPopMatrix();
+    drawUnitMesh(UNIT_CYLINDER, cylinderTransform(*this), sides ? ~0u : ~vvr_flag(1));
 }
 
 void vvr::Sphere3D::drawShape() const
 {
-    glPushMatrix();
-    glTranslatef(pos.x, pos.y, pos.z);
-    glScalef(r, r, r);
-    drawSphere(12, 15);
-    glPopMatrix();
+    drawUnitMesh(UNIT_SPHERE, sphereTransform(*this));
 }
 
 void vvr::Aabb3D::drawShape() const
 {
-    drawBox(minPoint, maxPoint, colour, 0);
-    drawBox(minPoint, maxPoint, colour, 255 - transparency * 255);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glColor3ubv(colour.data);
+    drawUnitMesh(UNIT_BOX, boxTransform(*this));
+    const unsigned char alpha = 255 - transparency * 255;
+    if (!alpha) return;
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glColor4ub(colour.r, colour.g, colour.b, alpha);
+    drawUnitMesh(UNIT_BOX, boxTransform(*this));
 }
 
 void vvr::Obb3D::drawShape() const
@@ -380,6 +445,29 @@ void vvr::Obb3D::drawShape() const
     vvr::Shape::PointSize = ptsz_old;
 }
 
+bool vvr::Obb3D::getBounds(math::AABB &aabb) const
+{
+    aabb.SetNegativeInfinity();
+    aabb.Enclose(static_cast<const math::OBB&>(*this));
+    return true;
+}
+
+bool vvr::Cylinder3D::getBounds(math::AABB &aabb) const
+{
+    /* Extent of a disk along each axis is r*sqrt(1-n_i^2) */
+    const vec e(
+        radius * math::Sqrt(math::Max(0.0f, 1 - normal.x * normal.x)),
+        radius * math::Sqrt(math::Max(0.0f, 1 - normal.y * normal.y)),
+        radius * math::Sqrt(math::Max(0.0f, 1 - normal.z * normal.z)));
+    const vec top = basecenter - normal * height; // Drawn towards -normal
+    aabb.SetNegativeInfinity();
+    aabb.Enclose(basecenter - e);
+    aabb.Enclose(basecenter + e);
+    aabb.Enclose(top - e);
+    aabb.Enclose(top + e);
+    return true;
+}
+
 vvr::Obb3D::Obb3D() : num_triverts(static_cast<size_t>(NumVerticesInTriangulation(1, 1, 1)))
 {
     colour = vvr::Colour("dd4311");
@@ -404,6 +492,7 @@ void vvr::Obb3D::set(const math::AABB& aabb, const math::float4x4& transform)
     for (size_t i = 0; i < NumVertices(); ++i) {
         cp[i].setGeom(CornerPoint(i));
     }
+    touch();
 }
 
 void vvr::Ground::draw() const
@@ -451,6 +540,16 @@ void vvr::Quad3D::draw() const
     vvr::Triangle3D(math::Triangle(v3, v4, v1), col).draw();
 }
 
+bool vvr::Quad3D::getBounds(math::AABB &aabb) const
+{
+    aabb.SetNegativeInfinity();
+    aabb.Enclose(pos + (+X * hsz.x + Y * hsz.y));
+    aabb.Enclose(pos + (+X * hsz.x - Y * hsz.y));
+    aabb.Enclose(pos + (-X * hsz.x - Y * hsz.y));
+    aabb.Enclose(pos + (-X * hsz.x + Y * hsz.y));
+    return true;
+}
+
 real vvr::Quad3D::pickdist(const math::Ray &ray) const
 {
     math::vec v1 = pos + (+X * hsz.x + Y * hsz.y);
@@ -466,8 +565,126 @@ real vvr::Quad3D::pickdist(const math::Ray &ray) const
     } else return real(-1);
 }
 
+/*---[InstanceBatch]--------------------------------------------------------------------*/
+void vvr::InstanceBatch::bake(UnitShape shape, const math::float4x4 &transform, Colour colour,
+    unsigned part_mask, int polygon_mode)
+{
+    const UnitMesh &mesh = getUnitMesh(shape, lod);
+    const math::float3x3 normal_matrix = transform.Float3x3Part().InverseTransposed();
+
+    auto emit = [&](Bucket &bucket, int i) {
+        bucket.vertices.push_back(transform.TransformPos(mesh.vertices[i]));
+        bucket.normals.push_back(normal_matrix.Transform(mesh.normals[i]).Normalized());
+        bucket.colours.push_back(colour);
+    };
+
+    for (size_t p = 0; p < mesh.parts.size(); p++) {
+        if (!(part_mask & vvr_flag(p))) continue;
+        const UnitMesh::Part &part = mesh.parts[p];
+        if (part.mode == GL_QUADS) {
+            Bucket &bucket = m_buckets[polygon_mode][QUADS];
+            for (int i = part.first; i < part.first + part.count; i++) emit(bucket, i);
+        } else {
+            /* Convex polygon (cylinder caps): as a triangle fan */
+            Bucket &bucket = m_buckets[polygon_mode][TRIANGLES];
+            for (int i = part.first + 1; i + 1 < part.first + part.count; i++) {
+                emit(bucket, part.first);
+                emit(bucket, i);
+                emit(bucket, i + 1);
+            }
+        }
+    }
+}
+
+void vvr::InstanceBatch::add(const Sphere3D &sphere)
+{
+    bake(UNIT_SPHERE, sphereTransform(sphere), sphere.colour, ~0u, sphere.filled ? FILL : LINE);
+    m_count++;
+}
+
+void vvr::InstanceBatch::add(const Cylinder3D &cylinder)
+{
+    bake(UNIT_CYLINDER, cylinderTransform(cylinder), cylinder.colour,
+        cylinder.sides ? ~0u : ~vvr_flag(1), cylinder.filled ? FILL : LINE);
+    m_count++;
+}
+
+void vvr::InstanceBatch::add(const Aabb3D &aabb)
+{
+    /* Outline opaque, then fill with the box alpha (like Aabb3D) */
+    const math::float4x4 transform = boxTransform(aabb);
+    Colour colour = aabb.colour;
+    colour.a = 255;
+    bake(UNIT_BOX, transform, colour, ~0u, LINE);
+    colour.a = 255 - aabb.transparency * 255;
+    if (colour.a) bake(UNIT_BOX, transform, colour, ~0u, FILL);
+    m_count++;
+}
+
+void vvr::InstanceBatch::clear()
+{
+    for (auto &buckets : m_buckets) {
+        for (auto &bucket : buckets) {
+            bucket.vertices.clear();
+            bucket.normals.clear();
+            bucket.colours.clear();
+        }
+    }
+    m_count = 0;
+}
+
+size_t vvr::InstanceBatch::size() const
+{
+    return m_count;
+}
+
+void vvr::InstanceBatch::draw() const
+{
+    static const GLenum modes[PRIMITIVES] = { GL_TRIANGLES, GL_QUADS };
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    /* Outlines first, so that translucent fills blend over them */
+    for (int polygon_mode : { LINE, FILL }) {
+        glPolygonMode(GL_FRONT_AND_BACK, polygon_mode == FILL ? GL_FILL : GL_LINE);
+        for (int prim = 0; prim < PRIMITIVES; prim++) {
+            const Bucket &bucket = m_buckets[polygon_mode][prim];
+            if (bucket.vertices.empty()) continue;
+            glVertexPointer(3, GL_FLOAT, sizeof(vec), bucket.vertices.data());
+            glNormalPointer(GL_FLOAT, sizeof(vec), bucket.normals.data());
+            glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Colour), bucket.colours.data());
+            glDrawArrays(modes[prim], 0, static_cast<GLsizei>(bucket.vertices.size()));
+        }
+    }
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 /*---[Canvas]---------------------------------------------------------------------------*/
-vvr::Canvas::Canvas() : fid(0) , del_on_clear(true)
+//! Display lists of released frames, of any canvas, waiting for a current GL context.
+static std::mutex s_stale_lists_mutex;
+static std::vector<unsigned> s_stale_lists;
+
+static void deleteListLater(unsigned list)
+{
+    std::lock_guard<std::mutex> lock(s_stale_lists_mutex);
+    s_stale_lists.push_back(list);
+}
+
+static void deleteStaleLists()
+{
+    if (!QOpenGLContext::currentContext()) return;
+    std::lock_guard<std::mutex> lock(s_stale_lists_mutex);
+    for (unsigned list : s_stale_lists) glDeleteLists(list, 1);
+    s_stale_lists.clear();
+}
+
+vvr::Canvas::Canvas() : fid(0) , del_on_clear(true), bake(false)
 {
     frames.reserve(16);
     frames.push_back(Frame(false));
@@ -475,18 +692,30 @@ vvr::Canvas::Canvas() : fid(0) , del_on_clear(true)
 
 vvr::Canvas::~Canvas()
 {
-    if (del_on_clear) {
-        for (int fid = 0; fid < frames.size(); fid++) {
-            for (int i = 0; i < frames[fid].drvec.size(); i++) {
-                delete frames[fid].drvec[i];
+    /* Without a current context, the next canvas drawn deletes the lists */
+    releaseFrames(0, frames.size());
+    deleteStaleLists();
+}
+
+void vvr::Canvas::releaseFrames(size_t from, size_t to)
+{
+    for (size_t fi = from; fi < to; fi++) {
+        if (del_on_clear) {
+            for (size_t si = 0; si < frames[fi].drvec.size(); si++) {
+                delete frames[fi].drvec[si];
             }
         }
+        if (frames[fi].list) {
+            deleteListLater(frames[fi].list);
+            frames[fi].list = 0;
+        }
     }
 }
 
 vvr::Drawable* vvr::Canvas::add(vvr::Drawable *drw)
 {
     frames[fid].drvec.push_back(drw);
+    frames[fid].signature = 0;
     return drw;
 }
 
@@ -496,15 +725,68 @@ void vvr::Canvas::newFrame(bool show_old_frames)
     ff();
 }
 
+void vvr::Canvas::invalidate()
+{
+    for (const Frame &frame : frames) {
+        frame.signature = 0;
+    }
+}
+
+static bool s_recording_frame = false;
+
+static size_t frameSignature(const std::vector<vvr::Drawable*> &drvec)
+{
+    /* Anything that changes what a recorded frame looks like must change
+     * the signature; drawables count their own changes in revision(). */
+    std::hash<const void*> hptr;
+    std::hash<float> hflt;
+    size_t h = hflt(vvr::Shape::LineWidth) ^ (hflt(vvr::Shape::PointSize) << 1);
+    for (const vvr::Drawable *drw : drvec) {
+        h ^= hptr(drw) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        h ^= drw->visible;
+        h ^= std::hash<unsigned>()(drw->revision()) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h | 1;
+}
+
+void vvr::Canvas::drawFrame(const Frame &frame, bool sealed) const
+{
+    if (!bake || !sealed || s_recording_frame) {
+        for (size_t i = 0; i < frame.drvec.size(); i++) {
+            frame.drvec[i]->drawif();
+        }
+        return;
+    }
+
+    const size_t signature = frameSignature(frame.drvec);
+
+    if (frame.list && frame.signature == signature) {
+        glCallList(frame.list);
+        return;
+    }
+
+    if (!frame.list) frame.list = glGenLists(1);
+    s_recording_frame = true;
+    glNewList(frame.list, GL_COMPILE_AND_EXECUTE);
+    for (size_t i = 0; i < frame.drvec.size(); i++) {
+        frame.drvec[i]->drawif();
+    }
+    glEndList();
+    s_recording_frame = false;
+    frame.signature = signature;
+}
+
 void vvr::Canvas::draw() const
 {
+    vvr_profile_scope("Canvas::draw");
+
+    deleteStaleLists();
+
     int fi = (int) fid;
     while (frames[fi].show_old && --fi > 0);
 
     while(fi <= fid) {
-        for (size_t i = 0; i < frames[fi].drvec.size(); i++) {
-            frames[fi].drvec[i]->drawif();
-        }
+        drawFrame(frames[fi], fi + 1 < (int) frames.size());
         fi++;
     }
 }
@@ -514,14 +796,7 @@ void vvr::Canvas::resize(int i)
     if (i<1 || i > size()-1)
         return;
 
-    if (del_on_clear) {
-        for (int fid = i; fid < frames.size(); fid++) {
-            for (int si = 0; si < frames[fid].drvec.size(); si++) {
-                delete frames[fid].drvec[si];
-            }
-        }
-    }
-
+    releaseFrames(i, frames.size());
     frames.resize(i);
     fid=i-1;
 }
@@ -533,28 +808,14 @@ void vvr::Canvas::truncate(int i)
 
     const int num_del = frames.size()-i;
 
-    if (del_on_clear) {
-        for (int fid = 0; fid < num_del; fid++) {
-            for (int si = 0; si < frames[fid].drvec.size(); si++) {
-                delete frames[fid].drvec[si];
-            }
-        }
-    }
-
+    releaseFrames(0, num_del);
     frames.erase(frames.begin(), frames.begin() + num_del);
     ff();
 }
 
 void vvr::Canvas::clear()
 {
-    if (del_on_clear) {
-        for (int fid = 0; fid < frames.size(); fid++) {
-            for (int si = 0; si < frames[fid].drvec.size(); si++) {
-                delete frames[fid].drvec[si];
-            }
-        }
-    }
-
+    releaseFrames(0, frames.size());
     frames.clear();
     frames.push_back(Frame(false));
     fid=0;
@@ -569,6 +830,7 @@ void vvr::Canvas::clearFrame()
     }
 
     frames[fid].drvec.clear();
+    frames[fid].signature = 0;
 }
 
 vvr::Drawable* vvr::Canvas::add(const C2DPoint &p, Colour col)
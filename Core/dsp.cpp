@@ -1,78 +1,273 @@
 #include <vvr/dsp.h>
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 
-vvr::dsp::Signal vvr::dsp::smooth(const Signal &in, size_t window_size)
+namespace {
+
+using vvr::dsp::Pipeline;
+
+//! Centered moving average, emitting the mean of sample i once sample i + hw
+//! has arrived. Same operations, in the same order, as a whole signal pass.
+class SmoothStage : public Pipeline::Stage
 {
-    Signal out(in.size());
+public:
+    explicit SmoothStage(size_t window_size)
+        : m_ring(window_size % 2 ? window_size : window_size + 1) // we need odd size
+    {
+        reset();
+    }
+
+    void reset() override { m_pos = 0; m_count = 0; m_sum = 0; }
+    size_t latency() const override { return m_ring.size() / 2; }
+
+    //! False while the output lags behind the input.
+    bool push(double x, double &y)
+    {
+        const size_t w = m_ring.size();
+        const size_t i = m_count++;
+        m_sum += x;
+        m_ring[m_pos] = x;
+        if (++m_pos == w) m_pos = 0;
+
+        if (i < w / 2) return false;
+        if (i + 1 < w) {
+            y = 0; // leading edge
+            return true;
+        }
+        y = m_sum / w;
+        m_sum -= m_ring[m_pos]; // the oldest sample leaves the window
+        return true;
+    }
+
+    size_t process(double *block, size_t n) override
+    {
+        const size_t w = m_ring.size();
+        size_t i = 0, m = 0;
+        double y;
+        for (; i < n && m_count + 1 < w; i++) {
+            if (push(block[i], y)) block[m++] = y;
+        }
+
+        //! Window full: same as push(), without the branches.
+        long double sum = m_sum;
+        size_t pos = m_pos;
+        double *ring = m_ring.data();
+        m_count += n - i;
+        for (; i < n; i++) {
+            const double x = block[i];
+            sum += x;
+            ring[pos] = x;
+            if (++pos == w) pos = 0;
+            block[m++] = sum / w;
+            sum -= ring[pos];
+        }
+        m_sum = sum;
+        m_pos = pos;
+        return m;
+    }
+
+    size_t finish(double *block) override
+    {
+        //! Trailing edge
+        const size_t n = std::min(latency(), m_count);
+        std::fill(block, block + n, 0.0);
+        return n;
+    }
+
+private:
+    std::vector<double> m_ring;
+    size_t      m_pos;
+    size_t      m_count;
+    long double m_sum;
+};
+
+class DiffStage : public Pipeline::Stage
+{
+public:
+    explicit DiffStage(size_t stride) : m_ring(stride ? stride : 1) { reset(); }
+
+    void reset() override { m_pos = 0; m_count = 0; m_first = 0; }
+
+    size_t process(double *block, size_t n) override
+    {
+        const size_t stride = m_ring.size();
+        size_t i = 0;
+        for (; i < n && m_count < stride; i++) {
+            const double x = block[i];
+            if (!m_count) m_first = x;
+            block[i] = ::fabs(x - m_first) / (m_count + 1);
+            m_count++;
+            m_ring[m_pos] = x;
+            if (++m_pos == stride) m_pos = 0;
+        }
 
-    if (window_size % 2 == 0) window_size++; // we need odd size
+        if (stride == 1) {
+            double last = m_ring[0];
+            for (; i < n; i++) {
+                const double x = block[i];
+                block[i] = ::fabs(x - last);
+                last = x;
+            }
+            m_ring[0] = last;
+            return n;
+        }
+
+        for (; i < n; i++) {
+            const double x = block[i];
+            block[i] = ::fabs(x - m_ring[m_pos]) / stride;
+            m_ring[m_pos] = x;
+            if (++m_pos == stride) m_pos = 0;
+        }
+        return n;
+    }
+
+private:
+    std::vector<double> m_ring;
+    size_t      m_pos;
+    size_t      m_count;
+    double      m_first;
+};
+
+class ThresholdStage : public Pipeline::Stage
+{
+public:
+    explicit ThresholdStage(double threshold) : m_threshold(threshold) { }
+
+    void reset() override { }
+
+    size_t process(double *block, size_t n) override
+    {
+        for (size_t i = 0; i < n; i++) block[i] = block[i] <= m_threshold ? 0 : 1;
+        return n;
+    }
+
+private:
+    double      m_threshold;
+};
+
+class ConsecutiveThresholdStage : public Pipeline::Stage
+{
+public:
+    explicit ConsecutiveThresholdStage(size_t max_cons_vals) : m_max(max_cons_vals), m_zc(0) { }
+
+    void reset() override { m_zc = 0; }
+
+    size_t process(double *block, size_t n) override
+    {
+        for (size_t i = 0; i < n; i++) {
+            m_zc = block[i] ? 0 : m_zc + 1;
+            block[i] = (m_zc < m_max);
+        }
+        return n;
+    }
+
+private:
+    size_t      m_max;
+    size_t      m_zc;
+};
 
-    const size_t hw = window_size / 2;
-    const size_t ie = in.size() - hw;
-    if (in.size() < hw) return out; // too big window
+class FilterStage : public Pipeline::Stage
+{
+public:
+    explicit FilterStage(std::shared_ptr<vvr::dsp::Filter> filter) : m_filter(std::move(filter)) { }
+
+    void reset() override { m_filter->reset(); }
 
-    for (size_t i = hw; i < ie; i++) {
-        long double sum = 0;
-        for (size_t j = i - hw; j <= i + hw; j++) sum += in[j];
-        out[i] = sum / window_size;
+    size_t process(double *block, size_t n) override
+    {
+        m_filter->process(block, block, n);
+        return n;
     }
 
+private:
+    std::shared_ptr<vvr::dsp::Filter> m_filter;
+};
+
+}
+
+/*---[Whole signal]-----------------------------------------------------------------*/
+
+vvr::dsp::Signal vvr::dsp::smooth(const Signal &in, size_t window_size)
+{
+    Signal out(in.size());
+    smooth(in, out, window_size);
     return out;
 }
 
+void vvr::dsp::smooth(SignalView in, SignalSpan out, size_t window_size)
+{
+    SmoothStage stage(window_size);
+    size_t k = 0;
+    double y;
+    for (size_t i = 0; i < in.size(); i++) {
+        if (stage.push(in[i], y)) out[k++] = y;
+    }
+    while (k < in.size()) out[k++] = 0;
+}
+
 vvr::dsp::Signal vvr::dsp::diff(const Signal &in, size_t stride)
 {
     Signal out(in.size());
+    diff(in, out, stride);
+    return out;
+}
 
-    if (!stride) stride = 1;
-    if (stride > in.size()) return out;
+void vvr::dsp::diff(SignalView in, SignalSpan out, size_t stride)
+{
+    const size_t n = in.size();
 
-    for (size_t i = 0; i < stride; i++) {
-        out[i] = ::fabs(in[i] - in[0]) / (i + 1);
+    if (!stride) stride = 1;
+    if (stride > n) {
+        for (size_t i = 0; i < n; i++) out[i] = 0;
+        return;
     }
 
-    for (size_t i = stride; i < in.size(); i++) {
+    //! Backwards, so that in place every sample is read before it is overwritten.
+    for (size_t i = n; i-- > stride; ) {
         out[i] = ::fabs(in[i] - in[i - stride]);
+        if (stride > 1) out[i] /= stride;
     }
 
-    if (stride > 1) {
-        for (size_t i = stride; i < in.size(); i++) {
-            out[i] /= stride;
-        }
+    for (size_t i = stride; i-- > 0; ) {
+        out[i] = ::fabs(in[i] - in[0]) / (i + 1);
     }
-
-    return out;
 }
 
 vvr::dsp::Signal vvr::dsp::threshold(const Signal &in, double threshold)
 {
-    Signal out(in);
+    Signal out(in.size());
+    vvr::dsp::threshold(in, out, threshold);
+    return out;
+}
 
-    for (int i = 0; i < in.size(); i++)
+void vvr::dsp::threshold(SignalView in, SignalSpan out, double threshold)
+{
+    for (size_t i = 0; i < in.size(); i++)
     {
         if (in[i] <= threshold)
             out[i] = 0;
         else
             out[i] = 1;
     }
-
-    return out;
 }
 
 vvr::dsp::Signal vvr::dsp::consecutive_threshold(const Signal &in, size_t max_cons_vals)
 {
-    Signal out(in);
+    Signal out(in.size());
+    consecutive_threshold(in, out, max_cons_vals);
+    return out;
+}
 
-    int zc = 0;
+void vvr::dsp::consecutive_threshold(SignalView in, SignalSpan out, size_t max_cons_vals)
+{
+    size_t zc = 0;
 
-    for (int i = 0; i < in.size(); i++)
+    for (size_t i = 0; i < in.size(); i++)
     {
         zc = in[i] ? 0 : zc + 1;
         out[i] = (zc < max_cons_vals);
     }
-
-    return out;
 }
 
 double vvr::dsp::interp_smooth_01(size_t i, size_t imax)
@@ -135,3 +330,303 @@ size_t vvr::dsp::detect_zero(const Signal &signal, size_t offset, double tol, bo
     }
     return offset;
 }
+
+/*---[Streaming filters]------------------------------------------------------------*/
+
+vvr::dsp::Signal vvr::dsp::Filter::apply(const Signal &in)
+{
+    Signal out(in.size());
+    if (!in.empty()) process(in.data(), out.data(), in.size());
+    return out;
+}
+
+vvr::dsp::MovingAverage::MovingAverage(size_t window)
+    : m_ring(window ? window : 1)
+{
+    reset();
+}
+
+void vvr::dsp::MovingAverage::reset()
+{
+    std::fill(m_ring.begin(), m_ring.end(), 0.0);
+    m_pos = 0;
+    m_count = 0;
+    m_sum = 0;
+    m_comp = 0;
+}
+
+double vvr::dsp::MovingAverage::step(double x)
+{
+    auto add = [this](double v) {
+        const double t = m_sum + v;
+        if (::fabs(m_sum) >= ::fabs(v)) m_comp += (m_sum - t) + v;
+        else m_comp += (v - t) + m_sum;
+        m_sum = t;
+    };
+
+    if (m_count == m_ring.size()) add(-m_ring[m_pos]);
+    else m_count++;
+    add(x);
+    m_ring[m_pos] = x;
+    if (++m_pos == m_ring.size()) m_pos = 0;
+    return (m_sum + m_comp) / m_count;
+}
+
+void vvr::dsp::MovingAverage::process(const double *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = step(in[i]);
+}
+
+vvr::dsp::Ema::Ema(double alpha)
+    : m_alpha(alpha)
+    , m_y(0)
+    , m_started(false)
+{
+}
+
+vvr::dsp::Ema vvr::dsp::Ema::fromTimeConstant(double tau_sec, double sample_rate)
+{
+    return Ema(1 - ::exp(-1 / (tau_sec * sample_rate)));
+}
+
+double vvr::dsp::Ema::step(double x)
+{
+    if (!m_started) {
+        m_started = true;
+        return m_y = x;
+    }
+    return m_y += m_alpha * (x - m_y);
+}
+
+void vvr::dsp::Ema::process(const double *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = step(in[i]);
+}
+
+vvr::dsp::Biquad::Biquad(double b0, double b1, double b2, double a1, double a2)
+    : m_b0(b0), m_b1(b1), m_b2(b2), m_a1(a1), m_a2(a2)
+    , m_z1(0), m_z2(0)
+{
+}
+
+namespace {
+
+//! RBJ audio EQ cookbook. Coefficients normalized by a0.
+vvr::dsp::Biquad rbj(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    return vvr::dsp::Biquad(b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0);
+}
+
+void rbj_params(double f, double fs, double q, double &cosw, double &alpha)
+{
+    const double w = 2 * 3.14159265358979323846 * f / fs;
+    cosw = ::cos(w);
+    alpha = ::sin(w) / (2 * q);
+}
+
+}
+
+vvr::dsp::Biquad vvr::dsp::Biquad::lowpass(double cutoff, double sample_rate, double q)
+{
+    double c, a;
+    rbj_params(cutoff, sample_rate, q, c, a);
+    return rbj((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + a, -2 * c, 1 - a);
+}
+
+vvr::dsp::Biquad vvr::dsp::Biquad::highpass(double cutoff, double sample_rate, double q)
+{
+    double c, a;
+    rbj_params(cutoff, sample_rate, q, c, a);
+    return rbj((1 + c) / 2, -(1 + c), (1 + c) / 2, 1 + a, -2 * c, 1 - a);
+}
+
+vvr::dsp::Biquad vvr::dsp::Biquad::bandpass(double center, double sample_rate, double q)
+{
+    double c, a;
+    rbj_params(center, sample_rate, q, c, a);
+    return rbj(a, 0, -a, 1 + a, -2 * c, 1 - a);
+}
+
+vvr::dsp::Biquad vvr::dsp::Biquad::notch(double center, double sample_rate, double q)
+{
+    double c, a;
+    rbj_params(center, sample_rate, q, c, a);
+    return rbj(1, -2 * c, 1, 1 + a, -2 * c, 1 - a);
+}
+
+double vvr::dsp::Biquad::step(double x)
+{
+    const double y = m_b0 * x + m_z1;
+    m_z1 = m_b1 * x - m_a1 * y + m_z2;
+    m_z2 = m_b2 * x - m_a2 * y;
+    return y;
+}
+
+void vvr::dsp::Biquad::process(const double *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = step(in[i]);
+}
+
+vvr::dsp::MovingMedian::MovingMedian(size_t window)
+    : m_ring(window ? window : 1)
+{
+    reset();
+}
+
+void vvr::dsp::MovingMedian::reset()
+{
+    m_pos = 0;
+    m_count = 0;
+    m_low.clear();
+    m_high.clear();
+}
+
+void vvr::dsp::MovingMedian::rebalance()
+{
+    while (m_low.size() > m_high.size() + 1) {
+        auto top = std::prev(m_low.end());
+        m_high.insert(*top);
+        m_low.erase(top);
+    }
+    while (m_high.size() > m_low.size()) {
+        auto bottom = m_high.begin();
+        m_low.insert(*bottom);
+        m_high.erase(bottom);
+    }
+}
+
+double vvr::dsp::MovingMedian::step(double x)
+{
+    //! Insert first, then drop the oldest sample from whichever half holds
+    //! it; any copy of an equal value will do. Dropping it first could empty
+    //! the low half and misplace x.
+    if (!m_low.empty() ? x <= *m_low.rbegin() : m_high.empty() || x < *m_high.begin()) m_low.insert(x);
+    else m_high.insert(x);
+
+    if (m_count == m_ring.size()) {
+        const double old = m_ring[m_pos];
+        auto it = m_low.find(old);
+        if (it != m_low.end()) m_low.erase(it);
+        else m_high.erase(m_high.find(old));
+    }
+    else m_count++;
+    rebalance();
+
+    m_ring[m_pos] = x;
+    if (++m_pos == m_ring.size()) m_pos = 0;
+
+    if (m_low.size() > m_high.size()) return *m_low.rbegin();
+    return (*m_low.rbegin() + *m_high.begin()) / 2;
+}
+
+void vvr::dsp::MovingMedian::process(const double *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = step(in[i]);
+}
+
+vvr::dsp::Derivative::Derivative(size_t stride, double sample_rate)
+    : m_ring(stride ? stride : 1)
+    , m_rate(sample_rate)
+{
+    reset();
+}
+
+void vvr::dsp::Derivative::reset()
+{
+    m_pos = 0;
+    m_count = 0;
+}
+
+double vvr::dsp::Derivative::step(double x)
+{
+    //! m_ring holds the last `stride` samples; m_pos is the oldest of them.
+    double y = 0;
+    if (m_count == m_ring.size()) {
+        y = (x - m_ring[m_pos]) * m_rate / m_ring.size();
+    }
+    else if (m_count) {
+        y = (x - m_ring[0]) * m_rate / m_count;
+    }
+    if (m_count < m_ring.size()) m_count++;
+
+    m_ring[m_pos] = x;
+    if (++m_pos == m_ring.size()) m_pos = 0;
+    return y;
+}
+
+void vvr::dsp::Derivative::process(const double *in, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = step(in[i]);
+}
+
+/*---[Pipeline]---------------------------------------------------------------------*/
+
+vvr::dsp::Pipeline::Pipeline() : m_block(BlockSize)
+{
+}
+
+vvr::dsp::Pipeline::~Pipeline() = default;
+vvr::dsp::Pipeline::Pipeline(Pipeline &&) = default;
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::operator=(Pipeline &&) = default;
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::add(std::unique_ptr<Stage> stage)
+{
+    //! Room for what every stage may hold back, so finish() fits in the block.
+    m_block.resize(m_block.size() + stage->latency());
+    m_stages.push_back(std::move(stage));
+    return *this;
+}
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::diff(size_t stride)
+{
+    return add(std::unique_ptr<Stage>(new DiffStage(stride)));
+}
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::smooth(size_t window_size)
+{
+    return add(std::unique_ptr<Stage>(new SmoothStage(window_size)));
+}
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::threshold(double threshold)
+{
+    return add(std::unique_ptr<Stage>(new ThresholdStage(threshold)));
+}
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::consecutive_threshold(size_t max_cons_vals)
+{
+    return add(std::unique_ptr<Stage>(new ConsecutiveThresholdStage(max_cons_vals)));
+}
+
+vvr::dsp::Pipeline &vvr::dsp::Pipeline::filter(std::shared_ptr<Filter> filter)
+{
+    return add(std::unique_ptr<Stage>(new FilterStage(std::move(filter))));
+}
+
+vvr::dsp::Signal vvr::dsp::Pipeline::run(const Signal &in)
+{
+    Signal out(in.size());
+    run(SignalView(in), SignalSpan(out));
+    return out;
+}
+
+void vvr::dsp::Pipeline::reset()
+{
+    for (auto &stage : m_stages) stage->reset();
+}
+
+size_t vvr::dsp::Pipeline::pass(double *block, size_t n)
+{
+    for (auto &stage : m_stages) n = stage->process(block, n);
+    return n;
+}
+
+size_t vvr::dsp::Pipeline::finish(double *block)
+{
+    //! What a stage held back still has to go through the stages after it.
+    size_t n = 0;
+    for (auto &stage : m_stages) {
+        n = stage->process(block, n);
+        n += stage->finish(block + n);
+    }
+    return n;
+}
@@ -0,0 +1,393 @@
+#include <vvr/fft.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+const size_t MaxRadix = 31;     //! Larger prime factors go through Bluestein
+
+vvr::dsp::Complex unit(double angle)
+{
+    return vvr::dsp::Complex(::cos(angle), ::sin(angle));
+}
+
+//! Plain product. std::complex operator* checks for inf / nan, which is slow.
+inline vvr::dsp::Complex mul(const vvr::dsp::Complex &a, const vvr::dsp::Complex &b)
+{
+    return vvr::dsp::Complex(
+        a.real() * b.real() - a.imag() * b.imag(),
+        a.real() * b.imag() + a.imag() * b.real());
+}
+
+}
+
+/*---[FftPlan]----------------------------------------------------------------------*/
+
+vvr::dsp::FftPlan::FftPlan(size_t n) : m_n(n)
+{
+    if (n <= 1) return;
+
+    m_twiddles.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        m_twiddles[k] = unit(-2 * Pi * k / n);
+    }
+
+    //! Radix 4 first, then 2, 3, 5, ...
+    size_t rest = n;
+    size_t p = 4;
+    while (rest > 1) {
+        while (rest % p) {
+            switch (p) {
+            case 4: p = 2; break;
+            case 2: p = 3; break;
+            default: p += 2; break;
+            }
+            if (p * p > rest) p = rest;
+        }
+        rest /= p;
+        m_factors.push_back(p);
+        m_factors.push_back(rest);
+    }
+
+    size_t largest = 0;
+    for (size_t i = 0; i < m_factors.size(); i += 2) largest = std::max(largest, m_factors[i]);
+
+    if (largest > MaxRadix) {
+        m_factors.clear();
+        size_t m = 1;
+        while (m < 2 * n - 1) m *= 2;
+        m_conv = get(m);
+
+        m_chirp.resize(n);
+        for (size_t k = 0; k < n; k++) {
+            //! k^2 mod 2n keeps the angle small, and precise.
+            const unsigned long long k2 = (unsigned long long)k * k % (2 * n);
+            m_chirp[k] = unit(-Pi * k2 / n);
+        }
+
+        Spectrum b(m);
+        b[0] = std::conj(m_chirp[0]);
+        for (size_t k = 1; k < n; k++) {
+            b[k] = b[m - k] = std::conj(m_chirp[k]);
+        }
+        m_chirp_fft.resize(m);
+        m_conv->forward(b.data(), m_chirp_fft.data());
+    }
+
+    if (n % 2 == 0) {
+        m_half = get(n / 2);
+        m_real_twiddles.resize(n / 2 + 1);
+        for (size_t k = 0; k <= n / 2; k++) {
+            m_real_twiddles[k] = unit(-2 * Pi * k / n);
+        }
+    }
+}
+
+vvr::dsp::FftPlan::~FftPlan()
+{
+}
+
+std::shared_ptr<const vvr::dsp::FftPlan> vvr::dsp::FftPlan::get(size_t n)
+{
+    static std::mutex mutex;
+    static std::map<size_t, std::shared_ptr<const FftPlan>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(n);
+        if (it != cache.end()) return it->second;
+    }
+
+    //! Built unlocked: a plan may get() the plans it is made of.
+    auto plan = std::make_shared<const FftPlan>(n);
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.emplace(n, plan).first->second;
+}
+
+void vvr::dsp::FftPlan::forward(const Complex *in, Complex *out) const
+{
+    if (in == out && m_n > 1) {
+        const Spectrum tmp(in, in + m_n);
+        transform(tmp.data(), out);
+    }
+    else transform(in, out);
+}
+
+void vvr::dsp::FftPlan::inverse(const Complex *in, Complex *out) const
+{
+    //! ifft(x) = conj(fft(conj(x))) / n
+    Spectrum tmp(m_n);
+    for (size_t i = 0; i < m_n; i++) tmp[i] = std::conj(in[i]);
+    transform(tmp.data(), out);
+    const double scale = 1.0 / m_n;
+    for (size_t i = 0; i < m_n; i++) out[i] = std::conj(out[i]) * scale;
+}
+
+void vvr::dsp::FftPlan::transform(const Complex *in, Complex *out) const
+{
+    if (m_n <= 1) {
+        if (m_n) out[0] = in[0];
+    }
+    else if (m_conv) {
+        bluestein(in, out);
+    }
+    else {
+        work(out, in, 1, m_factors.data());
+    }
+}
+
+//! Decimation in time, after KISS FFT: transform the p interleaved
+//! sub-sequences of length m, then combine them with radix p butterflies.
+void vvr::dsp::FftPlan::work(Complex *out, const Complex *in, size_t fstride, const size_t *factors) const
+{
+    const size_t p = factors[0];
+    const size_t m = factors[1];
+
+    if (m == 1) {
+        for (size_t k = 0; k < p; k++) out[k] = in[k * fstride];
+    }
+    else {
+        for (size_t k = 0; k < p; k++) {
+            work(out + k * m, in + k * fstride, fstride * p, factors + 2);
+        }
+    }
+
+    switch (p) {
+    case 2: butterfly2(out, fstride, m); break;
+    case 3: butterfly3(out, fstride, m); break;
+    case 4: butterfly4(out, fstride, m); break;
+    default: butterfly(out, fstride, m, p); break;
+    }
+}
+
+void vvr::dsp::FftPlan::butterfly2(Complex *out, size_t fstride, size_t m) const
+{
+    Complex *out2 = out + m;
+    for (size_t k = 0; k < m; k++) {
+        const Complex t = mul(out2[k], m_twiddles[k * fstride]);
+        out2[k] = out[k] - t;
+        out[k] += t;
+    }
+}
+
+void vvr::dsp::FftPlan::butterfly3(Complex *out, size_t fstride, size_t m) const
+{
+    const double epi3 = m_twiddles[fstride * m].imag(); // -sin(2 pi / 3)
+    for (size_t k = 0; k < m; k++) {
+        const Complex s1 = mul(out[k + m], m_twiddles[k * fstride]);
+        const Complex s2 = mul(out[k + 2 * m], m_twiddles[2 * k * fstride]);
+        const Complex s3 = s1 + s2;
+        const Complex s0 = (s1 - s2) * epi3;
+        const Complex a = out[k] - s3 * 0.5;
+        out[k] += s3;
+        out[k + 2 * m] = Complex(a.real() + s0.imag(), a.imag() - s0.real());
+        out[k + m] = Complex(a.real() - s0.imag(), a.imag() + s0.real());
+    }
+}
+
+void vvr::dsp::FftPlan::butterfly4(Complex *out, size_t fstride, size_t m) const
+{
+    for (size_t k = 0; k < m; k++) {
+        const Complex s0 = mul(out[k + m], m_twiddles[k * fstride]);
+        const Complex s1 = mul(out[k + 2 * m], m_twiddles[2 * k * fstride]);
+        const Complex s2 = mul(out[k + 3 * m], m_twiddles[3 * k * fstride]);
+        const Complex s5 = out[k] - s1;
+        const Complex a = out[k] + s1;
+        const Complex s3 = s0 + s2;
+        const Complex s4 = s0 - s2;
+        out[k + 2 * m] = a - s3;
+        out[k] = a + s3;
+        out[k + m] = Complex(s5.real() + s4.imag(), s5.imag() - s4.real());
+        out[k + 3 * m] = Complex(s5.real() - s4.imag(), s5.imag() + s4.real());
+    }
+}
+
+void vvr::dsp::FftPlan::butterfly(Complex *out, size_t fstride, size_t m, size_t p) const
+{
+    Complex scratch[MaxRadix];
+    for (size_t u = 0; u < m; u++) {
+        for (size_t q = 0, k = u; q < p; q++, k += m) scratch[q] = out[k];
+
+        for (size_t q1 = 0, k = u; q1 < p; q1++, k += m) {
+            const size_t step = fstride * k % m_n;
+            size_t tw = 0;
+            Complex sum = scratch[0];
+            for (size_t q = 1; q < p; q++) {
+                tw += step;
+                if (tw >= m_n) tw -= m_n;
+                sum += mul(scratch[q], m_twiddles[tw]);
+            }
+            out[k] = sum;
+        }
+    }
+}
+
+//! X[k] = w[k] (a * b)[k], with a[j] = x[j] w[j], b[j] = conj(w[j]) and
+//! w[k] = e^(-pi i k^2 / n): a circular convolution on a power of 2.
+void vvr::dsp::FftPlan::bluestein(const Complex *in, Complex *out) const
+{
+    const size_t m = m_conv->size();
+    Spectrum a(m);
+    for (size_t k = 0; k < m_n; k++) a[k] = mul(in[k], m_chirp[k]);
+    m_conv->forward(a.data(), a.data());
+    for (size_t k = 0; k < m; k++) a[k] = mul(a[k], m_chirp_fft[k]);
+    m_conv->inverse(a.data(), a.data());
+    for (size_t k = 0; k < m_n; k++) out[k] = mul(a[k], m_chirp[k]);
+}
+
+void vvr::dsp::FftPlan::forwardReal(const double *in, Complex *out) const
+{
+    if (!m_half) {
+        //! Odd size: as a complex transform.
+        Spectrum x(in, in + m_n), X(m_n);
+        transform(x.data(), X.data());
+        std::copy(X.begin(), X.begin() + m_n / 2 + 1, out);
+        return;
+    }
+
+    //! Even and odd samples as real and imaginary parts, transformed at
+    //! half size, then untangled: X[k] = E[k] + e^(-2 pi i k / n) O[k].
+    const size_t h = m_n / 2;
+    Spectrum z(h);
+    for (size_t j = 0; j < h; j++) z[j] = Complex(in[2 * j], in[2 * j + 1]);
+    m_half->transform(z.data(), out);
+
+    const Complex z0 = out[0];
+    out[0] = Complex(z0.real() + z0.imag(), 0);
+    out[h] = Complex(z0.real() - z0.imag(), 0);
+
+    for (size_t k = 1; k <= h / 2; k++) {
+        const size_t j = h - k;
+        const Complex zk = out[k];
+        const Complex zj = out[j];
+        const Complex e = (zk + std::conj(zj)) * 0.5;
+        const Complex d = (zk - std::conj(zj)) * 0.5;
+        const Complex o(d.imag(), -d.real()); // -i d
+        out[k] = e + mul(m_real_twiddles[k], o);
+        out[j] = std::conj(e) + mul(m_real_twiddles[j], std::conj(o));
+    }
+}
+
+void vvr::dsp::FftPlan::inverseReal(const Complex *in, double *out) const
+{
+    if (!m_half) {
+        //! Odd size: rebuild the conjugate symmetric half.
+        Spectrum X(m_n), x(m_n);
+        for (size_t k = 0; k < m_n; k++) {
+            X[k] = k <= m_n / 2 ? in[k] : std::conj(in[m_n - k]);
+        }
+        inverse(X.data(), x.data());
+        for (size_t k = 0; k < m_n; k++) out[k] = x[k].real();
+        return;
+    }
+
+    const size_t h = m_n / 2;
+    Spectrum z(h), x(h);
+    for (size_t k = 0; k < h; k++) {
+        const Complex xk = in[k];
+        const Complex xj = std::conj(in[h - k]);
+        const Complex e = (xk + xj) * 0.5;
+        const Complex o = mul((xk - xj) * 0.5, std::conj(m_real_twiddles[k]));
+        z[k] = e + Complex(-o.imag(), o.real()); // e + i o
+    }
+    m_half->inverse(z.data(), x.data());
+    for (size_t j = 0; j < h; j++) {
+        out[2 * j] = x[j].real();
+        out[2 * j + 1] = x[j].imag();
+    }
+}
+
+/*---[Functions]--------------------------------------------------------------------*/
+
+vvr::dsp::Spectrum vvr::dsp::fft(const Spectrum &in)
+{
+    Spectrum out(in.size());
+    if (!in.empty()) FftPlan::get(in.size())->forward(in.data(), out.data());
+    return out;
+}
+
+vvr::dsp::Spectrum vvr::dsp::ifft(const Spectrum &in)
+{
+    Spectrum out(in.size());
+    if (!in.empty()) FftPlan::get(in.size())->inverse(in.data(), out.data());
+    return out;
+}
+
+vvr::dsp::Spectrum vvr::dsp::rfft(const Signal &in)
+{
+    if (in.empty()) return Spectrum();
+    Spectrum out(in.size() / 2 + 1);
+    FftPlan::get(in.size())->forwardReal(in.data(), out.data());
+    return out;
+}
+
+vvr::dsp::Signal vvr::dsp::irfft(const Spectrum &in, size_t n)
+{
+    Signal out(n);
+    if (!n || in.size() < n / 2 + 1) return out;
+    FftPlan::get(n)->inverseReal(in.data(), out.data());
+    return out;
+}
+
+void vvr::dsp::rfft_channels(const double *interleaved, size_t frames, size_t channels, std::vector<Spectrum> &out)
+{
+    out.resize(channels);
+    if (!frames) return;
+
+    const auto plan = FftPlan::get(frames);
+    Signal channel(frames);
+    for (size_t c = 0; c < channels; c++) {
+        for (size_t i = 0; i < frames; i++) channel[i] = interleaved[i * channels + c];
+        out[c].resize(frames / 2 + 1);
+        plan->forwardReal(channel.data(), out[c].data());
+    }
+}
+
+vvr::dsp::Signal vvr::dsp::convolve(const Signal &in, const Signal &kernel, bool same_size)
+{
+    if (in.empty() || kernel.empty()) return Signal(same_size ? in.size() : 0);
+
+    const size_t n = in.size() + kernel.size() - 1;
+    Signal full(n);
+
+    if (std::min(in.size(), kernel.size()) <= 32) {
+        for (size_t i = 0; i < in.size(); i++) {
+            for (size_t j = 0; j < kernel.size(); j++) {
+                full[i + j] += in[i] * kernel[j];
+            }
+        }
+    }
+    else {
+        //! A power of 2 runs fastest, with radix 4 and half size real transforms.
+        size_t size = 2;
+        while (size < n) size *= 2;
+        const auto plan = FftPlan::get(size);
+        Signal a(size), b(size);
+        std::copy(in.begin(), in.end(), a.begin());
+        std::copy(kernel.begin(), kernel.end(), b.begin());
+        Spectrum A(size / 2 + 1), B(size / 2 + 1);
+        plan->forwardReal(a.data(), A.data());
+        plan->forwardReal(b.data(), B.data());
+        for (size_t k = 0; k < A.size(); k++) A[k] = mul(A[k], B[k]);
+        plan->inverseReal(A.data(), a.data());
+        std::copy(a.begin(), a.begin() + n, full.begin());
+    }
+
+    if (!same_size) return full;
+    const size_t offset = (kernel.size() - 1) / 2;
+    return Signal(full.begin() + offset, full.begin() + offset + in.size());
+}
+
+size_t vvr::dsp::fft_fast_size(size_t n)
+{
+    for (size_t m = std::max<size_t>(n, 1); ; m++) {
+        size_t r = m;
+        while (r % 2 == 0) r /= 2;
+        while (r % 3 == 0) r /= 3;
+        while (r % 5 == 0) r /= 5;
+        if (r == 1) return m;
+    }
+}
@@ -1,10 +1,14 @@
 #include <QApplication>
 #include <QMouseEvent>
 #include <QOpenGLContext>
+#include <QScreen>
 #include <QTimer>
 #include <QtGui> //gl.h
+#include <algorithm>
+#include <iostream>
 #include <vvr/glwidget.h>
 #include <vvr/macros.h>
+#include <vvr/profiler.h>
 #include <vvr/scene.h>
 
 #define DISABLE_PRINTS 1
@@ -28,6 +32,28 @@ static int make_modifier_flag(QInputEvent *event)
     return modif;
 }
 
+static vvr::InputEvent mouse_event(vvr::InputEvent::Type type, int x, int y, QInputEvent *event)
+{
+    vvr::InputEvent e;
+    e.type = type;
+    e.x = x;
+    e.y = y;
+    e.modif = make_modifier_flag(event);
+    e.time = event->timestamp() / 1000.0;
+    return e;
+}
+
+static vvr::InputEvent key_event(vvr::InputEvent::Type type, int key, bool pressed, QInputEvent *event)
+{
+    vvr::InputEvent e;
+    e.type = type;
+    e.key = key;
+    e.up = !pressed;
+    e.modif = make_modifier_flag(event);
+    e.time = event->timestamp() / 1000.0;
+    return e;
+}
+
 void vvr::get_mouse_xy(int &x, int &y)
 {
     QPoint p = s_widget_ptr->mapFromGlobal(QCursor::pos());
@@ -40,10 +66,19 @@ vvr::GlWidget::GlWidget(vvr::Scene *scene, QWidget *parent) : QOpenGLWidget(pare
 {
     s_widget_ptr = this;
     m_scene = scene;
+    m_animating = false;
+    m_frame_pending = false;
+    m_dirty = false;
+    m_clock.start();
+    m_last_tick = -1000;
     m_timer.setSingleShot(true);
-    connect(&m_timer, SIGNAL(timeout()), this, SLOT(idle()));
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
+    m_swap_timer.setSingleShot(true);
+    connect(&m_swap_timer, SIGNAL(timeout()), this, SLOT(onSwapTimeout()));
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
     setMouseTracking(true);
-    m_timer.start(100);
+    idle();
 }
 
 void vvr::GlWidget::setScene(vvr::Scene *scene)
@@ -62,7 +97,9 @@ void vvr::GlWidget::initializeGL()
 void vvr::GlWidget::paintGL()
 {
     vvr_echo_time_from_function("In");
+    Profiler::beginFrame();
     m_scene->glRender();
+    Profiler::endFrame();
     vvr_echo_time_from_function("Out");
 }
 
@@ -72,24 +109,81 @@ void vvr::GlWidget::resizeGL(int width, int height)
     m_scene->glResize(width * s_dpr, height * s_dpr);
 }
 
-/*---[Events]---------------------------------------------------------------------------*/
+void vvr::GlWidget::showEvent(QShowEvent *event)
+{
+    QOpenGLWidget::showEvent(event);
+    //! Frames requested while hidden may never have been swapped.
+    if (!m_timer.isActive()) m_frame_pending = false;
+    idle();
+}
+
+/*---[Frame scheduling]-----------------------------------------------------------------
+ * Requests made while a frame is pending are merged into it. Ticks are paced to the
+ * frame budget, and an animating scene gets its next tick only after the previous
+ * frame was swapped, so it never runs ahead of the display. With nothing to do,
+ * no timer is running at all. Qt drops repaints of hidden or obscured widgets, so
+ * a frame that isn't swapped within a few budgets counts as swapped.
+ */
 void vvr::GlWidget::idle()
 {
-    if (!m_scene->idle()) {
-        m_timer.stop();
-    } else if (!m_timer.isActive()) {
-        m_timer.start(0);
+    if (m_frame_pending) {
+        m_dirty = true;
+        return;
     }
+    m_frame_pending = true;
+    m_dirty = false;
+    const qint64 wait = m_last_tick + frameBudget() - m_clock.elapsed();
+    m_timer.start(wait > 0 ? (int)wait : 0);
+}
+
+void vvr::GlWidget::tick()
+{
+    m_last_tick = m_clock.elapsed();
+    m_dirty = false;
+    vvr_profile_scope("idle");
+    m_animating = m_scene->advance();
     update();
+    m_swap_timer.start(std::max(100, 4 * frameBudget()));
 }
 
+void vvr::GlWidget::onFrameSwapped()
+{
+    m_swap_timer.stop();
+    m_frame_pending = false;
+    if (m_animating || m_dirty) idle();
+}
+
+void vvr::GlWidget::onSwapTimeout()
+{
+    if (!m_frame_pending || m_timer.isActive()) return;
+    onFrameSwapped();
+}
+
+void vvr::GlWidget::setTargetFps(float fps)
+{
+    m_scene->setTargetFps(fps);
+    if (m_timer.isActive()) {
+        const qint64 wait = m_last_tick + frameBudget() - m_clock.elapsed();
+        m_timer.start(wait > 0 ? (int)wait : 0);
+    }
+}
+
+int vvr::GlWidget::frameBudget() const
+{
+    float fps = m_scene->getTargetFps();
+    if (fps <= 0 && screen()) fps = screen()->refreshRate();
+    if (fps <= 0) fps = 60;
+    return (int)(1000.0f / fps);
+}
+
+/*---[Events]---------------------------------------------------------------------------*/
 void vvr::GlWidget::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
         int x = event->position().x() * s_dpr;
         int y = event->position().y() * s_dpr;
         m_scene->mouse2pix(x, y);
-        m_scene->mousePressed(x, y, make_modifier_flag(event));
+        m_scene->dispatch(mouse_event(InputEvent::MousePress, x, y, event));
         setFocus();
         idle();
     }
@@ -101,7 +195,7 @@ void vvr::GlWidget::mouseReleaseEvent(QMouseEvent *event)
         int x = event->position().x() * s_dpr;
         int y = event->position().y() * s_dpr;
         m_scene->mouse2pix(x, y);
-        m_scene->mouseReleased(x, y, make_modifier_flag(event));
+        m_scene->dispatch(mouse_event(InputEvent::MouseRelease, x, y, event));
         setFocus();
         idle();
     }
@@ -115,21 +209,21 @@ void vvr::GlWidget::mouseMoveEvent(QMouseEvent *event)
     m_scene->mouse2pix(x, y);
 
     if (event->buttons() & Qt::LeftButton) {
-        m_scene->mouseMoved(x, y, make_modifier_flag(event));
+        m_scene->dispatch(mouse_event(InputEvent::MouseMove, x, y, event));
     } else if (event->buttons() == Qt::NoButton) {
-        m_scene->mouseHovered(x, y, make_modifier_flag(event));
+        m_scene->dispatch(mouse_event(InputEvent::MouseHover, x, y, event));
     } else {
         return event->ignore();
     }
 
-    update();
+    idle();
     event->accept();
     vvr_echo_time_from_function("Out");
 }
 
 void vvr::GlWidget::wheelEvent(QWheelEvent *event)
 {
-    m_scene->mouseWheel(event->angleDelta().y() > 0? 1: -1, make_modifier_flag(event));
+    m_scene->dispatch(mouse_event(InputEvent::MouseWheel, event->angleDelta().y() > 0? 1: -1, 0, event));
     idle();
 }
 
@@ -145,22 +239,27 @@ void vvr::GlWidget::keyEventCore(QKeyEvent *event, bool pressed)
 
     if (event->key() == Qt::Key_Escape) {
         QApplication::quit();
+    } else if (event->key() == Qt::Key_F12) {
+        if (pressed && (modif & 1)) {
+            const std::string filename = "vvr_trace.json";
+            if (Profiler::exportChromeTrace(filename)) vvr_msg("Profiler trace written to " << filename);
+        } else if (pressed) {
+            const bool on = !Profiler::enabled();
+            Profiler::setEnabled(on);
+            Profiler::setOverlayVisible(on);
+        }
     } else if (event->key() >= Qt::Key_A && event->key() <= Qt::Key_Z) {
-        m_scene->keyEvent(tolower(event->key()), !pressed, modif);
+        m_scene->dispatch(key_event(InputEvent::Key, tolower(event->key()), pressed, event));
     } else if (txt.length() > 0) {
-        m_scene->keyEvent(txt.toStdString()[0], !pressed, modif);
+        m_scene->dispatch(key_event(InputEvent::Key, (unsigned char)txt.toStdString()[0], pressed, event));
     } else if (event->key() == Qt::Key_Left) {
-        if (pressed) m_scene->arrowEvent(vvr::LEFT, modif);
-        m_scene->m_arrow_state[vvr::LEFT] = pressed;
+        m_scene->dispatch(key_event(InputEvent::Arrow, vvr::LEFT, pressed, event));
     } else if (event->key() == Qt::Key_Right) {
-        if (pressed) m_scene->arrowEvent(vvr::RIGHT, modif);
-        m_scene->m_arrow_state[vvr::RIGHT] = pressed;
+        m_scene->dispatch(key_event(InputEvent::Arrow, vvr::RIGHT, pressed, event));
     } else if (event->key() == Qt::Key_Up) {
-        if (pressed) m_scene->arrowEvent(vvr::UP, modif);
-        m_scene->m_arrow_state[vvr::UP] = pressed;
+        m_scene->dispatch(key_event(InputEvent::Arrow, vvr::UP, pressed, event));
     } else if (event->key() == Qt::Key_Down) {
-        if (pressed) m_scene->arrowEvent(vvr::DOWN, modif);
-        m_scene->m_arrow_state[vvr::DOWN] = pressed;
+        m_scene->dispatch(key_event(InputEvent::Arrow, vvr::DOWN, pressed, event));
     }
 
     idle();
@@ -0,0 +1,254 @@
+#include <vvr/headless.h>
+#include <vvr/scene.h>
+#include <vvr/scene_modern.h>
+#include <vvr/utils.h>
+#include <QApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTimerQuery>
+#include <QFile>
+#include <QtGui> //gl.h
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+bool vvr::HeadlessOptions::parse(int argc, char* argv[], HeadlessOptions &opt)
+{
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const bool has_val = i + 1 < argc;
+        if (!strcmp(arg, "--bench")) bench = true;
+        else if (!strcmp(arg, "--no-input")) opt.input = false;
+        else if (!strcmp(arg, "--no-render")) opt.render = false;
+        else if (!strcmp(arg, "--record") && has_val) opt.record = argv[++i];
+        else if (!strcmp(arg, "--replay") && has_val) opt.replay = argv[++i];
+        else if (!strcmp(arg, "--seed") && has_val) opt.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(arg, "--frames") && has_val) opt.frames = atoi(argv[++i]);
+        else if (!strcmp(arg, "--warmup") && has_val) opt.warmup = atoi(argv[++i]);
+        else if (!strcmp(arg, "--dt") && has_val) opt.dt = (float)atof(argv[++i]);
+        else if (!strcmp(arg, "--bench-out") && has_val) opt.output = argv[++i];
+        else if (!strcmp(arg, "--size") && has_val) sscanf(argv[++i], "%dx%d", &opt.width, &opt.height);
+    }
+    opt.frames = max(opt.frames, 1);
+    opt.warmup = max(opt.warmup, 0);
+    return bench;
+}
+
+namespace {
+
+struct FrameTiming
+{
+    double idle_ms;
+    double render_ms;   // CPU time to issue the frame
+    double frame_ms;    // Including glFinish()
+    double gpu_ms;      // -1 without timer queries
+};
+
+double elapsed_ms(chrono::steady_clock::time_point t0, chrono::steady_clock::time_point t1)
+{
+    return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+QJsonObject summarize(vector<double> v)
+{
+    QJsonObject o;
+    if (v.empty()) return o;
+    sort(v.begin(), v.end());
+    double sum = 0;
+    for (double x : v) sum += x;
+    auto pct = [&v](double p) { return v[min(v.size() - 1, (size_t)(p * v.size()))]; };
+    o["mean"] = sum / v.size();
+    o["p50"] = pct(0.50);
+    o["p95"] = pct(0.95);
+    o["p99"] = pct(0.99);
+    o["min"] = v.front();
+    o["max"] = v.back();
+    return o;
+}
+
+}
+
+int vvr::HeadlessRunner::run(int argc, char* argv[], Scene *scene, const HeadlessOptions &opt)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") &&
+        qEnvironmentVariableIsEmpty("DISPLAY") &&
+        qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    //! Same context setup as main_with_scene()
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    if (scene->getName() == SceneModern::name) {
+        format.setProfile(QSurfaceFormat::CoreProfile);
+        format.setVersion(4, 3);
+    }
+    format.setSwapInterval(0);
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create()) {
+        cerr << "Headless: Could not create an OpenGL context" << endl;
+        return 1;
+    }
+
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface)) {
+        cerr << "Headless: Could not make the OpenGL context current" << endl;
+        return 1;
+    }
+
+    QOpenGLFramebufferObjectFormat fbo_format;
+    fbo_format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+    QOpenGLFramebufferObject fbo(opt.width, opt.height, fbo_format);
+    fbo.bind();
+
+    QOpenGLTimerQuery timer;
+    const bool gpu_timing = timer.create();
+
+    set_synthetic_seconds(0);
+    scene->glInit();
+    scene->glResize(opt.width, opt.height);
+
+    //! A replay brings its own input and frame times, and sets the run length.
+    int warmup = opt.warmup;
+    int frames = opt.frames;
+    bool input = opt.input;
+    SimRecording replay;
+    if (!opt.replay.empty()) {
+        if (!replay.load(opt.replay) || replay.frames.empty()) {
+            cerr << "Headless: Could not read recording " << opt.replay << endl;
+            return 1;
+        }
+        const int length = (int)replay.frames.size();
+        warmup = min(warmup, length - 1);
+        frames = length - warmup;
+        input = false;
+        scene->startReplay(replay);
+    } else if (!opt.record.empty()) {
+        scene->startRecording(opt.seed);
+    }
+
+    //! Synthetic input: a left-button drag on a circle around the center.
+    const int radius = min(opt.width, opt.height) / 4;
+    auto input_pos = [&](int frame, int &x, int &y) {
+        const double a = 2 * 3.14159265358979 * frame / 120.0;
+        x = (int)(radius * cos(a));
+        y = (int)(radius * sin(a));
+    };
+
+    const int total = warmup + frames;
+    vector<FrameTiming> timings;
+    timings.reserve(frames);
+    double synthetic_sec = 0;
+
+    for (int frame = 0; frame < total; frame++)
+    {
+        synthetic_sec += replay.frames.empty() ? (frame ? opt.dt : 0) : replay.frames[frame];
+        set_synthetic_seconds((float)synthetic_sec);
+
+        if (input) {
+            InputEvent e;
+            input_pos(frame, e.x, e.y);
+            e.type = frame == 0 ? InputEvent::MousePress :
+                frame == total - 1 ? InputEvent::MouseRelease : InputEvent::MouseMove;
+            scene->dispatch(e);
+        }
+
+        const auto t0 = chrono::steady_clock::now();
+        scene->advance();
+        const auto t1 = chrono::steady_clock::now();
+        if (opt.render) {
+            if (gpu_timing) timer.begin();
+            scene->glRender();
+            if (gpu_timing) timer.end();
+        }
+        const auto t2 = chrono::steady_clock::now();
+        if (opt.render) glFinish();
+        const auto t3 = chrono::steady_clock::now();
+
+        if (frame < warmup) continue;
+
+        FrameTiming ft;
+        ft.idle_ms = elapsed_ms(t0, t1);
+        ft.render_ms = elapsed_ms(t1, t2);
+        ft.frame_ms = elapsed_ms(t0, t3);
+        ft.gpu_ms = gpu_timing && opt.render ? timer.waitForResult() / 1e6 : -1;
+        timings.push_back(ft);
+    }
+
+    set_synthetic_seconds(-1);
+
+    if (scene->getRecording() && !scene->getRecording()->save(opt.record)) {
+        cerr << "Headless: Could not write recording " << opt.record << endl;
+    }
+
+    //! Report
+    vector<double> idle, render, total_ms, gpu;
+    QJsonArray per_frame;
+    for (const FrameTiming &ft : timings) {
+        idle.push_back(ft.idle_ms);
+        render.push_back(ft.render_ms);
+        total_ms.push_back(ft.frame_ms);
+        if (ft.gpu_ms >= 0) gpu.push_back(ft.gpu_ms);
+        QJsonObject f;
+        f["idle_ms"] = ft.idle_ms;
+        f["render_ms"] = ft.render_ms;
+        f["frame_ms"] = ft.frame_ms;
+        if (ft.gpu_ms >= 0) f["gpu_ms"] = ft.gpu_ms;
+        per_frame.append(f);
+    }
+
+    QJsonObject summary;
+    summary["idle_ms"] = summarize(idle);
+    summary["render_ms"] = summarize(render);
+    summary["frame_ms"] = summarize(total_ms);
+    if (!gpu.empty()) summary["gpu_ms"] = summarize(gpu);
+
+    QJsonObject report;
+    report["scene"] = scene->getName();
+    report["renderer"] = QString((const char*)glGetString(GL_RENDERER));
+    report["gl_version"] = QString((const char*)glGetString(GL_VERSION));
+    report["width"] = opt.width;
+    report["height"] = opt.height;
+    report["warmup"] = warmup;
+    report["frames"] = frames;
+    report["dt"] = opt.dt;
+    report["sim_steps"] = (double)scene->getClock().stepCount();
+    if (!opt.replay.empty()) report["replay"] = QString::fromStdString(opt.replay);
+    report["summary"] = summary;
+    report["per_frame"] = per_frame;
+
+    fbo.release();
+    context.doneCurrent();
+
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (opt.output.empty()) {
+        fwrite(json.constData(), 1, json.size(), stdout);
+        fflush(stdout);
+        return 0;
+    }
+
+    QFile file(QString::fromStdString(opt.output));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        cerr << "Headless: Could not write " << opt.output << endl;
+        return 1;
+    }
+    file.write(json);
+    return 0;
+}
@@ -0,0 +1,420 @@
+#include <vvr/log.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace vvr;
+
+const size_t LogSink::SlotSize;
+const size_t LogSink::NumSlots;
+const size_t LogSink::MaxPendingLines;
+
+/*---[Formatter]------------------------------------------------------------------------*/
+namespace {
+
+//! Writes while the logger is being destroyed, or after, go straight to the console.
+atomic<bool> s_alive(true);
+
+struct Slot
+{
+    atomic<size_t>  seq;
+    uint16_t        len;
+    uint8_t         stream;
+    char            text[LogSink::SlotSize];
+};
+
+/**
+ * Bounded multi-producer queue of slots (after D. Vyukov), drained by one
+ * formatter thread. A slot is free for position p when its sequence is p,
+ * and filled when it is p + 1. The formatter sleeps while the queue is
+ * empty; producers lock only to wake it up, or to wait while it is full.
+ */
+class Logger
+{
+public:
+    Logger();
+    ~Logger();
+
+    void push(LogSink::Stream stream, const char *text, size_t len);
+    size_t take(vector<LogSink::Line> &out);
+    bool setFile(const string &filename);
+    void setNotify(LogSink::Notify notify, void *user);
+    void flush();
+    uint64_t dropped();
+
+    atomic<bool>        echo;
+
+private:
+    bool pop(Slot *&slot);
+    void wake();
+    void waitForRoom(size_t pos);
+    size_t drain();
+    void format(int stream, const char *text, size_t len);
+    void run();
+
+    unique_ptr<Slot[]>  m_slots;
+    atomic<size_t>      m_head;
+    size_t              m_tail;         ///< Formatter only
+    atomic<size_t>      m_done;         ///< Slots formatted
+
+    //! Formatter only
+    string              m_line;         ///< Being formatted
+    vector<LogSink::Line> m_formatted;  ///< Lines of this drain()
+    string              m_text;         ///< Text of this drain()
+    vector<pair<int, size_t>> m_runs;   ///< Stream and end of each run of m_text
+
+    mutex               m_mutex;        ///< Guards the lines for take()
+    vector<LogSink::Line> m_lines;
+    uint64_t            m_dropped_lines;
+    uint64_t            m_reported;     ///< m_dropped_lines returned by take()
+    LogSink::Notify     m_notify;
+    void*               m_notify_user;
+    bool                m_notified;     ///< Lines were announced and not yet taken
+
+    mutex               m_file_mutex;   ///< Guards m_file
+    FILE*               m_file;
+
+    mutex               m_wake_mutex;
+    condition_variable  m_wake;         ///< Formatter: something to drain
+    condition_variable  m_drained;      ///< flush() and full queues: m_done advanced
+    atomic<bool>        m_sleeping;
+    atomic<bool>        m_running;
+    thread              m_thread;
+};
+
+Logger::Logger()
+    : echo(true)
+    , m_slots(new Slot[LogSink::NumSlots])
+    , m_head(0)
+    , m_tail(0)
+    , m_done(0)
+    , m_dropped_lines(0)
+    , m_reported(0)
+    , m_notify(nullptr)
+    , m_notify_user(nullptr)
+    , m_notified(false)
+    , m_file(nullptr)
+    , m_sleeping(false)
+    , m_running(true)
+{
+    for (size_t i = 0; i < LogSink::NumSlots; i++) {
+        m_slots[i].seq.store(i, memory_order_relaxed);
+    }
+
+    const char *env = getenv("VVR_LOG_FILE");
+    if (env && *env) setFile(env);
+
+    m_thread = thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+    s_alive = false;
+    {
+        lock_guard<mutex> lock(m_wake_mutex);
+        m_running = false;
+    }
+    m_wake.notify_one();
+    m_drained.notify_all();
+    m_thread.join();
+    if (m_file) fclose(m_file);
+}
+
+void Logger::push(LogSink::Stream stream, const char *text, size_t len)
+{
+    const size_t mask = LogSink::NumSlots - 1;
+
+    while (len > 0)
+    {
+        const size_t n = len < LogSink::SlotSize ? len : LogSink::SlotSize;
+        size_t pos = m_head.load(memory_order_relaxed);
+        Slot *slot;
+
+        for (;;) {
+            slot = &m_slots[pos & mask];
+            const size_t seq = slot->seq.load(memory_order_acquire);
+            const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                //! Full. Unless stopping, then the console is all that is left.
+                if (!m_running) {
+                    fwrite(text, 1, len, stream ? stderr : stdout);
+                    return;
+                }
+                waitForRoom(pos);
+                pos = m_head.load(memory_order_relaxed);
+            } else {
+                pos = m_head.load(memory_order_relaxed);
+            }
+        }
+
+        slot->len = (uint16_t)n;
+        slot->stream = (uint8_t)stream;
+        memcpy(slot->text, text, n);
+        slot->seq.store(pos + 1, memory_order_release);
+        text += n;
+        len -= n;
+    }
+
+    //! Pairs with the fence in run(): either it sees the slot, or we see it sleeping.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleeping.load(memory_order_relaxed)) wake();
+}
+
+/**
+ * Sleeps until the slot for `pos` is freed, or the logger stops. The
+ * formatter frees slots before it locks m_wake_mutex to signal m_drained,
+ * so the check under the lock doesn't miss it.
+ */
+void Logger::waitForRoom(size_t pos)
+{
+    Slot &slot = m_slots[pos & (LogSink::NumSlots - 1)];
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleeping.load(memory_order_relaxed)) wake();
+
+    unique_lock<mutex> lock(m_wake_mutex);
+    m_drained.wait(lock, [&] {
+        return (intptr_t)slot.seq.load(memory_order_acquire) - (intptr_t)pos >= 0 || !m_running;
+    });
+}
+
+void Logger::wake()
+{
+    {
+        lock_guard<mutex> lock(m_wake_mutex);
+        m_sleeping = false;
+    }
+    m_wake.notify_one();
+}
+
+bool Logger::pop(Slot *&slot)
+{
+    slot = &m_slots[m_tail & (LogSink::NumSlots - 1)];
+    return slot->seq.load(memory_order_acquire) == m_tail + 1;
+}
+
+void Logger::run()
+{
+    for (;;) {
+        const bool stop = !m_running;
+        if (drain()) continue;
+        if (stop) break;
+
+        unique_lock<mutex> lock(m_wake_mutex);
+        m_sleeping = true;
+        atomic_thread_fence(memory_order_seq_cst);
+        Slot *slot;
+        if (pop(slot)) {
+            m_sleeping = false;
+            continue;
+        }
+        m_wake.wait(lock, [this] { return !m_sleeping || !m_running; });
+        m_sleeping = false;
+    }
+}
+
+/**
+ * Formats what is queued without holding any lock. The lines are handed to
+ * take() under m_mutex; the console and the file are written after that, so
+ * the GUI thread never waits on I/O.
+ */
+size_t Logger::drain()
+{
+    const bool to_console = echo;
+    size_t n = 0;
+    Slot *slot;
+
+    while (pop(slot))
+    {
+        if (m_runs.empty() || m_runs.back().first != slot->stream) m_runs.push_back({ slot->stream, 0 });
+        m_text.append(slot->text, slot->len);
+        m_runs.back().second = m_text.size();
+        format(slot->stream, slot->text, slot->len);
+        slot->seq.store(m_tail + LogSink::NumSlots, memory_order_release);
+        m_tail++;
+        n++;
+    }
+
+    if (!n) return 0;
+
+    //! Show unfinished lines too; the next ones continue them.
+    if (!m_line.empty()) {
+        m_formatted.push_back({ m_line, false });
+        m_line.clear();
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_lines.empty()) m_lines.swap(m_formatted);
+        else for (auto &line : m_formatted) m_lines.push_back(std::move(line));
+
+        if (m_lines.size() > LogSink::MaxPendingLines) {
+            const size_t excess = m_lines.size() - LogSink::MaxPendingLines;
+            m_lines.erase(m_lines.begin(), m_lines.begin() + excess);
+            m_dropped_lines += excess;
+        }
+
+        //! Once per batch taken, so that a busy GUI isn't flooded with calls.
+        if (m_notify && !m_notified) {
+            m_notified = true;
+            m_notify(m_notify_user);
+        }
+    }
+    m_formatted.clear();
+
+    if (to_console) {
+        size_t begin = 0;
+        for (auto &run : m_runs) {
+            FILE *f = run.first ? stderr : stdout;
+            fwrite(m_text.data() + begin, 1, run.second - begin, f);
+            fflush(f);
+            begin = run.second;
+        }
+    }
+    {
+        lock_guard<mutex> lock(m_file_mutex);
+        if (m_file) {
+            fwrite(m_text.data(), 1, m_text.size(), m_file);
+            fflush(m_file);
+        }
+    }
+    m_text.clear();
+    m_runs.clear();
+
+    {
+        lock_guard<mutex> lock(m_wake_mutex);
+        m_done.store(m_tail, memory_order_release);
+    }
+    m_drained.notify_all();
+    return n;
+}
+
+void Logger::format(int stream, const char *text, size_t len)
+{
+    static const char *open[] = { "<font color=\"White\">", "<font color=\"Red\">" };
+    const char *end = text + len;
+
+    while (text < end)
+    {
+        const char *nl = (const char*)memchr(text, '\n', end - text);
+        const char *seg_end = nl ? nl : end;
+
+        if (seg_end > text) {
+            m_line += open[stream];
+            for (const char *c = text; c < seg_end; c++) {
+                switch (*c) {
+                case '&': m_line += "&amp;"; break;
+                case '<': m_line += "&lt;"; break;
+                case '>': m_line += "&gt;"; break;
+                case '"': m_line += "&quot;"; break;
+                case ' ': m_line += "&nbsp;"; break;
+                case '\r': break;
+                default: m_line += *c; break;
+                }
+            }
+            m_line += "</font>";
+        }
+
+        if (!nl) break;
+        m_formatted.push_back({ m_line, true });
+        m_line.clear();
+        text = nl + 1;
+    }
+}
+
+size_t Logger::take(vector<LogSink::Line> &out)
+{
+    lock_guard<mutex> lock(m_mutex);
+    for (auto &line : m_lines) out.push_back(std::move(line));
+    m_lines.clear();
+    m_notified = false;
+    const size_t since = (size_t)(m_dropped_lines - m_reported);
+    m_reported = m_dropped_lines;
+    return since;
+}
+
+uint64_t Logger::dropped()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_dropped_lines;
+}
+
+bool Logger::setFile(const string &filename)
+{
+    lock_guard<mutex> lock(m_file_mutex);
+    if (m_file) fclose(m_file);
+    m_file = filename.empty() ? nullptr : fopen(filename.c_str(), "w");
+    return filename.empty() || m_file;
+}
+
+void Logger::setNotify(LogSink::Notify notify, void *user)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_notify = notify;
+    m_notify_user = user;
+    m_notified = false;
+}
+
+void Logger::flush()
+{
+    const size_t target = m_head.load(memory_order_acquire);
+    unique_lock<mutex> lock(m_wake_mutex);
+    m_drained.wait(lock, [&] { return m_done.load(memory_order_acquire) >= target || !m_running; });
+}
+
+Logger& logger()
+{
+    static Logger instance;
+    return instance;
+}
+
+}
+
+/*---[LogSink]--------------------------------------------------------------------------*/
+void LogSink::write(Stream stream, const char *text, size_t len)
+{
+    if (!s_alive) {
+        fwrite(text, 1, len, stream ? stderr : stdout);
+        return;
+    }
+    Logger &log = logger();
+    log.push(stream, text, len);
+    if (stream == Err) log.flush();
+}
+
+size_t LogSink::take(std::vector<Line> &lines)
+{
+    return logger().take(lines);
+}
+
+bool LogSink::setFile(const std::string &filename)
+{
+    return logger().setFile(filename);
+}
+
+void LogSink::setNotify(Notify notify, void *user)
+{
+    if (s_alive) logger().setNotify(notify, user);
+}
+
+void LogSink::setEcho(bool on)
+{
+    logger().echo = on;
+}
+
+uint64_t LogSink::dropped()
+{
+    return logger().dropped();
+}
+
+void LogSink::flush()
+{
+    logger().flush();
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <vvr/drawing.h>
 #include <vvr/mesh.h>
+#include <vvr/profiler.h>
 
 using namespace std;
 using namespace vvr;
@@ -81,15 +82,15 @@ Mesh::Mesh(const string &objFile, const string &texFile, bool ccw)
     for (unsigned i = 0; i < indices.size(); i += 3)
         mTriangles.push_back(Triangle(&mVertices, indices[i], indices[i + 2], indices[i + 1]));
 
+    mAABB = aabbFromVertices(mVertices);
+
     //! Store normals
     if (!normals.empty()) {
         const size_t n = normals.size();
         for (size_t i = 0; i < n; i += 3)
             mVertexNormals.push_back(vec(normals[i], normals[i + 1], normals[i + 2]));
     }
-    else createNormals(); //! Or create them...
-
-    mAABB = aabbFromVertices(mVertices);
+    else if (!weld()) createNormals(); //! Or create them, after merging duplicates for smooth shading...
 }
 
 Mesh::Mesh(const Mesh &src)
@@ -99,6 +100,7 @@ Mesh::Mesh(const Mesh &src)
     , mMatrix(src.mMatrix)
     , mAABB(src.mAABB)
     , mCCW(src.mCCW)
+    , mLods(src.mLods)
 {
     vector<Triangle>::iterator ti;
     for (ti = mTriangles.begin(); ti != mTriangles.end(); ++ti) {
@@ -114,6 +116,7 @@ void Mesh::operator=(const Mesh &src)
     mMatrix = src.mMatrix;
     mAABB = src.mAABB;
     mCCW = src.mCCW;
+    mLods = src.mLods;
 
     vector<Triangle>::iterator ti;
     for (ti = mTriangles.begin(); ti != mTriangles.end(); ++ti) {
@@ -125,7 +128,7 @@ Mesh::~Mesh()
 {
 }
 
-void Mesh::exportToObj(const string &filename)
+void Mesh::exportToObj(const string &filename) const
 {
     QFile file(QString::fromStdString(filename));
 
@@ -219,6 +222,7 @@ void Mesh::update(const bool recomputeAABB)
 {
     updateTriangleData();
     createNormals();
+    mLods.clear();
     if (recomputeAABB) mAABB = aabbFromVertices(mVertices);
 }
 
@@ -239,6 +243,7 @@ void Mesh::setBigSize(float size)
     mAABB.Scale(vec::zero, s);
 
     updateTriangleData();
+    mLods.clear();
 }
 
 math::AABB Mesh::getAABB() const
@@ -266,6 +271,7 @@ void Mesh::move(const vec &p)
     for (auto &v : mVertices) v += p;
     mAABB.Translate(p);
     updateTriangleData();
+    mLods.clear();
 }
 
 void Mesh::transform(const math::float3x4 &t)
@@ -346,15 +352,28 @@ void Mesh::drawAxes()
 
 void Mesh::draw(Colour col, Style x)
 {
+    drawLevel(*this, col, x);
+}
+
+void Mesh::draw(Colour col, Style x, const math::Frustum &frustum)
+{
+    const int level = selectLod(frustum);
+    drawLevel(level > 0 ? *mLods[level - 1] : *this, col, x);
+}
+
+void Mesh::drawLevel(Mesh &geom, Colour col, Style x)
+{
+    vvr_profile_scope("Mesh::draw");
+
     glPushMatrix();
 
     float4x4 M(mMatrix);
     M.Transpose();
     glMultMatrixf(M.ptr());
 
-    if (x & SOLID) drawTriangles(col, false);
-    if (x & WIRE) drawTriangles(col, true);
-    if (x & NORMALS) drawNormals(col);
+    if (x & SOLID) geom.drawTriangles(col, false);
+    if (x & WIRE) geom.drawTriangles(col, true);
+    if (x & NORMALS) geom.drawNormals(col);
     if (x & BOUND) 
     {
         Aabb3D aabb(mAABB.MinX(), mAABB.MinY(), mAABB.MinZ(), mAABB.MaxX(), mAABB.MaxY(), mAABB.MaxZ(), col);
@@ -365,3 +384,42 @@ void Mesh::draw(Colour col, Style x)
 
     glPopMatrix();
 }
+
+void Mesh::buildLods(int levels, float ratio)
+{
+    mLods.clear();
+    const Mesh *src = this;
+    for (int i = 0; i < levels; i++)
+    {
+        const size_t target = (size_t)(src->mTriangles.size() * ratio);
+        if (target < 4) break;
+        Ptr lod = src->simplify(target, i);
+        if (lod->mTriangles.size() >= src->mTriangles.size()) break;
+        mLods.push_back(lod);
+        src = lod.get();
+    }
+}
+
+int Mesh::selectLod(const math::Frustum &frustum) const
+{
+    //! Full detail while the bounding sphere covers at least
+    //! a quarter of the screen height. One level less per halving.
+    const float full_detail_radius = 0.25f;
+
+    if (mLods.empty()) return 0;
+
+    const AABB aabb = getAABB();
+    const vec c = aabb.CenterPoint();
+    const float r = aabb.HalfDiagonal().Length();
+    if (frustum.Front().Dot(c - frustum.Pos()) <= r) return 0;
+
+    const vec pc = frustum.Project(c);
+    const vec pe = frustum.Project(c + frustum.Up() * r);
+    const float radius = float2(pe.x - pc.x, pe.y - pc.y).Length();
+
+    int level = 0;
+    for (float cov = full_detail_radius; radius < cov && level < (int)mLods.size(); cov /= 2) {
+        level++;
+    }
+    return level;
+}
@@ -0,0 +1,372 @@
+#include <vvr/mesh.h>
+#include <vvr/drawing.h>
+#include <MathGeoLib.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace vvr;
+using namespace math;
+
+typedef array<int, 3> Tri;
+
+namespace {
+
+/**
+ * Symmetric 4x4 error quadric (Garland & Heckbert), stored as its upper triangle.
+ */
+struct Quadric
+{
+    double a[10];
+
+    Quadric() { fill(a, a + 10, 0.0); }
+
+    Quadric(double x, double y, double z, double w)
+    {
+        a[0] = x * x; a[1] = x * y; a[2] = x * z; a[3] = x * w;
+        a[4] = y * y; a[5] = y * z; a[6] = y * w;
+        a[7] = z * z; a[8] = z * w;
+        a[9] = w * w;
+    }
+
+    Quadric& operator+=(const Quadric &q)
+    {
+        for (int i = 0; i < 10; i++) a[i] += q.a[i];
+        return *this;
+    }
+
+    Quadric operator+(const Quadric &q) const
+    {
+        Quadric r(*this);
+        return r += q;
+    }
+
+    double error(const vec &v) const
+    {
+        const double x = v.x, y = v.y, z = v.z;
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+            + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+            + a[7] * z * z + 2 * a[8] * z
+            + a[9];
+    }
+
+    //! Position minimizing the error. Fails for (near) singular systems.
+    bool optimum(vec &v) const
+    {
+        const double m00 = a[0], m01 = a[1], m02 = a[2];
+        const double m11 = a[4], m12 = a[5], m22 = a[7];
+        const double b0 = -a[3], b1 = -a[6], b2 = -a[8];
+        const double c00 = m11 * m22 - m12 * m12;
+        const double c01 = m02 * m12 - m01 * m22;
+        const double c02 = m01 * m12 - m02 * m11;
+        const double det = m00 * c00 + m01 * c01 + m02 * c02;
+        if (fabs(det) < 1e-12) return false;
+        const double c11 = m00 * m22 - m02 * m02;
+        const double c12 = m01 * m02 - m00 * m12;
+        const double c22 = m00 * m11 - m01 * m01;
+        v.x = (float) ((c00 * b0 + c01 * b1 + c02 * b2) / det);
+        v.y = (float) ((c01 * b0 + c11 * b1 + c12 * b2) / det);
+        v.z = (float) ((c02 * b0 + c12 * b1 + c22 * b2) / det);
+        return true;
+    }
+};
+
+struct Collapse
+{
+    double cost;
+    int keep, drop;
+    unsigned stamp_keep, stamp_drop;
+    vec pos;
+
+    //! Min-heap order with deterministic tie breaking.
+    bool operator<(const Collapse &o) const
+    {
+        if (cost != o.cost) return cost > o.cost;
+        if (keep != o.keep) return keep > o.keep;
+        return drop > o.drop;
+    }
+};
+
+/**
+ * Edge collapse simplification of one partition of the mesh.
+ * Locked vertices are shared with other partitions and never move,
+ * so partitions can be simplified independently and stitched back.
+ */
+struct PartitionSimplifier
+{
+    vector<int>             gid;        // local -> global vertex index
+    vector<vec>             pos;
+    vector<Quadric>         quad;
+    vector<char>            locked;
+    vector<char>            removed;
+    vector<unsigned>        stamp;
+    vector<vector<int>>     adj;        // vertex -> triangles (may contain dead ones)
+    vector<Tri>             tris;
+    vector<char>            alive;
+    priority_queue<Collapse> heap;
+    size_t                  num_alive;
+
+    PartitionSimplifier(const vector<vec> &verts, const vector<Tri> &all_tris,
+        const vector<int> &part_tris, const vector<char> &glocked)
+    {
+        unordered_map<int, int> lid;
+        tris.reserve(part_tris.size());
+        for (int ti : part_tris) {
+            Tri t;
+            for (int k = 0; k < 3; k++) {
+                const int g = all_tris[ti][k];
+                auto it = lid.find(g);
+                if (it == lid.end()) {
+                    it = lid.emplace(g, (int) gid.size()).first;
+                    gid.push_back(g);
+                    pos.push_back(verts[g]);
+                    locked.push_back(glocked[g]);
+                }
+                t[k] = it->second;
+            }
+            tris.push_back(t);
+        }
+
+        const size_t nv = gid.size();
+        quad.resize(nv);
+        removed.assign(nv, 0);
+        stamp.assign(nv, 0);
+        adj.resize(nv);
+        alive.assign(tris.size(), 1);
+        num_alive = tris.size();
+
+        for (size_t i = 0; i < tris.size(); i++) {
+            const Tri &t = tris[i];
+            const vec n = (pos[t[1]] - pos[t[0]]).Cross(pos[t[2]] - pos[t[0]]);
+            const float len = n.Length();
+            if (len > 0) {
+                const vec u = n / len;
+                const Quadric q(u.x, u.y, u.z, -u.Dot(pos[t[0]]));
+                for (int k = 0; k < 3; k++) quad[t[k]] += q;
+            }
+            for (int k = 0; k < 3; k++) adj[t[k]].push_back((int) i);
+        }
+
+        vector<pair<int, int>> edges;
+        for (const Tri &t : tris) {
+            for (int k = 0; k < 3; k++) {
+                const int a = t[k], b = t[(k + 1) % 3];
+                edges.push_back({ min(a, b), max(a, b) });
+            }
+        }
+        sort(edges.begin(), edges.end());
+        edges.erase(unique(edges.begin(), edges.end()), edges.end());
+        for (auto &e : edges) push(e.first, e.second);
+    }
+
+    //! Would moving 'v' to 'p' flip or collapse one of its triangles, other than those shared with 'other'?
+    bool flips(int v, int other, const vec &p) const
+    {
+        for (int ti : adj[v]) {
+            if (!alive[ti]) continue;
+            const Tri &t = tris[ti];
+            if (t[0] == other || t[1] == other || t[2] == other) continue;
+            vec q[3] = { pos[t[0]], pos[t[1]], pos[t[2]] };
+            const vec n0 = (q[1] - q[0]).Cross(q[2] - q[0]);
+            for (int k = 0; k < 3; k++) if (t[k] == v) q[k] = p;
+            const vec n1 = (q[1] - q[0]).Cross(q[2] - q[0]);
+            if (n0.Dot(n1) <= 0.2f * n0.Length() * n1.Length()) return true;
+        }
+        return false;
+    }
+
+    void push(int a, int b)
+    {
+        if (locked[a] && locked[b]) return;
+        if (locked[b]) swap(a, b);
+
+        Collapse c;
+        c.keep = a;
+        c.drop = b;
+        const Quadric q = quad[a] + quad[b];
+
+        if (locked[a]) {
+            c.pos = pos[a];
+            c.cost = q.error(c.pos);
+        } else if (q.optimum(c.pos)) {
+            c.cost = q.error(c.pos);
+        } else {
+            const vec cand[3] = { pos[a], pos[b], (pos[a] + pos[b]) * 0.5f };
+            c.cost = -1;
+            for (const vec &p : cand) {
+                const double e = q.error(p);
+                if (c.cost < 0 || e < c.cost) { c.cost = e; c.pos = p; }
+            }
+        }
+
+        c.stamp_keep = stamp[a];
+        c.stamp_drop = stamp[b];
+        heap.push(c);
+    }
+
+    void collapse(const Collapse &c)
+    {
+        const int a = c.keep, b = c.drop;
+        pos[a] = c.pos;
+        quad[a] += quad[b];
+        removed[b] = 1;
+        stamp[a]++;     // Invalidates every queued edge of 'a'; those of 'b' are removed
+
+        for (int ti : adj[b]) {
+            if (!alive[ti]) continue;
+            Tri &t = tris[ti];
+            if (t[0] == a || t[1] == a || t[2] == a) {
+                alive[ti] = 0;
+                num_alive--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++) if (t[k] == b) t[k] = a;
+            adj[a].push_back(ti);
+        }
+        adj[b].clear();
+
+        //! Compact the adjacency and requeue the edges around 'a'. Edges between
+        //! the neighbours keep their quadrics, so their queued entries stay valid.
+        vector<int> nbrs;
+        auto &aa = adj[a];
+        aa.erase(remove_if(aa.begin(), aa.end(), [this](int ti) { return !alive[ti]; }), aa.end());
+        for (int ti : aa) {
+            for (int k = 0; k < 3; k++) {
+                if (tris[ti][k] != a) nbrs.push_back(tris[ti][k]);
+            }
+        }
+        sort(nbrs.begin(), nbrs.end());
+        nbrs.erase(unique(nbrs.begin(), nbrs.end()), nbrs.end());
+        for (int n : nbrs) {
+            push(a, n);
+        }
+    }
+
+    void run(size_t target)
+    {
+        while (num_alive > target && !heap.empty())
+        {
+            const Collapse c = heap.top();
+            heap.pop();
+            if (removed[c.keep] || removed[c.drop]) continue;
+            if (stamp[c.keep] != c.stamp_keep || stamp[c.drop] != c.stamp_drop) continue;
+            if (flips(c.keep, c.drop, c.pos) || flips(c.drop, c.keep, c.pos)) continue;
+            collapse(c);
+        }
+    }
+};
+
+} // namespace
+
+Mesh::Ptr Mesh::simplified(size_t max_triangles) const
+{
+    return simplify(max_triangles, 0);
+}
+
+Mesh::Ptr Mesh::simplify(size_t max_triangles, int axis_shift) const
+{
+    const size_t num_tris = mTriangles.size();
+
+    vector<Tri> all_tris(num_tris);
+    for (size_t i = 0; i < num_tris; i++) {
+        all_tris[i] = { mTriangles[i].vi1, mTriangles[i].vi2, mTriangles[i].vi3 };
+    }
+
+    //! Split the triangles in slabs of equal size along an axis of the bounding box.
+    const vec size = mAABB.Size();
+    int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+    axis = (axis + axis_shift) % 3;
+
+    vector<pair<float, int>> order(num_tris);
+    for (size_t i = 0; i < num_tris; i++) {
+        const Tri &t = all_tris[i];
+        const float c = mVertices[t[0]][axis] + mVertices[t[1]][axis] + mVertices[t[2]][axis];
+        order[i] = { c, (int) i };
+    }
+    sort(order.begin(), order.end());
+
+    //! The partitioning decides the output, so it must not depend on the machine.
+    const size_t min_part_size = 4096;
+    const size_t max_parts = 16;
+    const size_t num_parts = max<size_t>(1, min(max_parts, num_tris / min_part_size));
+
+    vector<vector<int>> parts(num_parts);
+    vector<int> owner(mVertices.size(), -1);
+    vector<char> locked(mVertices.size(), 0);
+    for (size_t i = 0; i < num_tris; i++) {
+        const int p = (int) (i * num_parts / num_tris);
+        const int ti = order[i].second;
+        parts[p].push_back(ti);
+        for (int v : all_tris[ti]) {
+            if (owner[v] < 0) owner[v] = p;
+            else if (owner[v] != p) locked[v] = 1;
+        }
+    }
+
+    //! Simplify the partitions in parallel. Each one only writes the vertices it owns.
+    vector<vec> positions(mVertices);
+    vector<vector<Tri>> part_tris(num_parts);
+    auto work = [&](size_t p) {
+        PartitionSimplifier ps(mVertices, all_tris, parts[p], locked);
+        const size_t target = max_triangles * parts[p].size() / max<size_t>(1, num_tris);
+        ps.run(target);
+        for (size_t i = 0; i < ps.gid.size(); i++) {
+            if (!ps.locked[i] && !ps.removed[i]) positions[ps.gid[i]] = ps.pos[i];
+        }
+        for (size_t i = 0; i < ps.tris.size(); i++) {
+            if (!ps.alive[i]) continue;
+            const Tri &t = ps.tris[i];
+            part_tris[p].push_back({ ps.gid[t[0]], ps.gid[t[1]], ps.gid[t[2]] });
+        }
+    };
+
+    atomic<size_t> next_part(0);
+    auto worker = [&]() {
+        for (size_t p; (p = next_part++) < num_parts; ) work(p);
+    };
+
+    const size_t num_workers = min<size_t>(num_parts, max(1u, thread::hardware_concurrency()));
+    vector<future<void>> jobs;
+    for (size_t i = 1; i < num_workers; i++) {
+        jobs.push_back(async(launch::async, worker));
+    }
+    worker();
+    for (auto &job : jobs) job.get();
+
+    //! Stitch the partitions and drop unreferenced vertices.
+    Mesh::Ptr mesh = Mesh::Make();
+    mesh->mCCW = mCCW;
+    mesh->mMatrix = mMatrix;
+
+    vector<int> remap(positions.size(), -1);
+    vector<Tri> out_tris;
+    for (auto &pt : part_tris) {
+        for (Tri t : pt) {
+            for (int k = 0; k < 3; k++) {
+                int &r = remap[t[k]];
+                if (r < 0) {
+                    r = (int) mesh->mVertices.size();
+                    mesh->mVertices.push_back(positions[t[k]]);
+                }
+                t[k] = r;
+            }
+            out_tris.push_back(t);
+        }
+    }
+
+    mesh->mTriangles.reserve(out_tris.size());
+    for (const Tri &t : out_tris) {
+        mesh->mTriangles.push_back(Triangle(&mesh->mVertices, t[0], t[1], t[2]));
+    }
+
+    mesh->createNormals();
+    mesh->mAABB = aabbFromVertices(mesh->mVertices);
+    return mesh;
+}
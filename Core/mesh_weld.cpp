@@ -0,0 +1,129 @@
+#include <vvr/mesh.h>
+#include <MathGeoLib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace vvr;
+using namespace math;
+
+namespace {
+
+struct Cell
+{
+    int64_t x, y, z;
+};
+
+inline uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+{
+    //! Collisions only cost extra distance tests.
+    return (uint64_t)x * 73856093ull ^ (uint64_t)y * 19349663ull ^ (uint64_t)z * 83492791ull;
+}
+
+template <typename F>
+void parallelFor(size_t n, F f)
+{
+    const size_t min_chunk = 8192;
+    const size_t hw = max(1u, thread::hardware_concurrency());
+    const size_t num_chunks = max<size_t>(1, min(hw, n / min_chunk));
+    vector<future<void>> jobs;
+    for (size_t c = 1; c < num_chunks; c++) {
+        jobs.push_back(async(launch::async, [&f, c, n, num_chunks]() {
+            for (size_t i = n * c / num_chunks; i < n * (c + 1) / num_chunks; i++) f(i);
+        }));
+    }
+    for (size_t i = 0; i < n / num_chunks; i++) f(i);
+    for (auto &job : jobs) job.get();
+}
+
+} // namespace
+
+size_t Mesh::weld(float tolerance)
+{
+    const size_t n = mVertices.size();
+    if (n < 2) return 0;
+
+    //! With zero tolerance only exact duplicates merge; the grid is then just for hashing.
+    float h = tolerance;
+    if (h <= 0) h = max(getMaxSize(), 1.0f) * 1e-5f;
+    const float tol_sq = tolerance * tolerance;
+    const vec origin = mAABB.minPoint;
+
+    vector<Cell> cells(n);
+    parallelFor(n, [&](size_t i) {
+        const vec p = (mVertices[i] - origin) / h;
+        cells[i] = { (int64_t)floor(p.x), (int64_t)floor(p.y), (int64_t)floor(p.z) };
+    });
+
+    //! Buckets as linked lists with ascending vertex indices.
+    unordered_map<uint64_t, int> head;
+    head.reserve(n);
+    vector<int> next(n, -1);
+    for (size_t i = n; i-- > 0;) {
+        const Cell &c = cells[i];
+        auto ins = head.emplace(cellKey(c.x, c.y, c.z), (int)i);
+        if (!ins.second) {
+            next[i] = ins.first->second;
+            ins.first->second = (int)i;
+        }
+    }
+
+    //! For each vertex, the lowest index within tolerance. Read only, so it runs in parallel.
+    vector<int> lowest(n);
+    const int r = tolerance > 0 ? 1 : 0;
+    parallelFor(n, [&](size_t i) {
+        const Cell &c = cells[i];
+        const vec &p = mVertices[i];
+        int best = (int)i;
+        for (int dx = -r; dx <= r; dx++) {
+            for (int dy = -r; dy <= r; dy++) {
+                for (int dz = -r; dz <= r; dz++) {
+                    auto it = head.find(cellKey(c.x + dx, c.y + dy, c.z + dz));
+                    if (it == head.end()) continue;
+                    for (int j = it->second; j >= 0 && j < best; j = next[j]) {
+                        const vec &q = mVertices[j];
+                        const bool same = tolerance > 0 ? q.DistanceSq(p) <= tol_sq :
+                            (q.x == p.x && q.y == p.y && q.z == p.z);
+                        if (same) { best = j; break; }
+                    }
+                }
+            }
+        }
+        lowest[i] = best;
+    });
+
+    //! Resolve chains in index order, so that the result doesn't depend on the threads.
+    vector<int> remap(n);
+    vector<vec> vertices;
+    vertices.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        if (lowest[i] == (int)i) {
+            remap[i] = (int)vertices.size();
+            vertices.push_back(mVertices[i]);
+        }
+        else remap[i] = remap[lowest[i]];
+    }
+
+    const size_t merged = n - vertices.size();
+    if (merged == 0) return 0;
+
+    mVertices.swap(vertices);
+
+    vector<Triangle> triangles;
+    triangles.reserve(mTriangles.size());
+    for (const Triangle &t : mTriangles) {
+        const int a = remap[t.vi1], b = remap[t.vi2], c = remap[t.vi3];
+        if (a == b || b == c || a == c) continue;
+        triangles.push_back(Triangle(&mVertices, a, b, c));
+    }
+    mTriangles.swap(triangles);
+
+    createNormals();
+    mLods.clear();
+    return merged;
+}
@@ -0,0 +1,382 @@
+#include <vvr/profiler.h>
+#include <QOpenGLContext>
+#include <QtGui> //gl.h
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+using namespace std;
+using namespace vvr;
+
+static bool env_enabled()
+{
+    const char *env = getenv("VVR_PROFILE");
+    return env && *env && *env != '0';
+}
+
+const size_t Profiler::RingSize;
+const size_t Profiler::FrameHistory;
+std::atomic<bool> Profiler::s_enabled(env_enabled());
+bool Profiler::s_overlay = env_enabled();
+
+/*---[Per thread ring buffers]----------------------------------------------------------*/
+namespace {
+
+const int MaxDepth = 64;
+
+struct ThreadBuffer
+{
+    vector<Profiler::Event> ring;
+    atomic<uint64_t>        head;       // Events written
+    atomic<uint64_t>        started;    // Events being or been written
+    const char*             names[MaxDepth];
+    int64_t                 begins[MaxDepth];
+    int                     depth;
+    int                     tid;
+
+    ThreadBuffer(int tid) : ring(Profiler::RingSize), head(0), started(0), depth(0), tid(tid) { }
+
+    void push(const char *name, int64_t begin, int64_t end, int depth)
+    {
+        const uint64_t h = head.load(memory_order_relaxed);
+        //! Announce the overwrite of the oldest event before doing it, for snapshot()
+        started.store(h + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        Profiler::Event &e = ring[h % ring.size()];
+        e.name = name;
+        e.begin = begin;
+        e.end = end;
+        e.depth = depth;
+        head.store(h + 1, memory_order_release);
+    }
+
+    //! Copy of the buffered events, oldest first, taken from any thread. The owner
+    //! keeps writing meanwhile, so events that it may have overwritten are dropped.
+    void snapshot(vector<Profiler::Event> &out) const
+    {
+        const uint64_t size = ring.size();
+        const uint64_t h = head.load(memory_order_acquire);
+        const uint64_t from = h - min<uint64_t>(h, size);
+        out.clear();
+        for (uint64_t i = from; i < h; i++) out.push_back(ring[i % size]);
+
+        atomic_thread_fence(memory_order_acquire);
+        const uint64_t s = started.load(memory_order_relaxed);
+        const uint64_t first_valid = s > size ? s - size : 0;
+        if (first_valid > from) {
+            out.erase(out.begin(), out.begin() + (size_t) min<uint64_t>(first_valid - from, out.size()));
+        }
+    }
+
+    void reset()
+    {
+        head.store(0, memory_order_release);
+        started.store(0, memory_order_release);
+    }
+};
+
+struct FrameRecord
+{
+    int64_t begin;
+    float   cpu_ms;
+    float   gpu_ms;
+};
+
+typedef void (QOPENGLF_APIENTRYP PfnGenQueries)(GLsizei n, GLuint *ids);
+typedef void (QOPENGLF_APIENTRYP PfnQueryCounter)(GLuint id, GLenum target);
+typedef void (QOPENGLF_APIENTRYP PfnGetQueryObjectiv)(GLuint id, GLenum pname, GLint *params);
+typedef void (QOPENGLF_APIENTRYP PfnGetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params);
+
+/**
+ * Timestamp queries for the last few frames, read back without stalling.
+ */
+struct GpuTimer
+{
+    static const int Latency = 4;
+
+    QOpenGLContext          *ctx = nullptr;
+    bool                    available = false;
+    PfnGenQueries           genQueries = nullptr;
+    PfnQueryCounter         queryCounter = nullptr;
+    PfnGetQueryObjectiv     getQueryObjectiv = nullptr;
+    PfnGetQueryObjectui64v  getQueryObjectui64v = nullptr;
+    GLuint                  queries[Latency][2];
+    uint64_t                frame[Latency];
+    bool                    pending[Latency];
+    bool                    issued;
+
+    void init(QOpenGLContext *c)
+    {
+        ctx = c;
+        available = false;
+        issued = false;
+        if (!c) return;
+        const bool has = c->format().version() >= qMakePair(3, 3) ||
+            c->hasExtension("GL_ARB_timer_query");
+        if (!has) return;
+        genQueries = (PfnGenQueries) c->getProcAddress("glGenQueries");
+        queryCounter = (PfnQueryCounter) c->getProcAddress("glQueryCounter");
+        getQueryObjectiv = (PfnGetQueryObjectiv) c->getProcAddress("glGetQueryObjectiv");
+        getQueryObjectui64v = (PfnGetQueryObjectui64v) c->getProcAddress("glGetQueryObjectui64v");
+        if (!genQueries || !queryCounter || !getQueryObjectiv || !getQueryObjectui64v) return;
+        genQueries(Latency * 2, &queries[0][0]);
+        for (int i = 0; i < Latency; i++) pending[i] = false;
+        available = true;
+    }
+};
+
+mutex                               s_mutex;
+vector<unique_ptr<ThreadBuffer>>    s_threads;
+thread_local ThreadBuffer*          t_buffer = nullptr;
+ThreadBuffer                        s_gpu_buffer(-1);
+vector<FrameRecord>                 s_frames(Profiler::FrameHistory);
+uint64_t                            s_frame_count = 0;
+int64_t                             s_frame_begin = 0;
+GpuTimer                            s_gpu;
+
+ThreadBuffer& buffer()
+{
+    if (!t_buffer) {
+        lock_guard<mutex> lock(s_mutex);
+        //! Buffers are never freed, so events outlive their threads.
+        s_threads.emplace_back(new ThreadBuffer((int)s_threads.size() + 1));
+        t_buffer = s_threads.back().get();
+    }
+    return *t_buffer;
+}
+
+void resolveGpu(int slot)
+{
+    GpuTimer &g = s_gpu;
+    if (!g.pending[slot]) return;
+    GLint done = 0;
+    g.getQueryObjectiv(g.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &done);
+    if (!done) return;
+    GLuint64 t0 = 0, t1 = 0;
+    g.getQueryObjectui64v(g.queries[slot][0], GL_QUERY_RESULT, &t0);
+    g.getQueryObjectui64v(g.queries[slot][1], GL_QUERY_RESULT, &t1);
+    g.pending[slot] = false;
+
+    const uint64_t f = g.frame[slot];
+    if (f + Profiler::FrameHistory <= s_frame_count) return;
+    FrameRecord &rec = s_frames[f % Profiler::FrameHistory];
+    rec.gpu_ms = (t1 - t0) / 1e6f;
+    //! GPU and CPU clocks differ; the GPU span is drawn from the CPU frame start.
+    s_gpu_buffer.push("gpu frame", rec.begin, rec.begin + (int64_t)(t1 - t0), 0);
+}
+
+void jsonEscape(FILE *f, const char *s)
+{
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s < 0x20) continue;
+        fputc(*s, f);
+    }
+}
+
+}
+
+/*---[Scopes]---------------------------------------------------------------------------*/
+void Profiler::setEnabled(bool on)
+{
+    s_enabled.store(on, memory_order_relaxed);
+}
+
+int64_t Profiler::now()
+{
+    static const auto epoch = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::begin(const char *name)
+{
+    ThreadBuffer &b = buffer();
+    if (b.depth < MaxDepth) {
+        b.names[b.depth] = name;
+        b.begins[b.depth] = now();
+    }
+    b.depth++;
+}
+
+void Profiler::end()
+{
+    ThreadBuffer &b = buffer();
+    if (b.depth == 0) return;
+    b.depth--;
+    if (b.depth < MaxDepth) {
+        b.push(b.names[b.depth], b.begins[b.depth], now(), b.depth);
+    }
+}
+
+/*---[Frames]---------------------------------------------------------------------------*/
+void Profiler::beginFrame()
+{
+    if (!enabled()) return;
+
+    QOpenGLContext *ctx = QOpenGLContext::currentContext();
+    if (ctx != s_gpu.ctx) s_gpu.init(ctx);
+
+    s_frame_begin = now();
+    begin("frame");
+
+    s_gpu.issued = false;
+    if (s_gpu.available) {
+        for (int i = 0; i < GpuTimer::Latency; i++) resolveGpu(i);
+        const int slot = s_frame_count % GpuTimer::Latency;
+        if (!s_gpu.pending[slot]) {
+            s_gpu.queryCounter(s_gpu.queries[slot][0], GL_TIMESTAMP);
+            s_gpu.issued = true;
+        }
+    }
+}
+
+void Profiler::endFrame()
+{
+    if (!enabled() || buffer().depth == 0) return;
+
+    end();
+
+    const int slot = s_frame_count % GpuTimer::Latency;
+    if (s_gpu.issued) {
+        s_gpu.queryCounter(s_gpu.queries[slot][1], GL_TIMESTAMP);
+        s_gpu.frame[slot] = s_frame_count;
+        s_gpu.pending[slot] = true;
+    }
+
+    lock_guard<mutex> lock(s_mutex);
+    FrameRecord &rec = s_frames[s_frame_count % FrameHistory];
+    rec.begin = s_frame_begin;
+    rec.cpu_ms = (now() - s_frame_begin) / 1e6f;
+    rec.gpu_ms = -1;
+    s_frame_count++;
+}
+
+std::vector<Profiler::FrameStats> Profiler::frameStats()
+{
+    lock_guard<mutex> lock(s_mutex);
+    vector<FrameStats> stats;
+    const uint64_t n = min<uint64_t>(s_frame_count, FrameHistory);
+    for (uint64_t f = s_frame_count - n; f < s_frame_count; f++) {
+        const FrameRecord &rec = s_frames[f % FrameHistory];
+        stats.push_back({ rec.cpu_ms, rec.gpu_ms });
+    }
+    return stats;
+}
+
+void Profiler::drawOverlay(int width, int height)
+{
+    //! Bottom-left histogram in pixel mode coordinates (origin at the center, y up).
+    const float px_per_ms = 4;
+    const float bar_w = 2;
+    const float x0 = -width / 2.0f + 10;
+    const float y0 = -height / 2.0f + 10;
+    const float max_ms = 50;
+    const vector<FrameStats> stats = frameStats();
+    const float w = FrameHistory * bar_w;
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    glColor4f(0, 0, 0, 0.5f);
+    glBegin(GL_QUADS);
+    glVertex2f(x0, y0);
+    glVertex2f(x0 + w, y0);
+    glVertex2f(x0 + w, y0 + max_ms * px_per_ms);
+    glVertex2f(x0, y0 + max_ms * px_per_ms);
+
+    for (size_t i = 0; i < stats.size(); i++) {
+        const float ms = min(stats[i].cpu_ms, max_ms);
+        const float x = x0 + i * bar_w;
+        if (ms > 1000 / 30.0f) glColor4f(0.9f, 0.2f, 0.2f, 0.9f);
+        else if (ms > 1000 / 60.0f) glColor4f(0.9f, 0.7f, 0.1f, 0.9f);
+        else glColor4f(0.3f, 0.8f, 0.3f, 0.9f);
+        glVertex2f(x, y0);
+        glVertex2f(x + bar_w, y0);
+        glVertex2f(x + bar_w, y0 + ms * px_per_ms);
+        glVertex2f(x, y0 + ms * px_per_ms);
+    }
+    glEnd();
+
+    glLineWidth(1);
+    glBegin(GL_LINES);
+    glColor4f(1, 1, 1, 0.6f);
+    for (float ms : { 1000 / 60.0f, 1000 / 30.0f }) {
+        glVertex2f(x0, y0 + ms * px_per_ms);
+        glVertex2f(x0 + w, y0 + ms * px_per_ms);
+    }
+    glEnd();
+
+    //! GPU time as a line over the bars
+    glColor4f(0.2f, 0.8f, 1.0f, 1.0f);
+    glBegin(GL_LINE_STRIP);
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (stats[i].gpu_ms < 0) continue;
+        glVertex2f(x0 + (i + 0.5f) * bar_w, y0 + min(stats[i].gpu_ms, max_ms) * px_per_ms);
+    }
+    glEnd();
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+/*---[Export]---------------------------------------------------------------------------*/
+bool Profiler::exportChromeTrace(const std::string &filename)
+{
+    FILE *f = fopen(filename.c_str(), "w");
+    if (!f) return false;
+
+    //! Buffers are never freed, so they can be read after the lock is released.
+    vector<ThreadBuffer*> buffers;
+    {
+        lock_guard<mutex> lock(s_mutex);
+        for (auto &b : s_threads) buffers.push_back(b.get());
+    }
+    buffers.push_back(&s_gpu_buffer);
+
+    vector<Event> events;
+    events.reserve(RingSize);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (ThreadBuffer *b : buffers)
+    {
+        const int tid = b->tid < 0 ? 0 : b->tid;
+        const string name = b->tid < 0 ? string("GPU") : "Thread " + to_string(b->tid);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", tid, name.c_str());
+        first = false;
+
+        b->snapshot(events);
+        for (const Event &e : events) {
+            fprintf(f, ",\n{\"name\":\"");
+            jsonEscape(f, e.name);
+            fprintf(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                tid, e.begin / 1e3, (e.end - e.begin) / 1e3);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
+
+void Profiler::clear()
+{
+    lock_guard<mutex> lock(s_mutex);
+    for (auto &b : s_threads) b->reset();
+    s_gpu_buffer.reset();
+}
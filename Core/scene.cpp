@@ -4,7 +4,10 @@
 #include <cassert>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <vvr/bvh.h>
 #include <vvr/drawing.h>
+#include <vvr/profiler.h>
 #include <vvr/scene.h>
 #include <vvr/utils.h>
 
@@ -27,16 +30,28 @@ Scene::Scene()
     m_show_sliders = false;
     m_fov = 66;
     m_first_resize = true;
+    m_target_fps = 0;
     m_2d_center = math::float2{0.0f, 0.0f};
     m_arrow_state[0] = false;
     m_arrow_state[1] = false;
     m_arrow_state[2] = false;
     m_arrow_state[3] = false;
+    m_seed = 0;
+    m_replay_frame = 0;
+    m_replay_event = 0;
+    m_replaying = false;
     setCameraPos(vec(0, 0, DEFAULT_CAM_DIST));
+    SimClock::setCurrent(&m_sim_clock);
+}
+
+Scene::~Scene()
+{
+    if (SimClock::current() == &m_sim_clock) SimClock::setCurrent(nullptr);
 }
 
 void Scene::reset()
 {
+    m_animator.clear();
     setCameraPos(vec(0, 0, DEFAULT_CAM_DIST));
 }
 
@@ -50,6 +65,12 @@ void Scene::drawAxes()
     Axes(2.0f * getSceneWidth()).draw();
 }
 
+void Scene::drawCulled(CullingGroup &group, bool front_to_back)
+{
+    vvr_profile_scope("culled");
+    group.draw(m_frustum, front_to_back);
+}
+
 void Scene::enter2dMode(math::float2 center, math::float2 size)
 {
     // m_2d_center = center;
@@ -227,7 +248,156 @@ void Scene::glRender()
     glLoadMatrixf(pjm.ptr());
     glMatrixMode(GL_MODELVIEW);
     glLoadMatrixf(mvm.ptr());
-    draw();
+
+    {
+        vvr_profile_scope("draw");
+        draw();
+    }
+
+    if (Profiler::enabled() && Profiler::overlayVisible()) {
+        enterPixelMode();
+        Profiler::drawOverlay(m_viewport_width, m_viewport_height);
+        exitPixelMode();
+    }
+}
+
+/*---[Frame / Input dispatch]-----------------------------------------------------------*/
+static bool is_motion(const InputEvent &e)
+{
+    return e.type == InputEvent::MouseMove || e.type == InputEvent::MouseHover;
+}
+
+//! Consecutive motion samples of one run, delivered as one event.
+static bool same_run(const InputEvent &a, const InputEvent &b)
+{
+    return a.type == b.type && a.modif == b.modif;
+}
+
+bool Scene::advance()
+{
+    SimClock::setCurrent(&m_sim_clock);
+
+    if (m_replaying)
+    {
+        const size_t frame = m_replay_frame++;
+        const auto &events = m_replay.events;
+        while (m_replay_event < events.size() && events[m_replay_event].frame <= frame)
+        {
+            //! Regroup the motion runs that flushInput() recorded sample by sample.
+            const size_t i = m_replay_event;
+            size_t j = i + 1;
+            if (is_motion(events[i].event)) {
+                while (j < events.size() && events[j].frame == events[i].frame && same_run(events[j].event, events[i].event)) j++;
+                m_motion.clear();
+                for (size_t k = i; k < j; k++) m_motion.push_back(events[k].event);
+            }
+            m_replay_event = j;
+            deliver(events[j - 1].event);
+        }
+        m_sim_clock.advance(m_replay.frames[frame]);
+        m_replaying = m_replay_frame < m_replay.frames.size();
+        m_animator.update();
+        const bool animating = idle();
+        return animating || m_animator.active() || m_replaying;
+    }
+
+    flushInput();
+    m_sim_clock.advance();
+    if (m_recording) m_recording->frames.push_back(m_sim_clock.frameTime());
+    m_animator.update();
+    const bool animating = idle();
+    return animating || m_animator.active();
+}
+
+void Scene::dispatch(const InputEvent &e)
+{
+    if (m_replaying) return;
+    m_input.push_back(e);
+}
+
+void Scene::flushInput()
+{
+    //! Handlers may queue more input, or even advance a nested frame,
+    //! e.g. by running a modal dialog; the batch is ours alone.
+    std::vector<InputEvent> batch;
+    batch.swap(m_input);
+
+    for (size_t i = 0, j; i < batch.size(); i = j)
+    {
+        j = i + 1;
+        if (is_motion(batch[i])) {
+            while (j < batch.size() && same_run(batch[j], batch[i])) j++;
+            m_motion.assign(batch.begin() + i, batch.begin() + j);
+        }
+
+        //! Every sample of a run is recorded, and the replay groups them again
+        //! by frame, type and modifiers, so it delivers the same m_motion.
+        if (m_recording) {
+            const uint32_t frame = (uint32_t)m_recording->frames.size();
+            for (size_t k = i; k < j; k++) m_recording->events.push_back({ frame, batch[k] });
+        }
+        deliver(batch[j - 1]);
+    }
+
+    //! Keep the capacity.
+    batch.clear();
+    if (m_input.empty()) m_input.swap(batch);
+}
+
+void Scene::deliver(const InputEvent &e)
+{
+    if (is_motion(e) && m_motion.empty()) m_motion.assign(1, e);
+
+    switch (e.type) {
+    case InputEvent::MousePress: mousePressed(e.x, e.y, e.modif); break;
+    case InputEvent::MouseRelease: mouseReleased(e.x, e.y, e.modif); break;
+    case InputEvent::MouseMove: mouseMoved(e.x, e.y, e.modif); break;
+    case InputEvent::MouseHover: mouseHovered(e.x, e.y, e.modif); break;
+    case InputEvent::MouseWheel: mouseWheel(e.x, e.modif); break;
+    case InputEvent::Key: keyEvent((unsigned char)e.key, e.up, e.modif); break;
+    case InputEvent::Slider: sliderChanged(e.x, e.value); break;
+    case InputEvent::Arrow:
+        if (e.key < 0 || e.key >= ArrowDir::SIZE) break;
+        if (!e.up) arrowEvent((ArrowDir)e.key, e.modif);
+        m_arrow_state[e.key] = !e.up;
+        break;
+    }
+
+    m_motion.clear();
+}
+
+void Scene::startRecording(uint32_t seed)
+{
+    m_replaying = false;
+    m_seed = seed;
+    m_recording.reset(new SimRecording);
+    m_recording->seed = seed;
+    m_recording->step = m_sim_clock.step();
+    srand(seed);
+    restartSimulation();
+}
+
+void Scene::startReplay(const SimRecording &recording)
+{
+    m_recording.reset();
+    m_replay = recording;
+    m_input.clear();
+    m_replay_frame = 0;
+    m_replay_event = 0;
+    m_replaying = !m_replay.frames.empty();
+    m_seed = recording.seed;
+    srand(recording.seed);
+    m_sim_clock.setStep(recording.step);
+    restartSimulation();
+}
+
+void Scene::restartSimulation()
+{
+    for (int i = 0; i < ArrowDir::SIZE; i++) m_arrow_state[i] = false;
+    m_sim_clock.reset();
+    m_sim_clock.resume();
+    m_sim_clock.setTimeScale(1);
+    reset();
 }
 
 /*---[Events]---------------------------------------------------------------------------*/
@@ -0,0 +1,145 @@
+#include <vvr/sim_clock.h>
+#include <vvr/utils.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace vvr;
+using namespace std;
+
+#define SIM_RECORDING_HEADER "vvr-sim-recording 1"
+
+static SimClock *s_current = nullptr;
+
+/*--------------------------------------------------------------------------------------*/
+SimClock::SimClock(double step)
+    : m_scale(1)
+    , m_max_steps(8)
+    , m_paused(false)
+{
+    setStep(step);
+    reset();
+}
+
+void SimClock::setStep(double sec)
+{
+    m_step = sec > 0 ? sec : 1.0 / 60;
+}
+
+void SimClock::reset()
+{
+    m_accum = 0;
+    m_last_real = -1;
+    m_frame_sec = 0;
+    m_count = 0;
+    m_steps = 0;
+    m_single_steps = 0;
+}
+
+int SimClock::advance()
+{
+    const double now = get_seconds();
+    const double frame_sec = m_last_real < 0 ? 0 : now - m_last_real;
+    m_last_real = now;
+    return advance(frame_sec);
+}
+
+int SimClock::advance(double frame_sec)
+{
+    m_frame_sec = frame_sec = max(frame_sec, 0.0);
+
+    if (m_paused) {
+        m_steps = min(m_single_steps, m_max_steps);
+        m_single_steps -= m_steps;
+    } else {
+        //! Long hitches (or a scene that was not ticking for a while) would
+        //! otherwise be caught up all at once.
+        m_accum += min(frame_sec * m_scale, m_max_steps * m_step);
+        m_steps = (int)floor(m_accum / m_step);
+        m_accum -= m_steps * m_step;
+        m_steps = min(m_steps, m_max_steps);
+        m_single_steps = 0;
+    }
+
+    m_count += m_steps;
+    return m_steps;
+}
+
+SimClock *SimClock::current()
+{
+    return s_current;
+}
+
+void SimClock::setCurrent(SimClock *clock)
+{
+    s_current = clock;
+}
+
+double vvr::sim_seconds()
+{
+    return s_current ? s_current->seconds() : get_seconds();
+}
+
+/*---[Recording]------------------------------------------------------------------------
+ * Plain text. Times are written as hex floats, so that they read back bit-exact.
+ */
+bool SimRecording::save(const string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "w");
+    if (!file) return false;
+
+    fprintf(file, SIM_RECORDING_HEADER "\n");
+    fprintf(file, "seed %u\n", seed);
+    fprintf(file, "step %a\n", step);
+    fprintf(file, "frames %zu\n", frames.size());
+    for (double dt : frames) fprintf(file, "%a\n", dt);
+    fprintf(file, "events %zu\n", events.size());
+    for (const Event &e : events) {
+        const InputEvent &ie = e.event;
+        fprintf(file, "%u %d %d %d %d %d %d %a\n", e.frame, (int)ie.type,
+            ie.x, ie.y, ie.modif, ie.key, (int)ie.up, (double)ie.value);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool SimRecording::load(const string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "r");
+    if (!file) return false;
+
+    SimRecording rec;
+    char header[64] = { 0 };
+    size_t num_frames = 0, num_events = 0;
+    bool ok = fgets(header, sizeof(header), file) &&
+        !strncmp(header, SIM_RECORDING_HEADER, strlen(SIM_RECORDING_HEADER)) &&
+        fscanf(file, " seed %u", &rec.seed) == 1 &&
+        fscanf(file, " step %la", &rec.step) == 1 &&
+        fscanf(file, " frames %zu", &num_frames) == 1;
+
+    for (size_t i = 0; ok && i < num_frames; i++) {
+        double dt;
+        ok = fscanf(file, " %la", &dt) == 1;
+        rec.frames.push_back(dt);
+    }
+
+    ok = ok && fscanf(file, " events %zu", &num_events) == 1;
+
+    for (size_t i = 0; ok && i < num_events; i++) {
+        Event e;
+        int type, up;
+        double value;
+        ok = fscanf(file, " %u %d %d %d %d %d %d %la", &e.frame, &type, &e.event.x,
+            &e.event.y, &e.event.modif, &e.event.key, &up, &value) == 8;
+        e.event.type = (InputEvent::Type)type;
+        e.event.up = up != 0;
+        e.event.value = (float)value;
+        rec.events.push_back(e);
+    }
+
+    fclose(file);
+    if (ok) *this = rec;
+    return ok;
+}
+/*--------------------------------------------------------------------------------------*/
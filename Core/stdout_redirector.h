@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <mutex>
 #include <streambuf>
 
 template< class Elem = char, class Tr = std::char_traits< Elem > >
@@ -8,6 +10,12 @@ class StdRedirector : public std::basic_streambuf < Elem, Tr >
     */
     typedef void(*pfncb) (const Elem*, std::streamsize _Count, void* pUsrData);
 
+    /**
+    * Single characters are collected up to a newline or this many, so that
+    * the callback gets whole lines rather than one call per character.
+    */
+    static const std::streamsize LineSize = 240;
+
 public:
     /**
     * Constructor.
@@ -19,7 +27,8 @@ public:
         m_Stream(a_Stream),
         m_pCbFunc(a_Cb),
         m_pUserData(a_pUsrData),
-        m_paused(false)
+        m_paused(false),
+        m_len(0)
     {
         //redirect stream
         m_pBuf = m_Stream.rdbuf(this);
@@ -32,29 +41,63 @@ public:
     ~StdRedirector()
     {
         m_Stream.rdbuf(m_pBuf);
+        sync();
     }
 
     /**
-    * Override xsputn and make it forward data to the callback function.
+    * Override xsputn and make it forward data to the callback function,
+    * after the characters collected so far. A trailing partial line is
+    * collected too, if it fits.
     */
     std::streamsize xsputn(const Elem* _Ptr, std::streamsize _Count)
     {
         if (m_paused) return _Count;
-        m_pCbFunc(_Ptr, _Count, m_pUserData);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::streamsize tail = 0;
+        while (tail < _Count && _Ptr[_Count - 1 - tail] != Tr::to_char_type('\n')) tail++;
+        if (tail > LineSize) tail = 0;
+
+        const std::streamsize head = _Count - tail;
+        if (head > 0) {
+            if (m_len + head <= LineSize) {
+                append(_Ptr, head);
+                flushLine();
+            } else {
+                flushLine();
+                m_pCbFunc(_Ptr, head, m_pUserData);
+            }
+        }
+        if (tail > 0) {
+            if (m_len + tail > LineSize) flushLine();
+            append(_Ptr + head, tail);
+        }
         return _Count;
     }
 
     /**
-    * Override overflow and make it forward data to the callback function.
+    * Override overflow and collect the character, up to a newline.
     */
     typename Tr::int_type overflow(typename Tr::int_type v)
     {
-        if (m_paused) return Tr::not_eof(v);
-        Elem ch = Tr::to_char_type(v);
-        m_pCbFunc(&ch, 1, m_pUserData);
+        if (m_paused || Tr::eq_int_type(v, Tr::eof())) return Tr::not_eof(v);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Elem ch = Tr::to_char_type(v);
+        if (m_len == LineSize) flushLine();
+        m_line[m_len++] = ch;
+        if (ch == Tr::to_char_type('\n')) flushLine();
         return Tr::not_eof(v);
     }
 
+    /**
+    * Override sync (std::flush, std::endl) and forward a partial line.
+    */
+    int sync()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        flushLine();
+        return 0;
+    }
+
     void pause()
     {
         m_paused = true;
@@ -71,6 +114,22 @@ protected:
     pfncb                         m_pCbFunc;
     void*                         m_pUserData;
 
+private:
+    void append(const Elem* ptr, std::streamsize count)
+    {
+        std::copy(ptr, ptr + count, m_line + m_len);
+        m_len += count;
+    }
+
+    void flushLine()
+    {
+        if (m_len) m_pCbFunc(m_line, m_len, m_pUserData);
+        m_len = 0;
+    }
+
 private:
     bool m_paused;
+    std::mutex m_mutex;
+    Elem m_line[LineSize];
+    std::streamsize m_len;
 };
@@ -26,14 +26,22 @@
 
 using namespace std;
 
+static float s_synthetic_seconds = -1;
+
 float vvr::get_seconds()
 {
+    if (s_synthetic_seconds >= 0) return s_synthetic_seconds;
     static quint64 msec_base = 0;
     quint64 msec = QDateTime::currentMSecsSinceEpoch();
     if (msec_base==0) msec_base=msec;
     return (float) (msec-msec_base) / 1000.0;
 }
 
+void vvr::set_synthetic_seconds(float sec)
+{
+    s_synthetic_seconds = sec;
+}
+
 string vvr::get_exe_path()
 {
 #ifdef __linux__
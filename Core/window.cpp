@@ -1,5 +1,6 @@
 #include "window.h"
 #include <vvr/glwidget.h>
+#include <vvr/headless.h>
 #include <vvr/scene.h>
 #include <vvr/scene_modern.h>
 #include <vvr/command.h>
@@ -31,9 +32,12 @@ vvr::Window::Window(vvr::Scene *scene) : m_scene(scene)
     scene->cursorHand.add(new vvr::SimpleCmd<Window>(this, &Window::cursor_hand));
     scene->cursorGrab.add(new vvr::SimpleCmd<Window>(this, &Window::cursor_grab));
 
-    /* Redirect std::cout to our custom logging widget */
+    /* Redirect std::cout to our custom logging widget, through the LogSink */
     m_std_cout_logger = new StdRedirector<>(std::cout, &Window::s_log_cout, this);
     m_std_cerr_logger = new StdRedirector<>(std::cerr, &Window::s_log_cerr, this);
+    m_log_line_open = false;
+    ui.plain_text_log->setMaximumBlockCount(10000);
+    LogSink::setNotify(&Window::s_log_pending, this);
 
     /* Init glwidget */
     m_glwidget = new vvr::GlWidget(scene);
@@ -81,6 +85,11 @@ vvr::Window::Window(vvr::Scene *scene) : m_scene(scene)
     resize(1400, 800);
 }
 
+vvr::Window::~Window()
+{
+    LogSink::setNotify(nullptr, nullptr);
+}
+
 void vvr::Window::createActions()
 {
     //! Action Exit
@@ -109,8 +118,12 @@ void vvr::Window::about()
 void vvr::Window::sliderMoved(int val)
 {
     const int id = std::stoi(vvr::split(sender()->objectName().toStdString(), '_').back());
-    m_scene->sliderChanged(id, val / 100.0f);
-    m_glwidget->update();
+    InputEvent e;
+    e.type = InputEvent::Slider;
+    e.x = id;
+    e.value = val / 100.0f;
+    m_scene->dispatch(e);
+    m_glwidget->idle();
 }
 
 void vvr::Window::focusToGlWidget()
@@ -118,59 +131,48 @@ void vvr::Window::focusToGlWidget()
     m_glwidget->setFocus();
 }
 
-void vvr::Window::s_log_cout(const char* ptr, std::streamsize count, void* pte)
+void vvr::Window::s_log_cout(const char* ptr, std::streamsize count, void*)
 {
-    printf("%.*s", (int)count, ptr);
-    vvr::Window *window = static_cast<vvr::Window*>(pte);
-    const QString str = QString::fromLocal8Bit(ptr, count);
-    window->log_cout(str);
+    LogSink::write(LogSink::Out, ptr, (size_t)count);
 }
 
-void vvr::Window::s_log_cerr(const char* ptr, std::streamsize count, void* pte)
+void vvr::Window::s_log_cerr(const char* ptr, std::streamsize count, void*)
 {
-    fprintf(stderr, "%.*s", (int)count, ptr);
-    vvr::Window *window = static_cast<vvr::Window*>(pte);
-    const QString str = QString::fromLocal8Bit(ptr, count);
-    window->log_cerr(str);
+    LogSink::write(LogSink::Err, ptr, (size_t)count);
 }
 
-void vvr::Window::log_cout(const QString &str)
+//! Called on the LogSink thread; the lines are shown on the GUI thread.
+void vvr::Window::s_log_pending(void *window)
 {
-    QScrollBar *vScrollBar = ui.plain_text_log->verticalScrollBar();
-    const bool keep_on_bottom = vScrollBar->value() == vScrollBar->maximum();
-
-    //! Print text
-    ui.plain_text_log->moveCursor(QTextCursor::End);
-    QString html = str.toHtmlEscaped();
-    html.replace(QChar(' '), QString("&nbsp;"), Qt::CaseInsensitive);
-    ui.plain_text_log->textCursor().insertHtml("<font color=\"White\">" + html + "</font>");
-    ui.plain_text_log->moveCursor(QTextCursor::End);
-
-    //! New line
-    if (str.at(str.length() - 1) == '\n') {
-        ui.plain_text_log->appendPlainText("");
-    }
-
-    if (keep_on_bottom) {
-        vScrollBar->triggerAction(QScrollBar::SliderToMaximum);
-    }
+    QMetaObject::invokeMethod(static_cast<Window*>(window), "flushLog", Qt::QueuedConnection);
 }
 
-void vvr::Window::log_cerr(const QString &str)
+/**
+ * Shows what the LogSink formatted since the last call. New lines queue one
+ * call at a time, so chatty code doesn't stall the GUI thread on the widget.
+ */
+void vvr::Window::flushLog()
 {
+    std::vector<LogSink::Line> lines;
+    const size_t dropped = LogSink::take(lines);
+    if (lines.empty() && !dropped) return;
+
     QScrollBar *vScrollBar = ui.plain_text_log->verticalScrollBar();
     const bool keep_on_bottom = vScrollBar->value() == vScrollBar->maximum();
 
-    //! Print text
-    QString html = str.toHtmlEscaped();
-    html.replace(QChar(' '), QString("&nbsp;"), Qt::CaseInsensitive);
-    ui.plain_text_log->moveCursor(QTextCursor::End);
-    ui.plain_text_log->textCursor().insertHtml("<font color=\"Red\">" + html + "</font>");
-    ui.plain_text_log->moveCursor(QTextCursor::End);
+    for (const LogSink::Line &line : lines) {
+        if (m_log_line_open) {
+            ui.plain_text_log->moveCursor(QTextCursor::End);
+            ui.plain_text_log->textCursor().insertHtml(QString::fromLocal8Bit(line.html.c_str()));
+        } else {
+            ui.plain_text_log->appendHtml(QString::fromLocal8Bit(line.html.c_str()));
+        }
+        m_log_line_open = !line.complete;
+    }
 
-    //! New line
-    if (str.at(str.length() - 1) == '\n') {
-        ui.plain_text_log->appendPlainText("");
+    if (dropped) {
+        ui.plain_text_log->appendHtml(QString("<font color=\"Orange\">[%1 log messages dropped]</font>").arg((qulonglong)dropped));
+        m_log_line_open = false;
     }
 
     if (keep_on_bottom) {
@@ -201,6 +203,25 @@ void vvr::Window::cursor_grab()
 //!---
 int vvr::main_with_scene(int argc, char* argv[], vvr::Scene *scene)
 {
+    HeadlessOptions headless;
+    if (HeadlessOptions::parse(argc, argv, headless)) {
+        const int ret = HeadlessRunner::run(argc, argv, scene, headless);
+        delete scene;
+        return ret;
+    }
+
+    SimRecording replay;
+    if (!headless.replay.empty()) {
+        if (!replay.load(headless.replay)) {
+            std::cerr << "Could not read recording " << headless.replay << std::endl;
+            delete scene;
+            return 1;
+        }
+        scene->startReplay(replay);
+    } else if (!headless.record.empty()) {
+        scene->startRecording(headless.seed);
+    }
+
     QApplication app(argc, argv);
     if (scene->getName() == SceneModern::name)
     {
@@ -218,6 +239,9 @@ int vvr::main_with_scene(int argc, char* argv[], vvr::Scene *scene)
     win.show();//Maximized();
     win.focusToGlWidget();
     app.exec();
+    if (scene->getRecording() && !scene->getRecording()->save(headless.record)) {
+        std::cerr << "Could not write recording " << headless.record << std::endl;
+    }
     delete scene;
     return 0;
 }
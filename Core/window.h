@@ -5,6 +5,7 @@
 #include "stdout_redirector.h"
 #include <vvr/glwidget.h>
 #include <vvr/scene.h>
+#include <vvr/log.h>
 
 namespace vvr {
 
@@ -15,6 +16,7 @@ class VVRFramework_API Window : public QMainWindow
 
 public:
     Window(vvr::Scene *scene);
+    ~Window();
     void focusToGlWidget();
     void cursor_show();
     void cursor_hide();
@@ -26,8 +28,7 @@ private slots:
     void sliderMoved(int val);
     void createActions();
     void createMenus();
-    void log_cout(const QString &str);
-    void log_cerr(const QString &str);
+    void flushLog();
 
 private:
     QMenu *fileMenu;
@@ -36,12 +37,14 @@ private:
     QAction *aboutAct;
     StdRedirector<> *m_std_cout_logger;
     StdRedirector<> *m_std_cerr_logger;
+    bool m_log_line_open;           ///< The last line shown had no newline yet
     GlWidget *m_glwidget;
     Scene *m_scene;
 
 private:
     static void s_log_cout(const char* ptr, std::streamsize count, void*);
     static void s_log_cerr(const char* ptr, std::streamsize count, void*);
+    static void s_log_pending(void *window);
     static QString aboutMessage;
 };
 
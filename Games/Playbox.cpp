@@ -12,17 +12,17 @@
 #include <vector>
 
 #include <vvr/animation.h>
-#include <vvr/counter.h>
 #include <vvr/drawing.h>
 #include <vvr/macros.h>
 #include <vvr/mesh.h>
 #include <vvr/palette.h>
 #include <vvr/picking.h>
+#include <vvr/profiler.h>
 #include <vvr/scene.h>
 #include <vvr/settings.h>
 #include <vvr/utils.h>
 
-#define BENCHMARKS_ON 0
+#include "physics_service.h"
 
 typedef std::vector<vvr::Point3D *> PointVector;
 
@@ -258,43 +258,66 @@ createRoadFromPts(PointVector const &road_pts, vvr::Canvas &road)
   }
 }
 
+/*---[Box2D]-----------------------------------------------------------------*/
+
+b2Body *
+createBox(b2World &world, b2Vec2 pos)
+{
+  b2BodyDef bodyDef;
+  b2PolygonShape dynamicBox;
+  b2FixtureDef fixtureDef;
+  bodyDef.type = b2_dynamicBody;
+  bodyDef.position = pos;
+  bodyDef.angularVelocity = 0.25f * M_PI;
+  dynamicBox.SetAsBox(1.0f, 0.2f);
+  fixtureDef.shape = &dynamicBox;
+  fixtureDef.density = 0.2f;
+  fixtureDef.friction = 1.0f;
+  b2Body *body = world.CreateBody(&bodyDef);
+  body->CreateFixture(&fixtureDef);
+  return body;
+}
+
 /*---[Box2D Drawing]---------------------------------------------------------*/
 
 void
-drawWheel(b2Body *bodyBall, vvr::Colour col)
+drawWheel(PhysicsService::BodyState const &ball, vvr::Colour col)
 {
-  auto bodyPos = bodyBall->GetPosition();
-  const auto r = bodyBall->GetFixtureList()->GetShape()->m_radius;
-  Wheel w(r, {bodyPos.x, bodyPos.y}, -bodyBall->GetAngle(), col);
+  Wheel w(ball.radius, {ball.pos.x, ball.pos.y}, -ball.angle, col);
   w.draw();
 }
 
 void
-drawBox(b2Body *bodyBox, vvr::Colour colour = vvr::black)
+drawBox(PhysicsService::BodyState const &box, vvr::Colour colour = vvr::black)
 {
-  vvr::Canvas c;
-  auto bodyPos = bodyBox->GetPosition();
-  auto bodyAngle = bodyBox->GetAngle();
-  auto shape = bodyBox->GetFixtureList()->GetShape();
-  auto polyg = dynamic_cast<b2PolygonShape *>(shape);
-
-  C2DPointSet ps;
-  ps.AddCopy(polyg->m_vertices[0].x, polyg->m_vertices[0].y);
-  ps.AddCopy(polyg->m_vertices[1].x, polyg->m_vertices[1].y);
-  ps.AddCopy(polyg->m_vertices[2].x, polyg->m_vertices[2].y);
-  ps.AddCopy(polyg->m_vertices[3].x, polyg->m_vertices[3].y);
+  const float c = cos(box.angle);
+  const float s = sin(box.angle);
+  const b2Vec2 ax{c * box.half.x, s * box.half.x};
+  const b2Vec2 ay{-s * box.half.y, c * box.half.y};
+  const b2Vec2 p0 = box.pos - ax - ay;
+  const b2Vec2 p1 = box.pos + ax - ay;
+  const b2Vec2 p2 = box.pos + ax + ay;
+  const b2Vec2 p3 = box.pos - ax + ay;
 
-  ps.RotateToRight(-bodyAngle, {0, 0});
-  ps.Move({bodyPos.x, bodyPos.y});
-
-  C2DPolygon polygon(ps);
-  vvr::draw(polygon, colour, true);
+  vvr::Triangle2D t(p0.x, p0.y, p1.x, p1.y, p2.x, p2.y, colour);
+  t.filled = true;
+  t.draw();
+  t.set(p0.x, p0.y, p2.x, p2.y, p3.x, p3.y);
+  t.draw();
 }
 
 } // namespace
 
 /*---[RollingDisks]----------------------------------------------------------*/
 
+struct GameControls
+{
+  bool brake = false;
+  bool gas = false;
+  bool downforce = false;
+  bool upforce = false;
+};
+
 class PlayboxScene : public vvr::Scene
 {
 public:
@@ -318,8 +341,11 @@ private:
 private:
   void setCenterTarget();
   void setupPhysics();
-  void simulatePhysics();
-  void drawPhysics() const;
+  void readControls();
+  void applyControls();
+  void simulatePhysics(int steps = 1);
+  void spawnBoxes(int count);
+  void drawPhysics(PhysicsService::Snapshot const &snap, float alpha) const;
 
 private:
   float gbW, gbH;
@@ -337,9 +363,12 @@ private:
   math::float2 dragAnchor{hugef, hugef};
   math::float2 worldSize;
   bool keepCentered;
+  GameControls controls;
+  bool arrowDownWasPressed = false;
+  bool arrowUpWasPressed = false;
 
-  // Physics:
-  b2World *world = nullptr;
+  // Physics. Bodies belong to the physics thread once it has started:
+  std::unique_ptr<PhysicsService> physics;
   b2Body *groundBody = nullptr;
   b2Body *ballBody1 = nullptr;
   b2Body *ballBody2 = nullptr;
@@ -391,7 +420,7 @@ PlayboxScene::reset()
 void
 PlayboxScene::setCenterTarget()
 {
-  const auto &pos = ballBody1->GetPosition();
+  const auto &pos = physics->latest().bodies[0].pos;
   auto newx = pos.x;
   auto newy = step(pos.y, worldSize.y) + worldSize.y * 0.48;
   const math::float2 newCenter(newx, newy);
@@ -403,19 +432,15 @@ PlayboxScene::setupPhysics()
 {
   simulationTime = {0};
 
-  if (world) {
-    delete world;
-    world = nullptr;
-    groundBody = nullptr;
-    ballBody1 = nullptr;
-    boxBodies.clear();
-  }
+  physics.reset();
+  groundBody = nullptr;
+  ballBody1 = nullptr;
+  ballBody2 = nullptr;
+  boxBodies.clear();
 
-  {
-    // Create world:
-    b2Vec2 gravity(0.0f, -10.0f);
-    world = new b2World(gravity);
-  }
+  // Create world:
+  physics.reset(new PhysicsService({0.0f, -10.0f}, (float)getClock().step()));
+  b2World *world = &physics->world();
 
   {
     // Create ground:
@@ -496,31 +521,48 @@ PlayboxScene::setupPhysics()
     world->CreateJoint(&jointDef);
   }
 
+  // Snapshot indices: balls first, then boxes.
+  physics->track(ballBody1);
+  physics->track(ballBody2);
+
   for (int i = 0; i < numBoxes; ++i) {
-    // Create boxes:
-    b2BodyDef bodyDef;
-    b2PolygonShape dynamicBox;
-    b2FixtureDef fixtureDef;
-    bodyDef.type = b2_dynamicBody;
-    bodyDef.position.Set(4.0f * i, 8.0f);
-    bodyDef.angularVelocity = 0.25f * M_PI;
-    dynamicBox.SetAsBox(1.0f, 0.2f);
-    fixtureDef.shape = &dynamicBox;
-    fixtureDef.density = 0.2f;
-    fixtureDef.friction = 1.0f;
-    boxBodies.push_back(world->CreateBody(&bodyDef));
-    boxBodies.back()->CreateFixture(&fixtureDef);
+    boxBodies.push_back(createBox(*world, {4.0f * i, 8.0f}));
+    physics->track(boxBodies.back());
   }
+
+  physics->start();
+}
+
+void
+PlayboxScene::spawnBoxes(int count)
+{
+  physics->post([this, count](b2World &world) {
+    // Rain boxes over the cars, in a few rows:
+    const b2Vec2 pos = ballBody1->GetPosition();
+    for (int i = 0; i < count; ++i) {
+      const float x = pos.x - 10.0f + (i % 20) * 1.0f;
+      const float y = pos.y + 6.0f + (i / 20) * 0.5f;
+      boxBodies.push_back(createBox(world, {x, y}));
+      physics->track(boxBodies.back());
+    }
+  });
 }
 
 bool
 PlayboxScene::idle()
 {
-#if BENCHMARKS_ON
-  ScopedCounter counter{"idle"};
-#endif
+  vvr_profile_scope("scene idle");
 
-  double dt = anim.update();
+  anim.update();
+
+  if (!anim.paused()) {
+    // Physics runs in fixed steps of the scene clock, independent of the frame rate:
+    readControls();
+    for (int i = 0; i < getClock().steps(); ++i) {
+      applyControls();
+      simulatePhysics();
+    }
+  }
 
   if (keepCentered) {
     setCenterTarget();
@@ -532,77 +574,79 @@ PlayboxScene::idle()
 }
 
 void
-PlayboxScene::simulatePhysics()
+PlayboxScene::simulatePhysics(int steps)
 {
-  float timeStep = 1.0f / 60.0f;
-  int32 velocityIterations = 6;
-  int32 positionIterations = 2;
-  world->Step(timeStep, velocityIterations, positionIterations);
-  simulationTime += timeStep;
+  physics->step(steps);
+  simulationTime += steps * physics->timeStep;
 }
 
-struct GameControls
-{
-  bool brake = false;
-  bool gas = false;
-  bool downforce = false;
-  bool upforce = false;
-};
-
 void
-PlayboxScene::draw()
+PlayboxScene::readControls()
 {
-#if BENCHMARKS_ON
-  ScopedCounter counter{"drawing"};
-#endif
-
-  static bool arrowDownWasPressed = false;
-  static bool arrowUpWasPressed = false;
+  const bool arrowDownIsPressed = isArrowDown(vvr::DOWN);
+  const bool arrowUpIsPressed = isArrowDown(vvr::UP);
 
-  bool arrowDownIsPressed = isArrowDown(vvr::DOWN);
-  bool arrowUpIsPressed = isArrowDown(vvr::UP);
+  controls.brake = isArrowDown(vvr::LEFT);
+  controls.gas = isArrowDown(vvr::RIGHT);
+  // Impulses are latched until the next physics step consumes them:
+  controls.downforce |= arrowDownIsPressed && !arrowDownWasPressed;
+  controls.upforce |= arrowUpIsPressed && !arrowUpWasPressed;
 
-  const GameControls con{
-    .brake = isArrowDown(vvr::LEFT),
-    .gas = isArrowDown(vvr::RIGHT),
-    .downforce = arrowDownIsPressed && !arrowDownWasPressed,
-    .upforce = arrowUpIsPressed && !arrowUpWasPressed,
-  };
+  if (arrowUpIsPressed && !arrowUpWasPressed) {
+    upIndicatorAnim = {1, 0, upIndicator, 0.2};
+  }
 
   arrowDownWasPressed = arrowDownIsPressed;
   arrowUpWasPressed = arrowUpIsPressed;
+}
 
-  if (!anim.paused()) {
+void
+PlayboxScene::applyControls()
+{
+  const GameControls con = controls;
+  controls.downforce = false;
+  controls.upforce = false;
+
+  if (!con.brake && !con.gas && !con.downforce && !con.upforce) {
+    return;
+  }
+
+  // Forces are cleared after every step, so they are sent along with each one:
+  b2Body *const ball1 = ballBody1;
+  b2Body *const ball2 = ballBody2;
+  physics->post([con, ball1, ball2](b2World &) {
     constexpr auto torque = 0.4f;
     constexpr auto force = 0.2f;
     constexpr auto impulse = 0.4f;
 
     if (con.brake) {
-      ballBody1->ApplyTorque(torque, true);
-      ballBody2->ApplyTorque(torque, true);
-      ballBody1->ApplyForceToCenter({-force, 0}, true);
-      ballBody2->ApplyForceToCenter({-force, 0}, true);
+      ball1->ApplyTorque(torque, true);
+      ball2->ApplyTorque(torque, true);
+      ball1->ApplyForceToCenter({-force, 0}, true);
+      ball2->ApplyForceToCenter({-force, 0}, true);
     } else if (con.gas) {
-      ballBody1->ApplyTorque(-torque, true);
-      ballBody2->ApplyTorque(-torque, true);
-      ballBody1->ApplyForceToCenter({+force, 0}, true);
-      ballBody2->ApplyForceToCenter({+force, 0}, true);
+      ball1->ApplyTorque(-torque, true);
+      ball2->ApplyTorque(-torque, true);
+      ball1->ApplyForceToCenter({+force, 0}, true);
+      ball2->ApplyForceToCenter({+force, 0}, true);
     }
 
     if (con.downforce) {
-      ballBody1->ApplyLinearImpulseToCenter({0, -impulse * 2}, true);
-      ballBody2->ApplyLinearImpulseToCenter({0, -impulse * 2}, true);
+      ball1->ApplyLinearImpulseToCenter({0, -impulse * 2}, true);
+      ball2->ApplyLinearImpulseToCenter({0, -impulse * 2}, true);
     } else if (con.upforce) {
-      ballBody1->ApplyLinearImpulseToCenter({0, +impulse}, true);
-      ballBody2->ApplyLinearImpulseToCenter({0, +impulse}, true);
+      ball1->ApplyLinearImpulseToCenter({0, +impulse}, true);
+      ball2->ApplyLinearImpulseToCenter({0, +impulse}, true);
     }
+  });
+}
 
-    if (con.upforce) {
-      upIndicatorAnim = {1, 0, upIndicator, 0.2};
-    }
+void
+PlayboxScene::draw()
+{
+  vvr_profile_scope("scene draw");
 
-    simulatePhysics();
-  }
+  const GameControls &con = controls;
 
   enterPixelMode();
 
@@ -663,7 +707,7 @@ PlayboxScene::draw()
       {vvr::Shape::LineWidth,  5.0f}
     };
 
-    drawPhysics();
+    drawPhysics(physics->latest(), getClock().alpha());
     road.draw();
   }
 
@@ -673,7 +717,7 @@ PlayboxScene::draw()
 }
 
 void
-PlayboxScene::drawPhysics() const
+PlayboxScene::drawPhysics(PhysicsService::Snapshot const &snap, float alpha) const
 {
   // Draw ground:
   const auto col = vvr::Aquamarine;
@@ -682,60 +726,30 @@ PlayboxScene::drawPhysics() const
   vvr::LineSeg2D(gbW, -gbH * 2, -gbW, -gbH * 2, col).draw();
   vvr::LineSeg2D(-gbW, -gbH * 2, -gbW, 0, col).draw();
 
-  // Draw balls:
-  drawWheel(ballBody1, vvr::red);
-  drawWheel(ballBody2, vvr::green);
-  vvr::LineSeg2D(ballBody1->GetPosition().x,
-    ballBody1->GetPosition().y,
-    ballBody2->GetPosition().x,
-    ballBody2->GetPosition().y,
-    vvr::black)
-    .draw();
-
-  // Draw boxes:
-  for (auto body : boxBodies) {
-    drawBox(body);
+  if (snap.bodies.size() < 2) {
+    return;
   }
 
-  // Draw contact points and bodies:
-  for (b2Contact *con = world->GetContactList(); con; con = con->GetNext()) {
-
-    auto bodyA = con->GetFixtureA()->GetBody();
-    auto bodyB = con->GetFixtureB()->GetBody();
-
-    auto drawTouchingBoxes = [&](b2Body *ballBody) {
-      b2Body *otherBody = nullptr;
-      b2PolygonShape *polygon = nullptr;
-
-      if (bodyB == ballBody) {
-        otherBody = bodyA;
-      } else if (bodyA == ballBody) {
-        otherBody = bodyB;
-      }
-
-      if (otherBody == groundBody) {
-        return;
-      }
-
-      if (otherBody && con->GetManifold()->pointCount) {
-        auto shape = otherBody->GetFixtureList()[0].GetShape();
-        polygon = dynamic_cast<b2PolygonShape *>(shape);
-      }
-
-      if (polygon && polygon->m_count == 4) {
-        drawBox(bodyA, vvr::red);
-      }
-    };
-
-    drawTouchingBoxes(ballBody1);
-    drawTouchingBoxes(ballBody2);
+  // Draw balls:
+  const auto ball1 = PhysicsService::lerp(snap, 0, alpha);
+  const auto ball2 = PhysicsService::lerp(snap, 1, alpha);
+  drawWheel(ball1, vvr::red);
+  drawWheel(ball2, vvr::green);
+  vvr::LineSeg2D(ball1.pos.x, ball1.pos.y, ball2.pos.x, ball2.pos.y, vvr::black).draw();
+
+  // Draw boxes, red when touching a ball:
+  std::vector<bool> touchingBall(snap.bodies.size(), false);
+  for (const auto &pair : snap.touching) {
+    if (pair.first < 2) touchingBall[pair.second] = true;
+    if (pair.second < 2) touchingBall[pair.first] = true;
+  }
+  for (size_t i = 2; i < snap.bodies.size(); ++i) {
+    drawBox(PhysicsService::lerp(snap, i, alpha), touchingBall[i] ? vvr::red : vvr::black);
+  }
 
-    b2WorldManifold worldManifold;
-    con->GetWorldManifold(&worldManifold);
-    for (int i = 0; i < con->GetManifold()->pointCount; ++i) {
-      b2Vec2 pos = worldManifold.points[i];
-      vvr::Point2D(pos.x, pos.y, vvr::yellow).draw();
-    }
+  // Draw contact points:
+  for (const b2Vec2 &pos : snap.contacts) {
+    vvr::Point2D(pos.x, pos.y, vvr::yellow).draw();
   }
 }
 
@@ -752,6 +766,7 @@ PlayboxScene::resize()
     std::cout << "Press '-' to zoom out." << std::endl;
     std::cout << "Press '+' to zoom in." << std::endl;
     std::cout << "Press 'left'/'right' to move." << std::endl;
+    std::cout << "Press 'n' to drop 100 boxes." << std::endl;
   }
 
   worldSize.y = worldSize.x * getViewportHeight() / getViewportWidth();
@@ -818,9 +833,14 @@ PlayboxScene::keyEvent(unsigned char key, bool up, int modif)
     }
     break;
   case 'i': {
-    const auto &pos = ballBody1->GetPosition();
+    const auto &snap = physics->latest();
+    const auto &pos = snap.bodies[0].pos;
     std::cout << "Ball pos: [" << pos.x << ", " << pos.y << "]" << std::endl;
+    std::cout << "Bodies: " << snap.bodies.size() << ", steps behind: " << physics->pending() << std::endl;
   } break;
+  case 'n':
+    spawnBoxes(100);
+    break;
   }
 
   if (key >= '0' && key <= '9') {
@@ -0,0 +1,269 @@
+#ifndef PHYSICS_SERVICE_H
+#define PHYSICS_SERVICE_H
+
+#include <box2d/box2d.h>
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*---[PhysicsService]--------------------------------------------------------*/
+
+/**
+ * Owns a b2World and steps it on its own thread.
+ *
+ * The world may be set up directly until start(); afterwards it belongs to
+ * the physics thread and is only touched through commands, which run in the
+ * order they were posted, interleaved with the requested steps. After every
+ * step the states of the tracked bodies are published through a lock-free
+ * triple buffer, so the render thread never waits for physics and physics
+ * never waits for rendering. Each snapshot also holds the states of the
+ * step before, so draw() can interpolate with the clock alpha.
+ *
+ * The number of steps comes from the caller (the scene clock), which keeps
+ * runs deterministic; the thread only decides when they are computed.
+ */
+class PhysicsService
+{
+public:
+  struct BodyState
+  {
+    b2Vec2 pos{0, 0};
+    float angle = 0;
+    float radius = 0; // Circles
+    b2Vec2 half{0, 0}; // Boxes: half extents
+  };
+
+  struct Snapshot
+  {
+    uint64_t step = 0; // Steps simulated so far
+    std::vector<BodyState> bodies; // Indexed as returned by track()
+    std::vector<BodyState> previous; // Same bodies, one step earlier
+    std::vector<b2Vec2> contacts; // Contact points, world coordinates
+    std::vector<std::pair<int, int>> touching; // Tracked bodies in contact
+  };
+
+  typedef std::function<void(b2World &)> Command;
+
+  PhysicsService(b2Vec2 gravity, float timeStep, int velocityIterations = 6, int positionIterations = 2)
+    : timeStep(timeStep)
+    , world_(new b2World(gravity))
+    , velocityIterations(velocityIterations)
+    , positionIterations(positionIterations)
+  {}
+
+  ~PhysicsService() { stop(); }
+
+  PhysicsService(const PhysicsService &) = delete;
+  PhysicsService &operator=(const PhysicsService &) = delete;
+
+  //! Direct access; only before start() or from inside a command.
+  b2World &world() { return *world_; }
+
+  //! Publish the state of a body. Before start() or from inside a command.
+  int
+  track(b2Body *body)
+  {
+    const int index = (int)tracked.size();
+    tracked.push_back(body);
+    indices[body] = index;
+    return index;
+  }
+
+  void
+  start()
+  {
+    if (thread.joinable()) return;
+    publish(); // Initial state, before any step
+    quit = false;
+    thread = std::thread(&PhysicsService::run, this);
+  }
+
+  //! Pending commands and steps are dropped.
+  void
+  stop()
+  {
+    if (!thread.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+    }
+    cv.notify_one();
+    thread.join();
+  }
+
+  void
+  post(Command command)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back({std::move(command), 0});
+    }
+    cv.notify_one();
+  }
+
+  void
+  step(int n = 1)
+  {
+    if (n <= 0) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!queue.empty() && !queue.back().command) {
+        queue.back().steps += n;
+      } else {
+        queue.push_back({nullptr, n});
+      }
+      backlog += n;
+    }
+    cv.notify_one();
+  }
+
+  //! Steps requested but not computed yet.
+  int pending() const { return backlog.load(std::memory_order_relaxed); }
+
+  /**
+   * Latest published snapshot. Stays valid and unchanged until the next
+   * call, so call it once per frame, from a single thread.
+   */
+  const Snapshot &
+  latest()
+  {
+    if (middle.load(std::memory_order_relaxed) & Fresh) {
+      front = middle.exchange(front, std::memory_order_acq_rel) & Index;
+    }
+    return buffers[front];
+  }
+
+  static BodyState
+  lerp(const Snapshot &s, size_t i, float alpha)
+  {
+    BodyState b = s.bodies[i];
+    if (i < s.previous.size()) {
+      const BodyState &a = s.previous[i];
+      b.pos = a.pos + alpha * (b.pos - a.pos);
+      b.angle = a.angle + alpha * (b.angle - a.angle);
+    }
+    return b;
+  }
+
+  const float timeStep;
+
+private:
+  struct Item
+  {
+    Command command;
+    int steps;
+  };
+
+  enum
+  {
+    Index = 3,
+    Fresh = 4
+  };
+
+  void
+  run()
+  {
+    std::vector<Item> batch;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return quit || !queue.empty(); });
+        if (quit) return;
+        batch.swap(queue);
+      }
+      for (Item &item : batch) {
+        if (item.command) item.command(*world_);
+        for (int i = 0; i < item.steps; ++i) {
+          world_->Step(timeStep, velocityIterations, positionIterations);
+          steps++;
+          publish();
+          backlog.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+      batch.clear();
+    }
+  }
+
+  void
+  publish()
+  {
+    Snapshot &s = buffers[back];
+    s.step = steps;
+    s.previous.swap(last);
+    s.bodies.resize(tracked.size());
+    for (size_t i = 0; i < tracked.size(); ++i) {
+      s.bodies[i] = state(tracked[i]);
+    }
+    last = s.bodies;
+
+    s.contacts.clear();
+    s.touching.clear();
+    for (b2Contact *c = world_->GetContactList(); c; c = c->GetNext()) {
+      if (!c->IsTouching()) continue;
+      b2WorldManifold manifold;
+      c->GetWorldManifold(&manifold);
+      for (int i = 0; i < c->GetManifold()->pointCount; ++i) {
+        s.contacts.push_back(manifold.points[i]);
+      }
+      auto a = indices.find(c->GetFixtureA()->GetBody());
+      auto b = indices.find(c->GetFixtureB()->GetBody());
+      if (a != indices.end() && b != indices.end()) {
+        s.touching.emplace_back(a->second, b->second);
+      }
+    }
+
+    back = middle.exchange(back | Fresh, std::memory_order_acq_rel) & Index;
+  }
+
+  static BodyState
+  state(const b2Body *body)
+  {
+    BodyState b;
+    b.pos = body->GetPosition();
+    b.angle = body->GetAngle();
+    const b2Shape *shape = body->GetFixtureList()->GetShape();
+    if (shape->GetType() == b2Shape::e_circle) {
+      b.radius = shape->m_radius;
+    } else if (shape->GetType() == b2Shape::e_polygon) {
+      const b2Vec2 &corner = static_cast<const b2PolygonShape *>(shape)->m_vertices[2];
+      b.half.Set(std::abs(corner.x), std::abs(corner.y));
+    }
+    return b;
+  }
+
+private:
+  std::unique_ptr<b2World> world_;
+  const int velocityIterations;
+  const int positionIterations;
+
+  // Physics thread:
+  std::vector<b2Body *> tracked;
+  std::unordered_map<const b2Body *, int> indices;
+  std::vector<BodyState> last;
+  uint64_t steps = 0;
+  int back = 0;
+
+  // Render thread:
+  int front = 1;
+
+  // Shared:
+  Snapshot buffers[3];
+  std::atomic<int> middle{2};
+  std::atomic<int> backlog{0};
+  std::vector<Item> queue;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool quit = false;
+  std::thread thread;
+};
+
+#endif
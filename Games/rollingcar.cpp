@@ -5,21 +5,20 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <random>
 #include <vector>
 #include <vvr/animation.h>
-#include <vvr/counter.h>
 #include <vvr/drawing.h>
 #include <vvr/macros.h>
 #include <vvr/mesh.h>
 #include <vvr/palette.h>
 #include <vvr/picking.h>
+#include <vvr/profiler.h>
 #include <vvr/scene.h>
 #include <vvr/settings.h>
 #include <vvr/utils.h>
 
-#define BENCHMARKS_ON 0
-
-typedef std::vector<vvr::Point3D *> PointVector;
+#include "track.h"
 
 constexpr auto hugei = std::numeric_limits<int>::max();
 constexpr auto hugef = std::numeric_limits<float>::max();
@@ -61,15 +60,9 @@ struct Wheel : vvr::Drawable
 {
   vvr_decl_shared_ptr(Wheel);
 
-  Wheel(float radius, C2DPoint const &pos, float angle);
-
-  Wheel(float radius, double wheel_speed, PointVector const &road_pts,
-    int road_seg);
+  Wheel(float radius, double wheel_speed, Track const &track, float s);
 
-  void update(float dt, PointVector const &road_pts);
-  void move(C2DVector dir);
-  void turn(float rad, C2DPoint const &pivot);
-  void place(C2DPoint const &ground, C2DVector normal);
+  void update(float dt, Track const &track);
   void setSpeed(double speed) { this->speed = speed; }
   void setRadius(double radius);
   void draw() const override;
@@ -77,129 +70,42 @@ struct Wheel : vvr::Drawable
   auto getHub() const { return tire.GetCentre(); }
   auto getRadius() const { return tire.GetRadius(); }
   auto getCircumference() const { return circumference; }
+  auto getDistance() const { return cursor.s; }
 
 private:
-  int road_seg;
+  void place(Track::Frame const &frame);
+
+  Track::Cursor cursor;
   float speed;
   float angle;
   float circumference;
   vvr::Circle2D tire;
 };
 
-Wheel::Wheel(float radius, C2DPoint const &pos, float angle) : angle(angle)
-{
-  speed = 0;
-  circumference = 2 * M_PI * radius;
-  tire = vvr::Circle2D({pos, radius}, vvr::black);
-}
-
-Wheel::Wheel(
-  float radius, double wheel_speed, PointVector const &road_pts, int road_seg)
-  : road_seg(road_seg)
+Wheel::Wheel(float radius, double wheel_speed, Track const &track, float s)
 {
   angle = 0;
   speed = wheel_speed;
   circumference = 2 * M_PI * radius;
-  C2DPoint ground{road_pts[road_seg]->x, road_pts[road_seg]->y};
-  C2DPoint center = ground + C2DVector(0, radius);
-  vvr::Colour colour = randomColour();
-  // vvr::Colour colour = vvr::red;
-  tire = vvr::Circle2D({center, radius}, colour);
-
-  const C2DPoint p1{road_pts[road_seg + 0]->x, road_pts[road_seg + 0]->y};
-  const C2DPoint p2{road_pts[road_seg + 1]->x, road_pts[road_seg + 1]->y};
-  const C2DLine seg(p1, p2);
-  C2DVector normal = seg.vector;
-  normal.TurnLeft(M_PI_2);
-  place(seg.point, normal);
-}
-
-void
-Wheel::update(float dt, PointVector const &road_pts)
-{
-  auto &p1 = road_pts[road_seg + 0];
-  auto &p2 = road_pts[road_seg + 1];
-
-  if (road_seg == road_pts.size() - 2) {
-    math::float3 dv = ((*p2) - (*p1)).ScaledToLength(dt * speed);
-    move(C2DVector{dv.x, dv.y});
-
-    const C2DLine seg1(C2DPoint{p1->x, p1->y}, C2DPoint{p2->x, p2->y});
-    const double proj1 = this->getHub().Project(seg1) / seg1.GetLength();
-
-    if (proj1 > 1) {
-      road_seg = 0;
-      const C2DPoint p1{road_pts[road_seg + 0]->x, road_pts[road_seg + 0]->y};
-      const C2DPoint p2{road_pts[road_seg + 1]->x, road_pts[road_seg + 1]->y};
-      const C2DLine seg(p1, p2);
-      C2DVector normal = seg.vector;
-      normal.TurnLeft(M_PI_2);
-      place(seg.point, normal);
-    }
-  } else {
-    auto &p3 = road_pts[road_seg + 2];
-
-    const C2DLine seg1(C2DPoint{p1->x, p1->y}, C2DPoint{p2->x, p2->y});
-    const C2DLine seg2(C2DPoint{p2->x, p2->y}, C2DPoint{p3->x, p3->y});
-    const float angleL = seg1.vector.AngleToLeft(seg2.vector);
-    const float angleR = seg1.vector.AngleToRight(seg2.vector);
-
-    if (angleR < angleL) {
-      // Here we handle the case where the wheel is on a hill
-      // and the next segment is relatively downhill.
-
-      const double proj1 = this->getHub().Project(seg1) / seg1.GetLength();
-      const double proj2 = this->getHub().Project(seg2) / seg2.GetLength();
-
-      if (proj1 > 1 && proj2 >= 0) {
-        C2DVector normal = seg2.vector;
-        normal.TurnLeft(M_PI_2);
-        this->place(seg2.point, normal);
-        road_seg++;
-      } else if (proj1 > 1) {
-        const auto rot_speed = speed / this->getCircumference() * 2 * M_PI;
-        this->turn(dt * rot_speed, seg2.point);
-      } else {
-        math::float3 dv = ((*p2) - (*p1)).ScaledToLength(dt * speed);
-        this->move(C2DVector{dv.x, dv.y});
-      }
-
-    } else {
-      // Here we handle the case where the wheel is on a hill
-      // and the next segment is relatively uphill.
-
-      const float dist1 = seg1.Distance(this->getHub());
-      const float dist2 = seg2.Distance(this->getHub());
-
-      if (dist2 <= dist1) {
-        road_seg++;
-      } else {
-        math::float3 dv = ((*p2) - (*p1)).ScaledToLength(dt * speed);
-        this->move(C2DVector{dv.x, dv.y});
-      }
-    }
-  }
+  tire = vvr::Circle2D({C2DPoint(), radius}, randomColour());
+  cursor = track.cursorAt(s);
+  place(track.at(cursor.s));
 }
 
 void
-Wheel::move(C2DVector dir)
+Wheel::update(float dt, Track const &track)
 {
-  tire.Move(dir);
-  angle += dir.GetLength() / circumference * 2 * M_PI;
+  // Roll without slipping: the hub follows the road at constant height.
+  const float ds = dt * speed;
+  place(track.advance(cursor, ds));
+  angle += ds / tire.GetRadius();
 }
 
 void
-Wheel::turn(float rad, C2DPoint const &pivot)
+Wheel::place(Track::Frame const &frame)
 {
-  tire.RotateToRight(rad, pivot);
-  angle += rad;
-}
-
-void
-Wheel::place(C2DPoint const &ground, C2DVector normal)
-{
-  normal.SetLength(tire.GetRadius());
-  tire.SetCentre(ground + normal);
+  const math::float2 hub = frame.pos + frame.normal * tire.GetRadius();
+  tire.SetCentre(C2DPoint(hub.x, hub.y));
 }
 
 void
@@ -230,92 +136,122 @@ Wheel::draw() const
 
 /*---[Functions]-------------------------------------------------------------*/
 
+typedef std::vector<math::float2> Polyline;
+
 auto
 track_simple()
 {
-  return PointVector{
-    new vvr::Point3D(-5, 0., 0.),
-    new vvr::Point3D(0, 0., 0.),
-    new vvr::Point3D(5, 0., 0.),
-  };
+  return Track(Polyline{
+    {-5, 0},
+    { 0, 0},
+    { 5, 0},
+  });
 }
 
 auto
 track_polygon()
 {
-  return PointVector{
-    new vvr::Point3D(-2.0, 0.0, 0.0),
-    new vvr::Point3D(-1.0, 0.4, 0.0),
-    new vvr::Point3D(0.0, 0.5, 0.0),
-    new vvr::Point3D(1.0, 0.2, 0.0),
-    new vvr::Point3D(3.0, 0.1, 0.0),
-    new vvr::Point3D(2.0, -1.5, 0.0),
-    new vvr::Point3D(0.0, -2.5, 0.0),
-    new vvr::Point3D(0.5, -1.5, 0.0),
-    new vvr::Point3D(-2.0, 0.0, 0.0),
-  };
+  return Track(Polyline{
+    {-2.0,  0.0},
+    {-1.0,  0.4},
+    { 0.0,  0.5},
+    { 1.0,  0.2},
+    { 3.0,  0.1},
+    { 2.0, -1.5},
+    { 0.0, -2.5},
+    { 0.5, -1.5},
+    {-2.0,  0.0},
+  });
 }
 
 auto
 track_circle(float radius = 2.0)
 {
-  PointVector pts;
+  Polyline pts;
   constexpr int segs = 32;
   for (int i = 0; i < segs; ++i) {
     constexpr auto fullcircle = M_PI * 2;
     const auto x = radius * sin(fullcircle * i / segs);
     const auto y = radius * cos(fullcircle * i / segs);
-    pts.push_back(new vvr::Point3D(x, y, 0));
+    pts.emplace_back(x, y);
   }
-  return pts;
+  return Track(pts, true);
 }
 
 auto
 track_spiral(float radius = 0.2)
 {
-  PointVector pts;
+  Polyline pts;
   constexpr int segs = 32;
   for (int i = 0; i < segs; ++i) {
     constexpr auto fullcircle = M_PI * 2;
     const auto x = radius * sin(fullcircle * i / segs);
     const auto y = radius * cos(fullcircle * i / segs);
-    pts.push_back(new vvr::Point3D(x, y, 0));
+    pts.emplace_back(x, y);
     radius += 0.1;
   }
-  return pts;
+  return Track(pts);
 }
 
 auto
 track_zigzag()
 {
-  PointVector pts;
+  Polyline pts;
   constexpr float dx = 3.0;
   constexpr float dy = dx * 0.21;
   for (int i = 0; i < 10; ++i) {
-    pts.push_back(new vvr::Point3D((i * dx), 0, 0));
-    pts.push_back(new vvr::Point3D((i * dx) + (dx * 0.5), dy, 0));
+    pts.emplace_back(i * dx, 0);
+    pts.emplace_back((i * dx) + (dx * 0.5), dy);
   }
-  return pts;
+  return Track(pts);
 }
 
 auto
 track_sinusoid()
 {
-  PointVector pts;
+  Polyline pts;
   constexpr float dx = 0.8;
   constexpr float dy = dx * 0.91;
   for (int i = 0; i < 100; ++i) {
     float x = i * dx;
     float y = sin(x * 1.0 - 1.0) * dy + dy;
-    pts.push_back(new vvr::Point3D(x, y, 0));
+    pts.emplace_back(x, y);
   }
-  return pts;
+  return Track(pts);
+}
+
+//! Long rolling hills: a few random octaves of sines.
+auto
+track_procedural(unsigned seed = 0, int segs = 20000)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uni(0, 1);
+  constexpr int octaves = 4;
+  float amp[octaves], freq[octaves], phase[octaves];
+  for (int k = 0; k < octaves; ++k) {
+    amp[k] = (0.2f + uni(rng)) / (k + 1);
+    freq[k] = (0.1f + 0.2f * uni(rng)) * (1 << k);
+    phase[k] = uni(rng) * 2 * M_PI;
+  }
+
+  Polyline pts;
+  pts.reserve(segs + 1);
+  constexpr float dx = 0.1;
+  for (int i = 0; i <= segs; ++i) {
+    const float x = i * dx;
+    float y = 0;
+    for (int k = 0; k < octaves; ++k) {
+      y += amp[k] * sin(freq[k] * x + phase[k]);
+    }
+    pts.emplace_back(x, y);
+  }
+  return Track(std::move(pts));
 }
 
 auto
 tracks()
 {
-  typedef std::function<PointVector()> TrackFn;
+  typedef std::function<Track()> TrackFn;
   return std::vector<TrackFn>{
     // []() { return track_simple(); },
     []() { return track_polygon(); },
@@ -323,21 +259,20 @@ tracks()
     []() { return track_spiral(); },
     []() { return track_zigzag(); },
     []() { return track_sinusoid(); },
+    []() { return track_procedural(); },
   };
 }
 
 void
-createRoadFromPts(PointVector const &road_pts, vvr::Canvas &road)
+createRoadFromTrack(Track const &track, vvr::Canvas &road)
 {
-  road.setDelOnClear(false);
   road.clear();
 
-  for (int x = 0; x < road_pts.size() - 1; x++) {
-    const auto &p0 = road_pts[x + 0];
-    const auto &p1 = road_pts[x + 1];
-    auto l = new vvr::CompositeLine({p0, p1}, vvr::Aquamarine);
-    // l->collect(road);
-    road.add(l);
+  const auto &pts = track.points();
+  for (size_t x = 0; x + 1 < pts.size(); x++) {
+    const auto &p0 = pts[x + 0];
+    const auto &p1 = pts[x + 1];
+    road.add(new vvr::LineSeg2D(p0.x, p0.y, p1.x, p1.y, vvr::Aquamarine));
   }
 }
 
@@ -363,6 +298,7 @@ private:
   void mousePressed(int x, int y, int modif) override;
   void mouseMoved(int x, int y, int modif) override;
   void mouseReleased(int x, int y, int modif) override;
+  void addWheels(int count);
 
 private:
   float simulationTime;
@@ -375,7 +311,7 @@ private:
   vvr::Canvas canvas;
   vvr::Animation anim;
   std::vector<Wheel::Ptr> wheels;
-  PointVector roadPts;
+  Track track;
   vvr::TargetAnimation<math::float2> worldCenter;
   math::float2 worldCenterAnchor;
   math::float2 dragAnchor{hugef, hugef};
@@ -401,8 +337,8 @@ Playbox::Playbox()
   worldSize = {20., 0.}; // Define only the width of the world
   gbW = 100.0f;
   gbH = 0.25f;
-  roadPts = track_sinusoid();
-  createRoadFromPts(roadPts, road);
+  track = track_sinusoid();
+  createRoadFromTrack(track, road);
   reset();
 }
 
@@ -426,7 +362,7 @@ Playbox::reset()
 
   wheels.clear();
   for (int i = 0; i < numWheels; ++i) {
-    auto wheel = Wheel::Make(wheelRadius, wheelSpeed, roadPts, i);
+    auto wheel = Wheel::Make(wheelRadius, wheelSpeed, track, track.distanceAt(i));
     wheels.push_back(wheel);
   }
 
@@ -438,9 +374,7 @@ bool
 Playbox::idle()
 {
 
-#if BENCHMARKS_ON
-  ScopedCounter counter{"idle"};
-#endif
+  vvr_profile_scope("scene idle");
 
   double dt = anim.update();
 
@@ -453,7 +387,7 @@ Playbox::idle()
   }
 
   for (auto &wheel : wheels) {
-    wheel->update(dt, roadPts);
+    wheel->update(dt, track);
   }
 
   if (keepCentered) {
@@ -473,9 +407,7 @@ Playbox::idle()
 void
 Playbox::draw()
 {
-#if BENCHMARKS_ON
-  ScopedCounter counter{"drawing"};
-#endif
+  vvr_profile_scope("scene draw");
 
   {
     // Draw a clock:
@@ -525,6 +457,7 @@ Playbox::resize()
     std::cout << "Press 'r' to reset." << std::endl;
     std::cout << "Press 'c' to keep wheel centered." << std::endl;
     std::cout << "Press '0'-'9' to change track." << std::endl;
+    std::cout << "Press 'w' to add 100 wheels." << std::endl;
     std::cout << "Press 'space' to pause." << std::endl;
     std::cout << "Press '-' to zoom out." << std::endl;
     std::cout << "Press '+' to zoom in." << std::endl;
@@ -602,12 +535,15 @@ Playbox::keyEvent(unsigned char key, bool up, int modif)
       worldCenter.update(true);
     }
     break;
+  case 'w':
+    addWheels(100);
+    break;
   }
 
   if (key >= '0' && key <= '9') {
     auto track_no = (key - '0') % tracks().size();
-    roadPts = tracks()[track_no]();
-    createRoadFromPts(roadPts, road);
+    track = tracks()[track_no]();
+    createRoadFromTrack(track, road);
     reset();
   }
 }
@@ -652,6 +588,18 @@ Playbox::mouseReleased(int x, int y, int modif)
   dragAnchor = {hugef, hugef};
 }
 
+void
+Playbox::addWheels(int count)
+{
+  // Spread evenly along the part of the track behind the last wheel:
+  const float s0 = wheels.empty() ? 0 : wheels.back()->getDistance();
+  const float gap = track.length() / (count + wheels.size());
+  for (int i = 1; i <= count; ++i) {
+    wheels.push_back(Wheel::Make(wheelRadius, wheelSpeed, track, s0 - i * gap));
+  }
+  std::cout << wheels.size() << " wheels" << std::endl;
+}
+
 /*---[Invoke]---------------------------------------------------------------------------*/
 #ifndef ALL_DEMO_APP
 vvr_invoke_main_with_scene(Playbox)
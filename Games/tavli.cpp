@@ -13,7 +13,6 @@
 #include <cstring>
 #include <string>
 #include <vector>
-#include <list>
 #include <set>
 
 static float HHH = 0.10f;   // For manual runtime calibration
@@ -33,7 +32,6 @@ namespace tavli
     //! Pickers
     typedef MousePicker3D<RegionHighlighter> RegionPicker;
     typedef MousePicker3D<PieceDragger> PiecePicker;
-    typedef PropertyAnimation<vec> PropAnim;
 
     //! Draggers
     struct RegionHighlighter
@@ -102,7 +100,7 @@ namespace tavli
     struct Board : public Drawable
     {
         vvr_decl_shared_ptr(Board)
-        Board(const std::vector<Colour> &cols);
+        Board(const std::vector<Colour> &cols, Animator &animator);
         ~Board() override;
         void load3DModels();
         void createRegions();
@@ -118,7 +116,7 @@ namespace tavli
         RegionPicker::Ptr       region_picker;
         PieceDragger::Ptr       piece_dragger;
         PiecePicker::Ptr        piece_picker;
-        std::list<PropAnim>     anims;
+        Animator&               animator;
 
     private:
         std::vector<Colour>     colours;
@@ -152,7 +150,6 @@ public:
     void mouseMoved(int x, int y, int modif) override;
     void mouseReleased(int x, int y, int modif) override;
     void mouseHovered(int x, int y, int modif) override;
-    bool idle() override;
 
 private:
     vvr::Axes*                  axes;
@@ -170,7 +167,7 @@ TavliScene::TavliScene(const std::vector<vvr::Colour> &colours)
     m_perspective_proj = true;
     m_fullscreen = false;
     board = nullptr;
-    board = tavli::Board::Make(colours);
+    board = tavli::Board::Make(colours, getAnimator());
 }
 
 TavliScene::~TavliScene()
@@ -201,7 +198,7 @@ void TavliScene::resize()
 
     const float w = 0.7f * getSceneWidth();
     const float h = 0.7f * getSceneWidth();
-    board->anims.clear();
+    board->animator.finish();
     board->resize(w, h);
 }
 
@@ -233,7 +230,7 @@ void TavliScene::mousePressed(int x, int y, int modif)
     board->piece_picker->do_pick(unproject(x, y), modif);
     board->piece_dragger->setJustHlt(b);
     if (board->piece_picker->picked()) {
-        board->anims.clear();
+        board->animator.finish();
         board->piece_picker->do_drag(unproject(x, y), modif);
         cursorGrab();
     } else Scene::mousePressed(x, y, modif);
@@ -264,20 +261,9 @@ void TavliScene::mouseHovered(int x, int y, int modif)
     } else cursorShow();
 }
 
-bool TavliScene::idle()
-{
-    auto it = board->anims.begin();
-    while (it != board->anims.end()) {
-        auto& anim = *it;
-        if (!anim.animate()) {
-            it = board->anims.erase(it);
-        } else ++it;
-    }
-    return !board->anims.empty();
-}
-
 /*---[tavli::Board]---------------------------------------------------------------------*/
-tavli::Board::Board(const std::vector<vvr::Colour> &colours)
+tavli::Board::Board(const std::vector<vvr::Colour> &colours, vvr::Animator &animator)
+    : animator(animator)
 {
     this->colours = colours;
     load3DModels();
@@ -390,7 +376,7 @@ void tavli::Board::resize(const float width, float height)
 
 void tavli::Board::clearGame()
 {
-    anims.clear();
+    animator.finish();
     for (auto &reg : regions) reg->pieces.clear();
     region_picker->do_drop(math::Ray(), 0);
     piece_picker->do_drop(math::Ray(), 0);
@@ -720,11 +706,12 @@ void tavli::PieceDragger::on_drop(vvr::Drawable* drw)
         reg_old->arrangePieces();
         auto it = from.begin();
         for (auto p : reg_old->pieces) {
-            board->anims.emplace_back(*it++, p->basecenter, p->basecenter);
-            board->anims.back().setPixelSpeed(anim_speed);
+            const vec to = p->basecenter;
+            board->animator.animate(p->basecenter, *it, to, it->Distance(to) / anim_speed);
+            ++it;
         }
-        board->anims.emplace_back(*it++, piece->basecenter, piece->basecenter);
-        board->anims.back().setPixelSpeed(anim_speed);
+        const vec to = piece->basecenter;
+        board->animator.animate(piece->basecenter, *it, to, it->Distance(to) / anim_speed);
     } else reg_old->arrangePieces();
 }
 
@@ -797,6 +784,7 @@ int main(int argc, char* argv[])
         /* Load from CLI */
         assert(argc>0);
         for(size_t coli=0; coli < std::min(colours.size(),(size_t)(argc-1)); coli++) {
+            if (argv[1+coli][0] == '-') break; // --bench options
             colours[coli] = vvr::Colour(argv[1+coli]);
         }
 #endif
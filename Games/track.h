@@ -0,0 +1,164 @@
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <MathGeoLib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*---[Track]-----------------------------------------------------------------*/
+
+/**
+ * Polyline road, parameterised by arc length.
+ *
+ * Points, cumulative lengths, segment tangents and vertex normals are
+ * precomputed in contiguous arrays. at(s) finds the segment by binary
+ * search; a Cursor keeps the segment of a moving vehicle and finds the next
+ * one by walking, which is O(1) amortised for any number of vehicles.
+ * Distances wrap around: past the end, vehicles continue from the start.
+ */
+class Track
+{
+public:
+  struct Frame
+  {
+    math::float2 pos;
+    math::float2 tangent;
+    math::float2 normal; // Left of the tangent, blended across vertices
+  };
+
+  struct Cursor
+  {
+    float s = 0;
+    size_t seg = 0;
+  };
+
+  Track() = default;
+
+  explicit Track(std::vector<math::float2> polyline, bool closed = false)
+    : pts(std::move(polyline))
+  {
+    if (closed && pts.size() > 1 && !same(pts.front(), pts.back())) {
+      pts.push_back(pts.front());
+    }
+
+    // Drop zero length segments, they have no direction:
+    pts.erase(std::unique(pts.begin(), pts.end(), same), pts.end());
+
+    const size_t n = pts.size();
+    if (n < 2) {
+      pts.clear();
+      return;
+    }
+
+    dist.resize(n);
+    tangents.resize(n - 1);
+    dist[0] = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+      const math::float2 d = pts[i + 1] - pts[i];
+      const float len = d.Length();
+      dist[i + 1] = dist[i] + len;
+      tangents[i] = d / len;
+    }
+
+    // Vertex normals: the bisector of the adjacent segments' normals.
+    const bool loop = same(pts.front(), pts.back());
+    normals.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const size_t prev = i > 0 ? i - 1 : (loop ? n - 2 : 0);
+      const size_t next = i + 1 < n ? i : (loop ? 0 : n - 2);
+      const math::float2 nrm = left(tangents[prev]) + left(tangents[next]);
+      normals[i] = nrm.LengthSq() > 1e-12f ? nrm.Normalized() : left(tangents[next]);
+    }
+  }
+
+  bool empty() const { return pts.empty(); }
+  size_t size() const { return pts.size(); }
+  float length() const { return empty() ? 0 : dist.back(); }
+  const std::vector<math::float2> &points() const { return pts; }
+  float distanceAt(size_t i) const { return dist[std::min(i, dist.size() - 1)]; }
+
+  float
+  wrap(float s) const
+  {
+    const float len = length();
+    if (len <= 0) return 0;
+    s = std::fmod(s, len);
+    return s < 0 ? s + len : s;
+  }
+
+  //! O(log n)
+  size_t
+  segmentAt(float s) const
+  {
+    const auto it = std::upper_bound(dist.begin(), dist.end(), wrap(s));
+    const size_t i = it - dist.begin();
+    return std::min(i > 0 ? i - 1 : 0, tangents.size() - 1);
+  }
+
+  Frame
+  at(float s) const
+  {
+    if (empty()) return Frame();
+    s = wrap(s);
+    return frame(s, segmentAt(s));
+  }
+
+  //! Moves a cursor by ds (negative: backwards). O(1) amortised.
+  Frame
+  advance(Cursor &c, float ds) const
+  {
+    if (empty()) return Frame();
+    c.s = wrap(c.s + ds);
+    size_t seg = std::min(c.seg, tangents.size() - 1);
+    if (c.s < dist[seg] || c.s > dist[seg + 1]) {
+      // Walk when close, search when wrapped or far:
+      const size_t walk = 8;
+      size_t steps = 0;
+      while (c.s > dist[seg + 1] && seg + 1 < tangents.size() && steps++ < walk) seg++;
+      while (c.s < dist[seg] && seg > 0 && steps++ < walk) seg--;
+      if (c.s < dist[seg] || c.s > dist[seg + 1]) seg = segmentAt(c.s);
+    }
+    c.seg = seg;
+    return frame(c.s, seg);
+  }
+
+  Cursor
+  cursorAt(float s) const
+  {
+    Cursor c;
+    if (empty()) return c;
+    c.s = wrap(s);
+    c.seg = segmentAt(c.s);
+    return c;
+  }
+
+private:
+  static bool
+  same(const math::float2 &a, const math::float2 &b)
+  {
+    return (a - b).LengthSq() < 1e-12f;
+  }
+
+  static math::float2 left(const math::float2 &v) { return math::float2(-v.y, v.x); }
+
+  Frame
+  frame(float s, size_t seg) const
+  {
+    const float len = dist[seg + 1] - dist[seg];
+    const float t = len > 0 ? (s - dist[seg]) / len : 0;
+    Frame f;
+    f.pos = pts[seg] + tangents[seg] * (s - dist[seg]);
+    f.tangent = tangents[seg];
+    f.normal = (normals[seg] * (1 - t) + normals[seg + 1] * t).Normalized();
+    return f;
+  }
+
+  std::vector<math::float2> pts;
+  std::vector<float> dist; // Arc length at each point
+  std::vector<math::float2> tangents; // Per segment
+  std::vector<math::float2> normals; // Per point
+};
+
+#endif
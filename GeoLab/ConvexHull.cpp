@@ -39,6 +39,7 @@ ConvexHullScene::ConvexHullScene()
     m_bg_col = vvr::Colour(0x44, 0x44, 0x44);
     m_show_log = true;
     m_show_sliders = true;
+    m_canvas.setBaking(true);
     reset();
     m_canvas.clear();
     m_pts.clear();
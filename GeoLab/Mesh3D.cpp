@@ -69,6 +69,7 @@ Mesh3DScene::Mesh3DScene()
     const std::string objDir = vvr::get_base_path() + "resources/obj/";
     const std::string objFile = objDir + OBJ_FILENAME;
     m_model_original = vvr::Mesh::Make(objFile);
+    m_canvas.setBaking(true);
     reset();
 }
 
@@ -0,0 +1,95 @@
+#include "frame_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+QVideoFrame FramePool::acquire(const QVideoFrameFormat &format)
+{
+  if (!(format == poolFormat))
+  {
+    frames.clear();
+    poolFormat = format;
+    next = 0;
+  }
+
+  if (frames.size() < (size_t)depth)
+  {
+    frames.push_back(QVideoFrame(format));
+    return frames.back();
+  }
+
+  QVideoFrame frame = frames[next];
+  next = (next + 1) % frames.size();
+  return frame;
+}
+
+size_t copyPlanes(QVideoFrame &frame, const SrcPlane *planes, int numPlanes)
+{
+  size_t copied = 0;
+  const int count = std::min(numPlanes, frame.planeCount());
+
+  for (int p = 0; p < count; ++p)
+  {
+    const SrcPlane &src = planes[p];
+    uchar *dst = frame.bits(p);
+    const int dstStride = frame.bytesPerLine(p);
+    if (!dst || !src.data || dstStride <= 0)
+      continue;
+
+    const int lines = std::min(frame.mappedBytes(p) / dstStride, src.lines);
+
+    if (src.stride == dstStride)
+    {
+      memcpy(dst, src.data, (size_t)dstStride * lines);
+      copied += (size_t)dstStride * lines;
+      continue;
+    }
+
+    const int rowBytes = std::min(src.stride, dstStride);
+    const uchar *s = src.data;
+    for (int line = 0; line < lines; ++line)
+    {
+      memcpy(dst, s, rowBytes);
+      dst += dstStride;
+      s += src.stride;
+    }
+    copied += (size_t)rowBytes * lines;
+  }
+
+  return copied;
+}
+
+FrameStats::FrameStats()
+  : frames(0), zeroCopies(0), bytes(0), dropped(0)
+{
+  since.start();
+}
+
+void FrameStats::add(const FrameTiming &timing, size_t bytesCopied, bool zeroCopy)
+{
+  frames++;
+  zeroCopies += zeroCopy;
+  bytes += bytesCopied;
+  queue.add(timing.dequeued - timing.captured);
+  process.add(timing.shown - timing.dequeued);
+  latency.add(timing.shown - timing.captured);
+  if (since.elapsed() >= 5000)
+    report();
+}
+
+void FrameStats::report()
+{
+  const double sec = std::max<qint64>(since.elapsed(), 1) / 1000.0;
+  const double n = std::max<uint64_t>(frames, 1) * 1000.0;
+  const double copyGBs = process.total ? bytes / (double)process.total : 0;
+  printf("Frames: %.1f fps, %llu dropped, %llu zero-copy -- "
+         "Queue: avg %.0f us, max %.0f us -- Process: avg %.0f us, max %.0f us -- "
+         "Latency: avg %.0f us, max %.0f us -- Copy: %.1f MB/s, %.2f GB/s while processing\n",
+         frames / sec, (unsigned long long)dropped.exchange(0), (unsigned long long)zeroCopies,
+         queue.total / n, queue.max / 1000.0, process.total / n, process.max / 1000.0,
+         latency.total / n, latency.max / 1000.0, bytes / sec / 1e6, copyGBs);
+  fflush(stdout);
+  frames = zeroCopies = bytes = 0;
+  queue = process = latency = Stage();
+  since.restart();
+}
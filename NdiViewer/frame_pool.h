@@ -0,0 +1,77 @@
+#ifndef NDIVIEWER_FRAME_POOL_H
+#define NDIVIEWER_FRAME_POOL_H
+
+#include "pixel_convert.h"
+#include <QElapsedTimer>
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Recycles the video frames handed to the sink, instead of allocating a
+ * new one for every received frame. Frames go round robin, so a frame is
+ * written again only `depth` frames after it was shown; the sink drops
+ * its reference long before that. A new format drops the pool.
+ */
+class FramePool
+{
+public:
+  explicit FramePool(int depth = 4) : depth(depth), next(0) {}
+
+  QVideoFrame acquire(const QVideoFrameFormat &format);
+
+private:
+  int depth;
+  size_t next;
+  QVideoFrameFormat poolFormat;
+  std::vector<QVideoFrame> frames;
+};
+
+/**
+ * Copies `planes` into the mapped `frame`. Planes whose strides match are
+ * copied as one block. Returns the bytes copied.
+ */
+size_t copyPlanes(QVideoFrame &frame, const SrcPlane *planes, int numPlanes);
+
+// When a frame passed each stage, from nowNs().
+struct FrameTiming
+{
+  int64_t captured;
+  int64_t dequeued;
+  int64_t shown;        // Handed to the video sink
+};
+
+/**
+ * Per-stage latency, dropped frames and copy bandwidth, printed every
+ * few seconds. add() and report() belong to the processing thread;
+ * drop() may be called from any thread.
+ */
+struct FrameStats
+{
+  FrameStats();
+  void add(const FrameTiming &timing, size_t bytesCopied, bool zeroCopy);
+  void drop() { dropped++; }
+  void report();
+
+private:
+  struct Stage
+  {
+    int64_t total = 0;
+    int64_t max = 0;
+    void add(int64_t ns) { total += ns; max = std::max(max, ns); }
+  };
+
+  QElapsedTimer since;
+  uint64_t frames;
+  uint64_t zeroCopies;
+  uint64_t bytes;
+  std::atomic<uint64_t> dropped;
+  Stage queue;          // Captured to dequeued
+  Stage process;        // Dequeued to shown
+  Stage latency;        // Captured to shown
+};
+
+#endif
@@ -0,0 +1,327 @@
+#include "frame_source.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+int64_t nowNs()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/*---[NDI]------------------------------------------------------------------------------*/
+
+/**
+ * Owns the NDI receiver. Received frames keep it alive, so that frames
+ * still held by the video sink can be freed after capture ended.
+ */
+struct NdiSource::Receiver
+{
+  NDIlib_recv_instance_t recv;
+
+  explicit Receiver(NDIlib_recv_instance_t recv) : recv(recv) {}
+
+  ~Receiver()
+  {
+    NDIlib_recv_destroy(recv);
+    NDIlib_destroy();
+  }
+};
+
+std::unique_ptr<NdiSource> NdiSource::connect(const std::atomic<int> &running)
+{
+  printf("NDI Version: %s\n", NDIlib_version());
+  int desired_num_sources = 1;
+
+  if (!NDIlib_initialize())
+    return nullptr;
+
+  NDIlib_find_instance_t pNDI_find = NDIlib_find_create_v2();
+  if (!pNDI_find)
+  {
+    NDIlib_destroy();
+    return nullptr;
+  }
+
+  uint32_t num_sources = 0;
+  const NDIlib_source_t *p_sources = NULL;
+  while (running && num_sources < desired_num_sources)
+  {
+    // Wait until the sources on the network have changed
+    printf("Looking for %d sources ...\n", desired_num_sources);
+    NDIlib_find_wait_for_sources(pNDI_find, 1000 /* One second */);
+    p_sources = NDIlib_find_get_current_sources(pNDI_find, &num_sources);
+    for (int i = 0; i < num_sources; i++)
+    {
+      const auto name = p_sources[i].p_ndi_name;
+      const auto address = p_sources[i].p_ip_address;
+      printf("Source [%d/%d] -- Name: [%s] -- Address: [%s]\n", i + 1, num_sources, name, address);
+    }
+  }
+
+  NDIlib_recv_instance_t pNDI_recv = running ? NDIlib_recv_create_v3() : nullptr;
+  if (!pNDI_recv)
+  {
+    NDIlib_find_destroy(pNDI_find);
+    NDIlib_destroy();
+    return nullptr;
+  }
+
+  printf("Will connect to source #%d...\n", desired_num_sources);
+
+  NDIlib_recv_connect(pNDI_recv, &p_sources[desired_num_sources - 1]);
+  NDIlib_find_destroy(pNDI_find);
+
+  std::unique_ptr<NdiSource> source(new NdiSource);
+  source->receiver = std::make_shared<Receiver>(pNDI_recv);
+  return source;
+}
+
+NdiVideoFramePtr NdiSource::capture(int timeoutMs)
+{
+  NDIlib_recv_instance_t recv = receiver->recv;
+  std::unique_ptr<NDIlib_video_frame_v2_t> video_frame(new NDIlib_video_frame_v2_t);
+  NDIlib_audio_frame_v2_t audio_frame;
+  NDIlib_metadata_frame_t data_frame;
+
+  // Audio and metadata are of no use here
+  switch (NDIlib_recv_capture_v2(recv, video_frame.get(), &audio_frame, &data_frame, timeoutMs))
+  {
+  case NDIlib_frame_type_video:
+  {
+    auto keep = receiver;
+    return NdiVideoFramePtr(video_frame.release(), [keep](NDIlib_video_frame_v2_t *frame) {
+      NDIlib_recv_free_video_v2(keep->recv, frame);
+      delete frame;
+    });
+  }
+  case NDIlib_frame_type_audio:
+    NDIlib_recv_free_audio_v2(recv, &audio_frame);
+    break;
+  case NDIlib_frame_type_metadata:
+    NDIlib_recv_free_metadata(recv, &data_frame);
+    break;
+  case NDIlib_frame_type_error:
+    printf("Received error.\n");
+    break;
+  case NDIlib_frame_type_status_change:
+    printf("Received status_change.\n");
+    break;
+  default:
+    break;
+  }
+
+  return nullptr;
+}
+
+/*---[File]-----------------------------------------------------------------------------*/
+
+/**
+ * Frame buffers of the file source, reused once the sink lets go of them.
+ * Shared with the frames, which may outlive the source.
+ */
+struct FileSource::Buffers
+{
+  std::mutex mutex;
+  std::vector<std::unique_ptr<uint8_t[]>> free;
+};
+
+std::unique_ptr<FileSource> FileSource::open(const QString &path, NDIlib_FourCC_video_type_e fourCC,
+                                             int width, int height, double fps, bool loop)
+{
+  std::unique_ptr<FileSource> source(new FileSource);
+  source->frameSize = ndiFrameSize(fourCC, width, height, &source->stride);
+  if (!source->frameSize || fps <= 0)
+    return nullptr;
+
+  source->file = fopen(path.toLocal8Bit().constData(), "rb");
+  if (!source->file)
+    return nullptr;
+
+  source->fourCC = fourCC;
+  source->width = width;
+  source->height = height;
+  source->fps = fps;
+  source->loop = loop;
+  source->period = (int64_t)(1e9 / fps);
+  source->buffers = std::make_shared<Buffers>();
+  return source;
+}
+
+FileSource::~FileSource()
+{
+  if (file)
+    fclose(file);
+}
+
+bool FileSource::read(uint8_t *data)
+{
+  if (fread(data, 1, frameSize, file) == frameSize)
+    return true;
+
+  // A partial frame at the end is skipped
+  if (!loop || fseek(file, 0, SEEK_SET) != 0)
+    return false;
+  return fread(data, 1, frameSize, file) == frameSize;
+}
+
+NdiVideoFramePtr FileSource::capture(int timeoutMs)
+{
+  if (ended)
+    return nullptr;
+
+  // Keep the rate, but don't rush to catch up after a stall
+  const int64_t now = nowNs();
+  if (!deadline || now > deadline + period)
+    deadline = now;
+  if (deadline - now > timeoutMs * 1000000LL)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return nullptr;
+  }
+  std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+  deadline += period;
+
+  std::unique_ptr<uint8_t[]> data;
+  {
+    std::lock_guard<std::mutex> lock(buffers->mutex);
+    if (!buffers->free.empty())
+    {
+      data = std::move(buffers->free.back());
+      buffers->free.pop_back();
+    }
+  }
+  if (!data)
+    data.reset(new uint8_t[frameSize]);
+
+  if (!read(data.get()))
+  {
+    ended = true;
+    return nullptr;
+  }
+
+  NDIlib_video_frame_v2_t *frame = new NDIlib_video_frame_v2_t;
+  frame->xres = width;
+  frame->yres = height;
+  frame->FourCC = fourCC;
+  frame->frame_rate_N = (int)(fps * 1000);
+  frame->frame_rate_D = 1000;
+  frame->frame_format_type = NDIlib_frame_format_type_progressive;
+  frame->p_data = data.release();
+  frame->line_stride_in_bytes = stride;
+
+  auto keep = buffers;
+  return NdiVideoFramePtr(frame, [keep](NDIlib_video_frame_v2_t *frame) {
+    std::lock_guard<std::mutex> lock(keep->mutex);
+    keep->free.emplace_back(frame->p_data);
+    delete frame;
+  });
+}
+
+size_t ndiFrameSize(NDIlib_FourCC_video_type_e fourCC, int width, int height, int *stride)
+{
+  int lineBytes;
+  size_t size;
+
+  switch (fourCC)
+  {
+  case NDIlib_FourCC_video_type_UYVY:
+    lineBytes = width * 2;
+    size = (size_t)lineBytes * height;
+    break;
+  case NDIlib_FourCC_video_type_UYVA:
+    lineBytes = width * 2;
+    size = (size_t)lineBytes * height + (size_t)width * height;
+    break;
+  case NDIlib_FourCC_video_type_P216:
+    lineBytes = width * 2;
+    size = (size_t)lineBytes * height * 2;
+    break;
+  case NDIlib_FourCC_video_type_NV12:
+  case NDIlib_FourCC_video_type_YV12:
+    lineBytes = width;
+    size = (size_t)lineBytes * height * 3 / 2;
+    break;
+  case NDIlib_FourCC_video_type_BGRA:
+  case NDIlib_FourCC_video_type_BGRX:
+  case NDIlib_FourCC_video_type_RGBA:
+  case NDIlib_FourCC_video_type_RGBX:
+    lineBytes = width * 4;
+    size = (size_t)lineBytes * height;
+    break;
+  default:
+    return 0;
+  }
+
+  if (stride)
+    *stride = lineBytes;
+  return width > 0 && height > 0 ? size : 0;
+}
+
+bool ndiFourCCFromName(const QString &name, NDIlib_FourCC_video_type_e &fourCC)
+{
+  static const struct
+  {
+    const char *name;
+    NDIlib_FourCC_video_type_e fourCC;
+  } names[] = {
+    { "UYVY", NDIlib_FourCC_video_type_UYVY },
+    { "UYVA", NDIlib_FourCC_video_type_UYVA },
+    { "P216", NDIlib_FourCC_video_type_P216 },
+    { "NV12", NDIlib_FourCC_video_type_NV12 },
+    { "YV12", NDIlib_FourCC_video_type_YV12 },
+    { "BGRA", NDIlib_FourCC_video_type_BGRA },
+    { "BGRX", NDIlib_FourCC_video_type_BGRX },
+    { "RGBA", NDIlib_FourCC_video_type_RGBA },
+    { "RGBX", NDIlib_FourCC_video_type_RGBX },
+  };
+
+  for (const auto &n : names)
+  {
+    if (name.compare(QLatin1String(n.name), Qt::CaseInsensitive) == 0)
+    {
+      fourCC = n.fourCC;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*---[Queue]----------------------------------------------------------------------------*/
+
+bool FrameQueue::push(CapturedFrame frame)
+{
+  bool kept = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frames.size() >= capacity)
+    {
+      frames.pop_front();
+      kept = false;
+    }
+    frames.push_back(std::move(frame));
+  }
+  ready.notify_one();
+  return kept;
+}
+
+bool FrameQueue::pop(CapturedFrame &frame)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  ready.wait(lock, [this] { return closed || !frames.empty(); });
+  if (frames.empty())
+    return false;
+  frame = std::move(frames.front());
+  frames.pop_front();
+  return true;
+}
+
+void FrameQueue::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+  }
+  ready.notify_all();
+}
@@ -0,0 +1,124 @@
+#ifndef NDIVIEWER_FRAME_SOURCE_H
+#define NDIVIEWER_FRAME_SOURCE_H
+
+#include <Processing.NDI.Lib.h>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// A received video frame; its buffer goes back to its source with the last reference.
+typedef std::shared_ptr<const NDIlib_video_frame_v2_t> NdiVideoFramePtr;
+
+// Monotonic clock of the latency stats, in nanoseconds.
+int64_t nowNs();
+
+/**
+ * Where the viewer gets its frames from. capture() waits up to
+ * `timeoutMs` for the next frame and returns null if none came.
+ */
+class FrameSource
+{
+public:
+  virtual ~FrameSource() {}
+
+  virtual NdiVideoFramePtr capture(int timeoutMs) = 0;
+
+  // No more frames will come.
+  virtual bool atEnd() const { return false; }
+};
+
+/**
+ * Receives from the first NDI sender found on the network.
+ */
+class NdiSource : public FrameSource
+{
+public:
+  // Null if NDI failed, or `running` was cleared before a sender showed up.
+  static std::unique_ptr<NdiSource> connect(const std::atomic<int> &running);
+
+  NdiVideoFramePtr capture(int timeoutMs) override;
+
+private:
+  struct Receiver;
+  std::shared_ptr<Receiver> receiver;
+};
+
+/**
+ * Replays a file of raw frames, stored back to back in NDI's layout, at a
+ * fixed rate. Stands in for a sender when profiling, or in CI.
+ */
+class FileSource : public FrameSource
+{
+public:
+  // Null if the file can't be read.
+  static std::unique_ptr<FileSource> open(const QString &path, NDIlib_FourCC_video_type_e fourCC,
+                                          int width, int height, double fps, bool loop);
+  ~FileSource();
+
+  NdiVideoFramePtr capture(int timeoutMs) override;
+  bool atEnd() const override { return ended; }
+
+private:
+  struct Buffers;
+
+  FileSource() {}
+  bool read(uint8_t *data);
+
+  FILE *file = nullptr;
+  NDIlib_FourCC_video_type_e fourCC = NDIlib_FourCC_video_type_UYVY;
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+  size_t frameSize = 0;
+  double fps = 0;
+  bool loop = false;
+  bool ended = false;
+  int64_t period = 0;
+  int64_t deadline = 0;
+  std::shared_ptr<Buffers> buffers;
+};
+
+// Bytes per line of the first plane and bytes per frame; 0 if unknown.
+size_t ndiFrameSize(NDIlib_FourCC_video_type_e fourCC, int width, int height, int *stride = nullptr);
+
+// "UYVY", "NV12", "BGRA", ... Returns false for unknown names.
+bool ndiFourCCFromName(const QString &name, NDIlib_FourCC_video_type_e &fourCC);
+
+struct CapturedFrame
+{
+  NdiVideoFramePtr frame;
+  int64_t capturedNs = 0;
+};
+
+/**
+ * Hands frames from the capture thread to the processing thread. When
+ * full, the oldest frame is dropped: a late frame is worth less than the
+ * one after it.
+ */
+class FrameQueue
+{
+public:
+  explicit FrameQueue(size_t capacity = 3) : capacity(capacity) {}
+
+  // Returns false if the oldest frame was dropped to make room.
+  bool push(CapturedFrame frame);
+
+  // Waits for a frame. Returns false once the queue is closed and empty.
+  bool pop(CapturedFrame &frame);
+
+  void close();
+
+private:
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<CapturedFrame> frames;
+  size_t capacity;
+  bool closed = false;
+};
+
+#endif
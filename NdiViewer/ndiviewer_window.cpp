@@ -1,6 +1,7 @@
 #include "QtCore/qfuture.h"
 #include <Processing.NDI.Lib.h>
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QFuture>
 #include <QMainWindow>
 #include <QPushButton>
@@ -8,9 +9,19 @@
 #include <QVideoSink>
 #include <QVideoWidget>
 #include <QtConcurrent>
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
+#include <memory>
+#include <numeric>
 #include <ui_ndiviewer_window.h>
+#include "frame_pool.h"
+#include "frame_source.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+#include <QAbstractVideoBuffer>
+#define NDIVIEWER_ZERO_COPY 1
+#endif
 
 #ifdef _WIN32
 #ifdef _WIN64
@@ -22,86 +33,6 @@
 
 std::atomic<int> running = 1;
 
-template <typename T>
-int ndiRxLoop(T delegate)
-{
-  printf("NDI Version: %s\n", NDIlib_version());
-  int desired_num_sources = 1;
-
-  if (!NDIlib_initialize())
-    return 0;
-
-  NDIlib_find_instance_t pNDI_find = NDIlib_find_create_v2();
-  if (!pNDI_find)
-    return 0;
-
-  uint32_t num_sources = 0;
-  const NDIlib_source_t *p_sources = NULL;
-  while (running && num_sources < desired_num_sources)
-  {
-    // Wait until the sources on the network have changed
-    printf("Looking for %d sources ...\n", desired_num_sources);
-    NDIlib_find_wait_for_sources(pNDI_find, 1000 /* One second */);
-    p_sources = NDIlib_find_get_current_sources(pNDI_find, &num_sources);
-    for (int i = 0; i < num_sources; i++)
-    {
-      const auto name = p_sources[i].p_ndi_name;
-      const auto address = p_sources[i].p_ip_address;
-      printf("Source [%d/%d] -- Name: [%s] -- Address: [%s]\n", i + 1, num_sources, name, address);
-    }
-  }
-
-  printf("Will connect to source #%d...\n", desired_num_sources);
-
-  p_sources = &p_sources[desired_num_sources - 1];
-
-  NDIlib_recv_instance_t pNDI_recv = NDIlib_recv_create_v3();
-  if (!pNDI_recv)
-    return 0;
-
-  NDIlib_recv_connect(pNDI_recv, p_sources);
-  NDIlib_find_destroy(pNDI_find);
-
-  using namespace std::chrono;
-  while (running)
-  {
-    // The descriptors
-    NDIlib_video_frame_v2_t video_frame;
-    NDIlib_audio_frame_v2_t audio_frame;
-    NDIlib_metadata_frame_t data_frame;
-
-    switch (NDIlib_recv_capture_v2(pNDI_recv, &video_frame, &audio_frame, &data_frame, 2000))
-    {
-    case NDIlib_frame_type_none:
-      printf("No data received.\n");
-      break;
-    case NDIlib_frame_type_video:
-      delegate(video_frame);
-      NDIlib_recv_free_video_v2(pNDI_recv, &video_frame);
-      break;
-    case NDIlib_frame_type_audio:
-      printf("Audio data received (%d samples).\n", audio_frame.no_samples);
-      NDIlib_recv_free_audio_v2(pNDI_recv, &audio_frame);
-      break;
-    case NDIlib_frame_type_metadata:
-      printf("Received metadata: [%s]\n", data_frame.p_data);
-      break;
-    case NDIlib_frame_type_error:
-      printf("Received error.\n");
-      break;
-    case NDIlib_frame_type_status_change:
-      printf("Received status_change.\n");
-      break;
-    default:
-      break;
-    }
-  }
-
-  NDIlib_recv_destroy(pNDI_recv);
-  NDIlib_destroy();
-  return 0;
-}
-
 QVideoFrameFormat::PixelFormat ndiPixelFormatToPixelFormat(enum NDIlib_FourCC_video_type_e ndiFourCC)
 {
   switch (ndiFourCC)
@@ -109,10 +40,9 @@ QVideoFrameFormat::PixelFormat ndiPixelFormatToPixelFormat(enum NDIlib_FourCC_vi
   case NDIlib_FourCC_video_type_UYVY:
     return QVideoFrameFormat::PixelFormat::Format_UYVY;
   case NDIlib_FourCC_video_type_UYVA:
-    return QVideoFrameFormat::PixelFormat::Format_UYVY;
-    break;
+    return QVideoFrameFormat::PixelFormat::Format_RGBA8888;   // Converted, to keep the alpha
   case NDIlib_FourCC_video_type_P216:
-    return QVideoFrameFormat::PixelFormat::Format_P016;
+    return QVideoFrameFormat::PixelFormat::Format_P016;   // Converted, Qt has no 16-bit 4:2:2
   case NDIlib_FourCC_video_type_YV12:
     return QVideoFrameFormat::PixelFormat::Format_YV12;
   case NDIlib_FourCC_video_type_NV12:
@@ -129,28 +59,188 @@ QVideoFrameFormat::PixelFormat ndiPixelFormatToPixelFormat(enum NDIlib_FourCC_vi
     return QVideoFrameFormat::PixelFormat::Format_Invalid;
   }
 }
+
+PixelLayout ndiPixelLayout(enum NDIlib_FourCC_video_type_e ndiFourCC)
+{
+  switch (ndiFourCC)
+  {
+  case NDIlib_FourCC_video_type_UYVA:
+    return PixelLayout::UYVA;
+  case NDIlib_FourCC_video_type_P216:
+    return PixelLayout::P216;
+  case NDIlib_FourCC_video_type_YV12:
+    return PixelLayout::YV12;
+  case NDIlib_FourCC_video_type_NV12:
+    return PixelLayout::NV12;
+  case NDIlib_FourCC_video_type_BGRA:
+    return PixelLayout::BGRA;
+  case NDIlib_FourCC_video_type_BGRX:
+    return PixelLayout::BGRX;
+  case NDIlib_FourCC_video_type_RGBA:
+    return PixelLayout::RGBA;
+  case NDIlib_FourCC_video_type_RGBX:
+    return PixelLayout::RGBX;
+  default:
+    return PixelLayout::UYVY;
+  }
+}
+
+// The planes of an NDI frame, one after the other in p_data.
+int ndiPlanes(NDIlib_video_frame_v2_t const &frame, SrcPlane planes[3])
+{
+  const uchar *data = frame.p_data;
+  const int stride = frame.line_stride_in_bytes;
+  const int height = frame.yres;
+
+  planes[0] = { data, stride, height };
+  switch (frame.FourCC)
+  {
+  case NDIlib_FourCC_video_type_UYVA:
+    planes[1] = { data + stride * height, frame.xres, height };   // Alpha
+    return 2;
+  case NDIlib_FourCC_video_type_P216:
+    planes[1] = { data + stride * height, stride, height };       // UV, 4:2:2
+    return 2;
+  case NDIlib_FourCC_video_type_NV12:
+    planes[1] = { data + stride * height, stride, height / 2 };
+    return 2;
+  case NDIlib_FourCC_video_type_YV12:
+    planes[1] = { data + stride * height, stride / 2, height / 2 };
+    planes[2] = { planes[1].data + (stride / 2) * (height / 2), stride / 2, height / 2 };
+    return 3;
+  default:
+    return 1;
+  }
+}
+
+#ifdef NDIVIEWER_ZERO_COPY
+/**
+ * Hands an NDI frame to Qt without copying, for formats that Qt reads as
+ * they are. The NDI buffer is freed when Qt drops the last reference.
+ */
+class NdiVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+  NdiVideoBuffer(NdiVideoFramePtr frame, const QVideoFrameFormat &format)
+    : frame(std::move(frame)), frameFormat(format) {}
+
+  MapData map(QVideoFrame::MapMode) override
+  {
+    SrcPlane planes[3];
+    MapData data;
+    data.planeCount = ndiPlanes(*frame, planes);
+    for (int p = 0; p < data.planeCount; ++p)
+    {
+      data.data[p] = const_cast<uchar *>(planes[p].data);
+      data.bytesPerLine[p] = planes[p].stride;
+      data.dataSize[p] = planes[p].stride * planes[p].lines;
+    }
+    return data;
+  }
+
+  QVideoFrameFormat format() const override { return frameFormat; }
+
+private:
+  NdiVideoFramePtr frame;
+  QVideoFrameFormat frameFormat;
+};
+
+// Qt reads these layouts as NDI sends them. UYVA's alpha plane is ignored.
+bool ndiZeroCopy(enum NDIlib_FourCC_video_type_e ndiFourCC)
+{
+  return ndiFourCC != NDIlib_FourCC_video_type_P216 && ndiFourCC != NDIlib_FourCC_video_type_UYVA;
+}
+#endif
+
+// Where to take frames from; NDI unless a file is given.
+struct ViewerOptions
+{
+  QString file;
+  NDIlib_FourCC_video_type_e fourCC = NDIlib_FourCC_video_type_UYVY;
+  QSize size = QSize(1920, 1080);
+  double fps = 60;
+  bool loop = false;
+  int frames = 0;     // Quit after showing this many, if > 0
+  bool rgba = false;  // Convert every format to RGBA
+  bool nv12 = false;  // Convert UYVY and YV12 to NV12
+};
+
 class NdiViewerWindow : public QMainWindow
 {
   Q_OBJECT
 public:
-  NdiViewerWindow();
+  explicit NdiViewerWindow(const ViewerOptions &options);
   ~NdiViewerWindow();
 
 private:
-  void processVideo(NDIlib_video_frame_v2_t const *pNdiVideoFrame, QVideoSink *videoSink);
+  void captureLoop();
+  void processLoop();
+  void processVideo(CapturedFrame captured, QVideoSink *videoSink);
+  size_t convertVideo(NDIlib_video_frame_v2_t const &ndiVideoFrame, DstLayout dstLayout, QVideoFrame &videoFrame);
 
 private:
   Ui::NdiViewerWindow ui;
   QVideoWidget *videoWidget;
-  QFuture<void> future;
+  ViewerOptions options;
+  FrameQueue frameQueue;
+  QFuture<void> captureFuture;
+  QFuture<void> processFuture;
+  FramePool framePool;
+  FrameStats frameStats;
 };
 
-void NdiViewerWindow::processVideo(NDIlib_video_frame_v2_t const *pNdiVideoFrame, QVideoSink *videoSink)
+void NdiViewerWindow::captureLoop()
+{
+  std::unique_ptr<FrameSource> source;
+  if (options.file.isEmpty())
+    source = NdiSource::connect(running);
+  else if (!(source = FileSource::open(options.file, options.fourCC, options.size.width(),
+                                       options.size.height(), options.fps, options.loop)))
+    qWarning() << "Cannot read frames from" << options.file;
+
+  while (running && source && !source->atEnd())
+  {
+    CapturedFrame captured;
+    captured.frame = source->capture(2000);
+    if (!captured.frame)
+      continue;
+    captured.capturedNs = nowNs();
+    if (!frameQueue.push(std::move(captured)))
+      frameStats.drop();
+  }
+
+  frameQueue.close();
+}
+
+void NdiViewerWindow::processLoop()
+{
+  CapturedFrame captured;
+  int shown = 0;
+
+  while (frameQueue.pop(captured))
+  {
+    processVideo(std::move(captured), videoWidget->videoSink());
+    if (options.frames > 0 && ++shown == options.frames)
+      break;
+  }
+
+  frameStats.report();
+
+  // The source ran out or enough frames were shown; done unless closing already
+  if (running.exchange(0))
+    QMetaObject::invokeMethod(qApp, &QCoreApplication::quit, Qt::QueuedConnection);
+}
+
+void NdiViewerWindow::processVideo(CapturedFrame captured, QVideoSink *videoSink)
 {
-  auto ndiWidth = pNdiVideoFrame->xres;
-  auto ndiHeight = pNdiVideoFrame->yres;
-  auto ndiLineStrideInBytes = pNdiVideoFrame->line_stride_in_bytes;
-  auto ndiPixelFormat = pNdiVideoFrame->FourCC;
+  FrameTiming timing;
+  timing.captured = captured.capturedNs;
+  timing.dequeued = nowNs();
+
+  NdiVideoFramePtr ndiVideoFrame = std::move(captured.frame);
+  auto ndiWidth = ndiVideoFrame->xres;
+  auto ndiHeight = ndiVideoFrame->yres;
+  auto ndiPixelFormat = ndiVideoFrame->FourCC;
   auto pixelFormat = ndiPixelFormatToPixelFormat(ndiPixelFormat);
 
   if (pixelFormat == QVideoFrameFormat::PixelFormat::Format_Invalid)
@@ -159,9 +249,35 @@ void NdiViewerWindow::processVideo(NDIlib_video_frame_v2_t const *pNdiVideoFrame
     return;
   }
 
+  // UYVA to RGBA keeps the alpha; P216 has to become P016
+  bool convert = true;
+  DstLayout dstLayout = DstLayout::Rgb;
+  if (options.rgba || ndiPixelFormat == NDIlib_FourCC_video_type_UYVA)
+    pixelFormat = QVideoFrameFormat::PixelFormat::Format_RGBA8888;
+  else if (ndiPixelFormat == NDIlib_FourCC_video_type_P216)
+    dstLayout = DstLayout::P016;
+  else if (options.nv12 && (ndiPixelFormat == NDIlib_FourCC_video_type_UYVY || ndiPixelFormat == NDIlib_FourCC_video_type_YV12))
+  {
+    dstLayout = DstLayout::NV12;
+    pixelFormat = QVideoFrameFormat::PixelFormat::Format_NV12;
+  }
+  else
+    convert = false;
+
   QSize videoFrameSize(ndiWidth, ndiHeight);
   QVideoFrameFormat videoFrameFormat(videoFrameSize, pixelFormat);
-  QVideoFrame videoFrame(videoFrameFormat);
+
+#ifdef NDIVIEWER_ZERO_COPY
+  if (!convert && ndiZeroCopy(ndiPixelFormat))
+  {
+    videoSink->setVideoFrame(QVideoFrame(std::make_unique<NdiVideoBuffer>(ndiVideoFrame, videoFrameFormat)));
+    timing.shown = nowNs();
+    frameStats.add(timing, 0, true);
+    return;
+  }
+#endif
+
+  QVideoFrame videoFrame = framePool.acquire(videoFrameFormat);
 
   if (!videoFrame.map(QVideoFrame::WriteOnly))
   {
@@ -169,58 +285,114 @@ void NdiViewerWindow::processVideo(NDIlib_video_frame_v2_t const *pNdiVideoFrame
     return;
   }
 
-  auto pDstY = videoFrame.bits(0);
-  auto pSrcY = pNdiVideoFrame->p_data;
-  auto pDstUV = videoFrame.bits(1);
-  auto pSrcUV = pSrcY + (ndiLineStrideInBytes * ndiHeight);
-  for (int line = 0; line < ndiHeight; ++line)
+  size_t copied;
+  if (convert)
   {
-    memcpy(pDstY, pSrcY, ndiLineStrideInBytes);
-    pDstY += ndiLineStrideInBytes;
-    pSrcY += ndiLineStrideInBytes;
-
-    if (pDstUV)
-    {
-      // For now QVideoFrameFormat/QVideoFrame does not support P216. :(
-      // I have started the conversation to have it added, but that may take awhile. :(
-      // Until then, copying only every other UV line is a cheap way to downsample P216's 4:2:2 to P016's 4:2:0 chroma sampling.
-      // There are still a few visible artifacts on the screen, but it is passable.
-      if (line % 2)
-      {
-        memcpy(pDstUV, pSrcUV, ndiLineStrideInBytes);
-        pDstUV += ndiLineStrideInBytes;
-      }
-      pSrcUV += ndiLineStrideInBytes;
-    }
+    copied = convertVideo(*ndiVideoFrame, dstLayout, videoFrame);
+  }
+  else
+  {
+    SrcPlane planes[3];
+    const int numPlanes = ndiPlanes(*ndiVideoFrame, planes);
+    copied = copyPlanes(videoFrame, planes, numPlanes);
   }
 
   videoFrame.unmap();
+  ndiVideoFrame.reset();
   videoSink->setVideoFrame(videoFrame);
+  timing.shown = nowNs();
+  frameStats.add(timing, copied, false);
+}
+
+// Converts into the mapped RGBA, NV12 or P016 `videoFrame`, in row bands on the thread pool. Returns the bytes written.
+size_t NdiViewerWindow::convertVideo(NDIlib_video_frame_v2_t const &ndiVideoFrame, DstLayout dstLayout, QVideoFrame &videoFrame)
+{
+  ConvertJob job;
+  job.layout = ndiPixelLayout(ndiVideoFrame.FourCC);
+  ndiPlanes(ndiVideoFrame, job.planes);
+  job.width = ndiVideoFrame.xres;
+  job.height = std::min(ndiVideoFrame.yres, videoFrame.height());
+  job.dst = videoFrame.bits(0);
+  job.dstStride = videoFrame.bytesPerLine(0);
+  job.dstLayout = dstLayout;
+  job.order = RgbOrder::RGBA;
+  if (dstLayout != DstLayout::Rgb)
+  {
+    job.dstUv = videoFrame.bits(1);
+    job.dstUvStride = videoFrame.bytesPerLine(1);
+  }
+
+  // Bands of at least 64 rows, one per free thread; the capture and processing loops hold two
+  const int threads = std::max(1, QThreadPool::globalInstance()->maxThreadCount() - 2);
+  const int bands = std::max(1, std::min(threads, job.height / 64));
+  QList<int> band(bands);
+  std::iota(band.begin(), band.end(), 0);
+  QtConcurrent::blockingMap(band, [&job, bands](int b) {
+    int firstRow, lastRow;
+    bandRows(job.height, bands, b, firstRow, lastRow);
+    convertRows(job, firstRow, lastRow);
+  });
+
+  return (size_t)job.dstStride * job.height + (size_t)job.dstUvStride * ((job.height + 1) / 2);
 }
 
-NdiViewerWindow::NdiViewerWindow()
+NdiViewerWindow::NdiViewerWindow(const ViewerOptions &options)
+  : options(options)
 {
   ui.setupUi(this);
   videoWidget = new QVideoWidget();
   ui.scrollArea->setWidget(videoWidget);
 
-  future = QtConcurrent::run([this] {
-    ndiRxLoop([this](NDIlib_video_frame_v2_t const &vf) {
-      this->processVideo(&vf, this->videoWidget->videoSink());
-    });
-  });
+  // Capture never waits on processing: a slow consumer only drops frames
+  captureFuture = QtConcurrent::run([this] { captureLoop(); });
+  processFuture = QtConcurrent::run([this] { processLoop(); });
 }
 
 NdiViewerWindow::~NdiViewerWindow()
 {
   running = 0;
-  future.waitForFinished();
+  captureFuture.waitForFinished();
+  frameQueue.close();
+  processFuture.waitForFinished();
 }
 
 int main(int argc, char *argv[])
 {
   QApplication app(argc, argv);
-  NdiViewerWindow window;
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Shows the first NDI source found, or replays raw frames from a file.");
+  parser.addHelpOption();
+  QCommandLineOption fileOption("file", "Replay raw frames from <file> instead of NDI.", "file");
+  QCommandLineOption formatOption("format", "Pixel format of the file: UYVY, UYVA, P216, NV12, YV12, BGRA, BGRX, RGBA, RGBX.", "fourcc", "UYVY");
+  QCommandLineOption sizeOption("size", "Frame size of the file.", "WxH", "1920x1080");
+  QCommandLineOption fpsOption("fps", "Frame rate of the file.", "fps", "60");
+  QCommandLineOption loopOption("loop", "Replay the file until closed.");
+  QCommandLineOption framesOption("frames", "Quit after showing <n> frames.", "n", "0");
+  QCommandLineOption rgbaOption("rgba", "Convert every format to RGBA before showing it.");
+  QCommandLineOption nv12Option("nv12", "Convert UYVY and YV12 to NV12 before showing them.");
+  parser.addOptions({ fileOption, formatOption, sizeOption, fpsOption, loopOption, framesOption, rgbaOption, nv12Option });
+  parser.process(app);
+
+  ViewerOptions options;
+  options.file = parser.value(fileOption);
+  options.fps = parser.value(fpsOption).toDouble();
+  options.loop = parser.isSet(loopOption);
+  options.frames = parser.value(framesOption).toInt();
+  options.rgba = parser.isSet(rgbaOption);
+  options.nv12 = parser.isSet(nv12Option);
+
+  const QStringList size = parser.value(sizeOption).split('x');
+  if (size.size() == 2)
+    options.size = QSize(size[0].toInt(), size[1].toInt());
+
+  if (!ndiFourCCFromName(parser.value(formatOption), options.fourCC))
+  {
+    qWarning() << "Unknown pixel format" << parser.value(formatOption);
+    return 1;
+  }
+
+  NdiViewerWindow window(options);
   window.showMaximized();
   app.exec();
 }
@@ -0,0 +1,376 @@
+#include "pixel_convert.h"
+#include "pixel_convert_simd.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_CONVERT_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+using namespace pixel_convert;
+
+/*---[Scalar]---------------------------------------------------------------------------*/
+namespace {
+
+inline uint8_t clamp255(int x) { return (uint8_t)(x < 0 ? 0 : x > 255 ? 255 : x); }
+
+template <RgbOrder Order>
+inline void yuvPixel(uint8_t *dst, int y, int u, int v, int a)
+{
+  const int c = KY * (y - 16) + 128;
+  const int d = u - 128;
+  const int e = v - 128;
+  const uint8_t r = clamp255((c + KRV * e) >> 8);
+  const uint8_t g = clamp255((c + KGU * d + KGV * e) >> 8);
+  const uint8_t b = clamp255((c + KBU * d) >> 8);
+  dst[0] = Order == RgbOrder::BGRA ? b : r;
+  dst[1] = g;
+  dst[2] = Order == RgbOrder::BGRA ? r : b;
+  dst[3] = (uint8_t)a;
+}
+
+template <RgbOrder Order>
+void scalarRow(PixelLayout layout, const RowPtrs &row, uint8_t *dst, int start, int width)
+{
+  for (int x = start; x < width; x++)
+  {
+    const int k = x / 2;
+    uint8_t *out = dst + 4 * x;
+    switch (layout)
+    {
+    case PixelLayout::UYVY:
+    case PixelLayout::UYVA:
+      yuvPixel<Order>(out, row.y[2 * x + 1], row.y[4 * k], row.y[4 * k + 2], row.a ? row.a[x] : 255);
+      break;
+    case PixelLayout::NV12:
+      yuvPixel<Order>(out, row.y[x], row.u[2 * k], row.u[2 * k + 1], 255);
+      break;
+    case PixelLayout::YV12:
+      yuvPixel<Order>(out, row.y[x], row.u[k], row.v[k], 255);
+      break;
+    case PixelLayout::P216:
+      // Little endian: the high byte comes second
+      yuvPixel<Order>(out, row.y[2 * x + 1], row.u[4 * k + 1], row.u[4 * k + 3], 255);
+      break;
+    default:
+    {
+      const uint8_t *in = row.y + 4 * x;
+      const bool srcBgr = layout == PixelLayout::BGRA || layout == PixelLayout::BGRX;
+      const bool swap = srcBgr != (Order == RgbOrder::BGRA);
+      const bool opaque = layout == PixelLayout::BGRX || layout == PixelLayout::RGBX;
+      out[0] = swap ? in[2] : in[0];
+      out[1] = in[1];
+      out[2] = swap ? in[0] : in[2];
+      out[3] = opaque ? 255 : in[3];
+      break;
+    }
+    }
+  }
+}
+
+void scalarPlanarRow(PlanarOp op, const uint8_t *a, const uint8_t *b, uint8_t *dst, int start, int count)
+{
+  for (int x = start; x < count; x++)
+  {
+    // Little endian: the high byte comes second
+    switch (op)
+    {
+    case PlanarOp::Luma:
+      dst[x] = a[2 * x + 1];
+      break;
+    case PlanarOp::ChromaUyvy:
+      dst[x] = (uint8_t)((a[2 * x] + b[2 * x] + 1) >> 1);
+      break;
+    case PlanarOp::Chroma16:
+    case PlanarOp::Chroma16To8:
+    {
+      const int sa = a[2 * x] | a[2 * x + 1] << 8;
+      const int sb = b[2 * x] | b[2 * x + 1] << 8;
+      const int m = (sa + sb + 1) >> 1;
+      if (op == PlanarOp::Chroma16To8)
+      {
+        dst[x] = (uint8_t)(m >> 8);
+        break;
+      }
+      dst[2 * x] = (uint8_t)m;
+      dst[2 * x + 1] = (uint8_t)(m >> 8);
+      break;
+    }
+    }
+  }
+}
+
+}
+
+/*---[SSE2]-----------------------------------------------------------------------------*/
+#ifdef PIXEL_CONVERT_SSE2
+namespace {
+
+// 8 pixels: 16-bit lanes, or 16 bytes for the raw loads
+struct Sse2
+{
+  typedef __m128i T;
+  enum { N = 8, Bytes = 16 };
+
+  static T load(const uint8_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+  static T loadU8(const uint8_t *p) { return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128()); }
+  static T loadHalfDup(const uint8_t *p)
+  {
+    int32_t w;
+    memcpy(&w, p, 4);
+    const T h = _mm_unpacklo_epi8(_mm_cvtsi32_si128(w), _mm_setzero_si128());
+    return _mm_unpacklo_epi16(h, h);
+  }
+  static void store(uint8_t *p, T lo, T hi)
+  {
+    _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *)(p + 16), _mm_unpackhi_epi16(lo, hi));
+  }
+  static void storeRaw(uint8_t *p, T x) { _mm_storeu_si128((__m128i *)p, x); }
+  static void storeU8(uint8_t *p, T x) { _mm_storel_epi64((__m128i *)p, _mm_packus_epi16(x, x)); }
+
+  static T set16(int x) { return _mm_set1_epi16((short)x); }
+  static T set32(int x) { return _mm_set1_epi32(x); }
+  static T and_(T a, T b) { return _mm_and_si128(a, b); }
+  static T or_(T a, T b) { return _mm_or_si128(a, b); }
+  static T sub16(T a, T b) { return _mm_sub_epi16(a, b); }
+  static T add32(T a, T b) { return _mm_add_epi32(a, b); }
+  static T avg16(T a, T b) { return _mm_avg_epu16(a, b); }
+  static T min16(T a, T b) { return _mm_min_epi16(a, b); }
+  static T max16(T a, T b) { return _mm_max_epi16(a, b); }
+  static T slli16(T a, int n) { return _mm_slli_epi16(a, n); }
+  static T srli16(T a, int n) { return _mm_srli_epi16(a, n); }
+  static T slli32(T a, int n) { return _mm_slli_epi32(a, n); }
+  static T srli32(T a, int n) { return _mm_srli_epi32(a, n); }
+  static T srai32(T a, int n) { return _mm_srai_epi32(a, n); }
+  static T madd(T a, T b) { return _mm_madd_epi16(a, b); }
+  static T unpacklo16(T a, T b) { return _mm_unpacklo_epi16(a, b); }
+  static T unpackhi16(T a, T b) { return _mm_unpackhi_epi16(a, b); }
+  static T packs32(T a, T b) { return _mm_packs_epi32(a, b); }
+};
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuid(r, 0);
+  if (r[0] < 7)
+    return false;
+  __cpuid(r, 1);
+  const int osxsave = 1 << 27, avx = 1 << 28;
+  if ((r[2] & (osxsave | avx)) != (osxsave | avx) || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(r, 7, 0);
+  return (r[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+}
+#endif
+
+/*---[Dispatch]-------------------------------------------------------------------------*/
+ConvertIsa bestConvertIsa()
+{
+#ifdef PIXEL_CONVERT_SSE2
+  static const ConvertIsa best = haveAvx2Kernels() && cpuHasAvx2() ? ConvertIsa::AVX2 : ConvertIsa::SSE2;
+  return best;
+#else
+  return ConvertIsa::Scalar;
+#endif
+}
+
+const char *convertIsaName(ConvertIsa isa)
+{
+  switch (isa)
+  {
+  case ConvertIsa::Scalar:
+    return "Scalar";
+  case ConvertIsa::SSE2:
+    return "SSE2";
+  case ConvertIsa::AVX2:
+    return "AVX2";
+  default:
+    return "Best";
+  }
+}
+
+bool canConvert(PixelLayout layout, DstLayout dstLayout)
+{
+  switch (dstLayout)
+  {
+  case DstLayout::Rgb:
+    return true;
+  case DstLayout::NV12:
+    return layout == PixelLayout::UYVY || layout == PixelLayout::UYVA || layout == PixelLayout::NV12 ||
+           layout == PixelLayout::YV12 || layout == PixelLayout::P216;
+  case DstLayout::P016:
+    return layout == PixelLayout::P216;
+  }
+  return false;
+}
+
+namespace {
+
+void runPlanarRow(ConvertIsa isa, PlanarOp op, const uint8_t *a, const uint8_t *b, uint8_t *dst, int count)
+{
+  int x = 0;
+  if (isa == ConvertIsa::AVX2)
+    x = planarRowAvx2(op, a, b, dst, x, count);
+#ifdef PIXEL_CONVERT_SSE2
+  if (isa >= ConvertIsa::SSE2)
+    x = planarRow<Sse2>(op, a, b, dst, x, count);
+#endif
+  scalarPlanarRow(op, a, b, dst, x, count);
+}
+
+/**
+ * Line `line` of a planar target. Even lines also write the chroma line
+ * below them, from this source line and the next; 4:2:2 chroma is averaged.
+ */
+void convertPlanarLine(const ConvertJob &job, ConvertIsa isa, int line)
+{
+  const SrcPlane *planes = job.planes;
+  const int next = line + 1 < job.height ? line + 1 : line;
+  const int samples = 2 * ((job.width + 1) / 2);    // Chroma, U and V
+  const uint8_t *y = planes[0].data + (size_t)planes[0].stride * line;
+  uint8_t *dstY = job.dst + (size_t)job.dstStride * line;
+  uint8_t *dstUv = line % 2 ? nullptr : job.dstUv + (size_t)job.dstUvStride * (line / 2);
+
+  switch (job.layout)
+  {
+  case PixelLayout::UYVY:
+  case PixelLayout::UYVA:
+    runPlanarRow(isa, PlanarOp::Luma, y, nullptr, dstY, job.width);
+    if (dstUv)
+      runPlanarRow(isa, PlanarOp::ChromaUyvy, y, planes[0].data + (size_t)planes[0].stride * next, dstUv, samples);
+    break;
+  case PixelLayout::P216:
+  {
+    const uint8_t *uv = planes[1].data + (size_t)planes[1].stride * line;
+    const uint8_t *uvNext = planes[1].data + (size_t)planes[1].stride * next;
+    if (job.dstLayout == DstLayout::P016)
+    {
+      memcpy(dstY, y, (size_t)job.width * 2);
+      if (dstUv)
+        runPlanarRow(isa, PlanarOp::Chroma16, uv, uvNext, dstUv, samples);
+    }
+    else
+    {
+      runPlanarRow(isa, PlanarOp::Luma, y, nullptr, dstY, job.width);
+      if (dstUv)
+        runPlanarRow(isa, PlanarOp::Chroma16To8, uv, uvNext, dstUv, samples);
+    }
+    break;
+  }
+  case PixelLayout::NV12:
+    memcpy(dstY, y, job.width);
+    if (dstUv)
+      memcpy(dstUv, planes[1].data + (size_t)planes[1].stride * (line / 2), samples);
+    break;
+  case PixelLayout::YV12:
+    memcpy(dstY, y, job.width);
+    if (dstUv)
+    {
+      const uint8_t *v = planes[1].data + (size_t)planes[1].stride * (line / 2);
+      const uint8_t *u = planes[2].data + (size_t)planes[2].stride * (line / 2);
+      for (int k = 0; k < samples / 2; k++)
+      {
+        dstUv[2 * k] = u[k];
+        dstUv[2 * k + 1] = v[k];
+      }
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+}
+
+void convertRows(const ConvertJob &job, int firstRow, int lastRow)
+{
+  // Asking for more than the CPU has falls back to what it has
+  const ConvertIsa best = bestConvertIsa();
+  const ConvertIsa isa = job.isa == ConvertIsa::Best || job.isa > best ? best : job.isa;
+  const SrcPlane *planes = job.planes;
+
+  if (job.dstLayout != DstLayout::Rgb)
+  {
+    if (!canConvert(job.layout, job.dstLayout))
+      return;
+    for (int line = firstRow; line < lastRow; line++)
+      convertPlanarLine(job, isa, line);
+    return;
+  }
+
+  for (int line = firstRow; line < lastRow; line++)
+  {
+    RowPtrs row = { planes[0].data + (size_t)planes[0].stride * line, nullptr, nullptr, nullptr };
+    switch (job.layout)
+    {
+    case PixelLayout::UYVA:
+      row.a = planes[1].data + (size_t)planes[1].stride * line;
+      break;
+    case PixelLayout::NV12:
+      row.u = planes[1].data + (size_t)planes[1].stride * (line / 2);
+      break;
+    case PixelLayout::YV12:
+      row.v = planes[1].data + (size_t)planes[1].stride * (line / 2);
+      row.u = planes[2].data + (size_t)planes[2].stride * (line / 2);
+      break;
+    case PixelLayout::P216:
+      row.u = planes[1].data + (size_t)planes[1].stride * line;
+      break;
+    default:
+      break;
+    }
+
+    uint8_t *dst = job.dst + (size_t)job.dstStride * line;
+    int x = 0;
+    if (isa == ConvertIsa::AVX2)
+      x = convertRowAvx2(job.layout, job.order, row, dst, x, job.width);
+#ifdef PIXEL_CONVERT_SSE2
+    if (isa >= ConvertIsa::SSE2)
+      x = convertRow<Sse2>(job.layout, job.order, row, dst, x, job.width);
+#endif
+    if (job.order == RgbOrder::BGRA)
+      scalarRow<RgbOrder::BGRA>(job.layout, row, dst, x, job.width);
+    else
+      scalarRow<RgbOrder::RGBA>(job.layout, row, dst, x, job.width);
+  }
+}
+
+void bandRows(int height, int bands, int band, int &firstRow, int &lastRow)
+{
+  firstRow = (int)((int64_t)height * band / bands);
+  lastRow = (int)((int64_t)height * (band + 1) / bands);
+}
+
+void convert(const ConvertJob &job, int bands)
+{
+  bands = bands < 1 ? 1 : bands > job.height ? job.height : bands;
+  std::vector<std::thread> threads;
+  for (int band = 1; band < bands; band++)
+  {
+    threads.emplace_back([&job, bands, band] {
+      int first, last;
+      bandRows(job.height, bands, band, first, last);
+      convertRows(job, first, last);
+    });
+  }
+
+  int first, last;
+  bandRows(job.height, bands, 0, first, last);
+  convertRows(job, first, last);
+  for (auto &t : threads)
+    t.join();
+}
@@ -0,0 +1,78 @@
+#ifndef NDIVIEWER_PIXEL_CONVERT_H
+#define NDIVIEWER_PIXEL_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * One plane of a received frame, as laid out by the sender.
+ */
+struct SrcPlane
+{
+  const uint8_t *data = nullptr;
+  int stride = 0;     // Bytes per line
+  int lines = 0;
+};
+
+/**
+ * The layouts NDI sends, and the planes each takes:
+ *   UYVY  4:2:2, one plane
+ *   UYVA  UYVY, then an 8-bit alpha plane
+ *   NV12  4:2:0, Y then interleaved UV
+ *   YV12  4:2:0, Y then V then U
+ *   P216  4:2:2, 16-bit Y then interleaved 16-bit UV
+ *   BGRA, BGRX, RGBA, RGBX  8-bit, one plane
+ */
+enum class PixelLayout { UYVY, UYVA, NV12, YV12, P216, BGRA, BGRX, RGBA, RGBX };
+
+enum class RgbOrder { BGRA, RGBA };
+
+/**
+ * What a job writes:
+ *   Rgb   8-bit, one plane, in the job's RgbOrder
+ *   NV12  4:2:0, Y then interleaved UV; from the YUV layouts, dropping alpha
+ *   P016  NV12 with 16-bit samples; from P216 only
+ * The 4:2:0 targets average the chroma of each pair of 4:2:2 lines.
+ */
+enum class DstLayout { Rgb, NV12, P016 };
+
+enum class ConvertIsa { Scalar, SSE2, AVX2, Best };
+
+/**
+ * A frame to convert. To RGB, YUV is taken as BT.709 with limited range, as
+ * NDI sends HD; P216 is cut to 8 bits, as it is to NV12. Formats without
+ * alpha come out opaque.
+ */
+struct ConvertJob
+{
+  PixelLayout layout = PixelLayout::UYVY;
+  SrcPlane planes[3];
+  int width = 0;
+  int height = 0;
+  uint8_t *dst = nullptr;       // Y for the planar targets
+  int dstStride = 0;
+  uint8_t *dstUv = nullptr;     // UV for the planar targets, half the lines of Y
+  int dstUvStride = 0;
+  DstLayout dstLayout = DstLayout::Rgb;
+  RgbOrder order = RgbOrder::BGRA;
+  ConvertIsa isa = ConvertIsa::Best;
+};
+
+// Whether `layout` converts to `dstLayout`.
+bool canConvert(PixelLayout layout, DstLayout dstLayout);
+
+// Converts rows [firstRow, lastRow). Rows are independent, so bands of them can go to different threads.
+void convertRows(const ConvertJob &job, int firstRow, int lastRow);
+
+// Converts the whole frame in `bands` row bands, each but the first on its own thread.
+void convert(const ConvertJob &job, int bands = 1);
+
+// The rows of band `band` out of `bands`.
+void bandRows(int height, int bands, int band, int &firstRow, int &lastRow);
+
+// The fastest instruction set this CPU runs, and what Best stands for.
+ConvertIsa bestConvertIsa();
+
+const char *convertIsaName(ConvertIsa isa);
+
+#endif
@@ -0,0 +1,95 @@
+// Built with AVX2 code generation (see CMakeLists.txt); only called after
+// the CPU was checked for it.
+
+#include "pixel_convert_simd.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace {
+
+// 16 pixels: 16-bit lanes, or 32 bytes for the raw loads. The in-lane
+// unpacks and packs of yuvToRgb cancel out, except in store().
+struct Avx2
+{
+  typedef __m256i T;
+  enum { N = 16, Bytes = 32 };
+
+  static T load(const uint8_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+  static T loadU8(const uint8_t *p) { return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p)); }
+  static T loadHalfDup(const uint8_t *p)
+  {
+    const __m128i h = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)p));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(h, h)), _mm_unpackhi_epi16(h, h), 1);
+  }
+  static void store(uint8_t *p, T lo, T hi)
+  {
+    // Pixels 0-3 and 8-11, then 4-7 and 12-15
+    const T a = _mm256_unpacklo_epi16(lo, hi);
+    const T b = _mm256_unpackhi_epi16(lo, hi);
+    _mm256_storeu_si256((__m256i *)p, _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *)(p + 32), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  static void storeRaw(uint8_t *p, T x) { _mm256_storeu_si256((__m256i *)p, x); }
+  static void storeU8(uint8_t *p, T x)
+  {
+    // The packs are in-lane: bytes 0-7 and 16-23 hold the 16 samples
+    const T b = _mm256_permute4x64_epi64(_mm256_packus_epi16(x, x), 0x08);
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(b));
+  }
+
+  static T set16(int x) { return _mm256_set1_epi16((short)x); }
+  static T set32(int x) { return _mm256_set1_epi32(x); }
+  static T and_(T a, T b) { return _mm256_and_si256(a, b); }
+  static T or_(T a, T b) { return _mm256_or_si256(a, b); }
+  static T sub16(T a, T b) { return _mm256_sub_epi16(a, b); }
+  static T add32(T a, T b) { return _mm256_add_epi32(a, b); }
+  static T avg16(T a, T b) { return _mm256_avg_epu16(a, b); }
+  static T min16(T a, T b) { return _mm256_min_epi16(a, b); }
+  static T max16(T a, T b) { return _mm256_max_epi16(a, b); }
+  static T slli16(T a, int n) { return _mm256_slli_epi16(a, n); }
+  static T srli16(T a, int n) { return _mm256_srli_epi16(a, n); }
+  static T slli32(T a, int n) { return _mm256_slli_epi32(a, n); }
+  static T srli32(T a, int n) { return _mm256_srli_epi32(a, n); }
+  static T srai32(T a, int n) { return _mm256_srai_epi32(a, n); }
+  static T madd(T a, T b) { return _mm256_madd_epi16(a, b); }
+  static T unpacklo16(T a, T b) { return _mm256_unpacklo_epi16(a, b); }
+  static T unpackhi16(T a, T b) { return _mm256_unpackhi_epi16(a, b); }
+  static T packs32(T a, T b) { return _mm256_packs_epi32(a, b); }
+};
+
+}
+
+int pixel_convert::convertRowAvx2(PixelLayout layout, RgbOrder order, const RowPtrs &row, uint8_t *dst, int start, int width)
+{
+  return convertRow<Avx2>(layout, order, row, dst, start, width);
+}
+
+int pixel_convert::planarRowAvx2(PlanarOp op, const uint8_t *a, const uint8_t *b, uint8_t *dst, int start, int count)
+{
+  return planarRow<Avx2>(op, a, b, dst, start, count);
+}
+
+bool pixel_convert::haveAvx2Kernels()
+{
+  return true;
+}
+
+#else
+
+int pixel_convert::convertRowAvx2(PixelLayout, RgbOrder, const RowPtrs &, uint8_t *, int start, int)
+{
+  return start;
+}
+
+int pixel_convert::planarRowAvx2(PlanarOp, const uint8_t *, const uint8_t *, uint8_t *, int start, int)
+{
+  return start;
+}
+
+bool pixel_convert::haveAvx2Kernels()
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef NDIVIEWER_PIXEL_CONVERT_SIMD_H
+#define NDIVIEWER_PIXEL_CONVERT_SIMD_H
+
+// Row kernels shared by the SSE2 and AVX2 builds. V wraps the
+// intrinsics of one of them; see Sse2 and Avx2.
+
+#include "pixel_convert.h"
+#include <cstring>
+
+namespace pixel_convert {
+
+// Source rows of one output row. For interleaved chroma, u points to it and v is unused.
+struct RowPtrs
+{
+  const uint8_t *y;
+  const uint8_t *u;
+  const uint8_t *v;
+  const uint8_t *a;     // Null if opaque
+};
+
+// The row kernels of the planar targets, on `count` 16-bit samples of source rows a and b.
+enum class PlanarOp
+{
+  Luma,         // High bytes of a: UYVY's Y, or P216's Y cut to 8 bits
+  ChromaUyvy,   // Average of the low bytes of a and b: UYVY's U and V
+  Chroma16,     // Average of a and b: P216's UV
+  Chroma16To8,  // Average of a and b, cut to 8 bits
+};
+
+// In a translation unit built for AVX2; converts nothing if the compiler has no AVX2.
+int convertRowAvx2(PixelLayout layout, RgbOrder order, const RowPtrs &row, uint8_t *dst, int start, int width);
+int planarRowAvx2(PlanarOp op, const uint8_t *a, const uint8_t *b, uint8_t *dst, int start, int count);
+bool haveAvx2Kernels();
+
+// Internal linkage: the AVX2 build of these must not stand in for the SSE2 one.
+namespace {
+
+// BT.709, limited range, 8 bits of fraction: R = 298(Y-16) + 459(V-128), etc.
+enum
+{
+  KY = 298,
+  KRV = 459,
+  KGU = -55,
+  KGV = -136,
+  KBU = 541,
+};
+
+inline int pack16(int lo, int hi) { return (int)(((uint32_t)hi << 16) | ((uint32_t)lo & 0xFFFF)); }
+
+/**
+ * Converts V::N pixels, given as 16-bit lanes in pixel order, and stores
+ * them as 4-byte pixels. The sums are done in 32 bits with madd, so every
+ * build gives the scalar code's results exactly.
+ */
+template <class V, RgbOrder Order>
+inline void yuvToRgb(uint8_t *dst, typename V::T y, typename V::T u, typename V::T v, typename V::T a)
+{
+  typedef typename V::T T;
+  const T c = V::sub16(y, V::set16(16));
+  const T d = V::sub16(u, V::set16(128));
+  const T e = V::sub16(v, V::set16(128));
+
+  // 298c + 128, from pairs (c, 1)
+  const T one = V::set16(1);
+  const T kY = V::set32(pack16(KY, 128));
+  const T yLo = V::madd(V::unpacklo16(c, one), kY);
+  const T yHi = V::madd(V::unpackhi16(c, one), kY);
+
+  const T deLo = V::unpacklo16(d, e);
+  const T deHi = V::unpackhi16(d, e);
+  auto channel = [&](int ku, int kv) {
+    const T k = V::set32(pack16(ku, kv));
+    const T lo = V::srai32(V::add32(yLo, V::madd(deLo, k)), 8);
+    const T hi = V::srai32(V::add32(yHi, V::madd(deHi, k)), 8);
+    return V::min16(V::max16(V::packs32(lo, hi), V::set16(0)), V::set16(255));
+  };
+  const T r = channel(0, KRV);
+  const T g = channel(KGU, KGV);
+  const T b = channel(KBU, 0);
+
+  const T first = Order == RgbOrder::BGRA ? b : r;
+  const T third = Order == RgbOrder::BGRA ? r : b;
+  V::store(dst, V::or_(first, V::slli16(g, 8)), V::or_(third, V::slli16(a, 8)));
+}
+
+// Interleaved U, V lanes to U and V each in both lanes of its pixel pair.
+template <class V>
+inline void splitUv(typename V::T uv, typename V::T &u, typename V::T &v)
+{
+  u = V::and_(uv, V::set32(0xFFFF));
+  u = V::or_(u, V::slli32(u, 16));
+  v = V::srli32(uv, 16);
+  v = V::or_(v, V::slli32(v, 16));
+}
+
+struct LoadUyvy
+{
+  template <class V>
+  static void load(const RowPtrs &row, int x, typename V::T &y, typename V::T &u, typename V::T &v, typename V::T &a)
+  {
+    const typename V::T w = V::load(row.y + 2 * x);
+    y = V::srli16(w, 8);
+    splitUv<V>(V::and_(w, V::set16(0xFF)), u, v);
+    a = row.a ? V::loadU8(row.a + x) : V::set16(255);
+  }
+};
+
+struct LoadNv12
+{
+  template <class V>
+  static void load(const RowPtrs &row, int x, typename V::T &y, typename V::T &u, typename V::T &v, typename V::T &a)
+  {
+    y = V::loadU8(row.y + x);
+    splitUv<V>(V::loadU8(row.u + x), u, v);
+    a = V::set16(255);
+  }
+};
+
+struct LoadYv12
+{
+  template <class V>
+  static void load(const RowPtrs &row, int x, typename V::T &y, typename V::T &u, typename V::T &v, typename V::T &a)
+  {
+    y = V::loadU8(row.y + x);
+    u = V::loadHalfDup(row.u + x / 2);
+    v = V::loadHalfDup(row.v + x / 2);
+    a = V::set16(255);
+  }
+};
+
+struct LoadP216
+{
+  template <class V>
+  static void load(const RowPtrs &row, int x, typename V::T &y, typename V::T &u, typename V::T &v, typename V::T &a)
+  {
+    y = V::srli16(V::load(row.y + 2 * x), 8);
+    splitUv<V>(V::srli16(V::load(row.u + 2 * x), 8), u, v);
+    a = V::set16(255);
+  }
+};
+
+// Converts from pixel `start`, which is even, in steps of V::N. Returns where it stopped; the caller does the rest.
+template <class V, RgbOrder Order, class Load>
+int yuvRow(const RowPtrs &row, uint8_t *dst, int start, int width)
+{
+  int x = start;
+  for (; x + V::N <= width; x += V::N)
+  {
+    typename V::T y, u, v, a;
+    Load::template load<V>(row, x, y, u, v, a);
+    yuvToRgb<V, Order>(dst + 4 * x, y, u, v, a);
+  }
+  return x;
+}
+
+// 4-byte pixels: swaps bytes 0 and 2 if `swap`, sets byte 3 if `opaque`.
+template <class V>
+int swizzleRow(const uint8_t *src, uint8_t *dst, int start, int width, bool swap, bool opaque)
+{
+  const int step = V::Bytes / 4;
+  const typename V::T keep = V::set32((int)0xFF00FF00);
+  const typename V::T low = V::set32(0xFF);
+  const typename V::T alpha = V::set32(opaque ? (int)0xFF000000 : 0);
+  int x = start;
+  for (; x + step <= width; x += step)
+  {
+    typename V::T p = V::load(src + 4 * x);
+    if (swap)
+      p = V::or_(V::and_(p, keep), V::or_(V::slli32(V::and_(p, low), 16), V::and_(V::srli32(p, 16), low)));
+    V::storeRaw(dst + 4 * x, V::or_(p, alpha));
+  }
+  return x;
+}
+
+template <class V, RgbOrder Order>
+int convertRowOrdered(PixelLayout layout, const RowPtrs &row, uint8_t *dst, int start, int width)
+{
+  switch (layout)
+  {
+  case PixelLayout::UYVY:
+  case PixelLayout::UYVA:
+    return yuvRow<V, Order, LoadUyvy>(row, dst, start, width);
+  case PixelLayout::NV12:
+    return yuvRow<V, Order, LoadNv12>(row, dst, start, width);
+  case PixelLayout::YV12:
+    return yuvRow<V, Order, LoadYv12>(row, dst, start, width);
+  case PixelLayout::P216:
+    return yuvRow<V, Order, LoadP216>(row, dst, start, width);
+  case PixelLayout::BGRA:
+  case PixelLayout::BGRX:
+    return swizzleRow<V>(row.y, dst, start, width, Order != RgbOrder::BGRA, layout == PixelLayout::BGRX);
+  case PixelLayout::RGBA:
+  case PixelLayout::RGBX:
+    return swizzleRow<V>(row.y, dst, start, width, Order != RgbOrder::RGBA, layout == PixelLayout::RGBX);
+  }
+  return start;
+}
+
+template <class V>
+int convertRow(PixelLayout layout, RgbOrder order, const RowPtrs &row, uint8_t *dst, int start, int width)
+{
+  return order == RgbOrder::BGRA ? convertRowOrdered<V, RgbOrder::BGRA>(layout, row, dst, start, width)
+                                 : convertRowOrdered<V, RgbOrder::RGBA>(layout, row, dst, start, width);
+}
+
+// Converts from sample `start` in steps of V::N. Returns where it stopped; the caller does the rest.
+template <class V>
+int planarRow(PlanarOp op, const uint8_t *a, const uint8_t *b, uint8_t *dst, int start, int count)
+{
+  const typename V::T low = V::set16(0xFF);
+  int x = start;
+  for (; x + V::N <= count; x += V::N)
+  {
+    switch (op)
+    {
+    case PlanarOp::Luma:
+      V::storeU8(dst + x, V::srli16(V::load(a + 2 * x), 8));
+      break;
+    case PlanarOp::ChromaUyvy:
+      V::storeU8(dst + x, V::avg16(V::and_(V::load(a + 2 * x), low), V::and_(V::load(b + 2 * x), low)));
+      break;
+    case PlanarOp::Chroma16:
+      V::storeRaw(dst + 2 * x, V::avg16(V::load(a + 2 * x), V::load(b + 2 * x)));
+      break;
+    case PlanarOp::Chroma16To8:
+      V::storeU8(dst + x, V::srli16(V::avg16(V::load(a + 2 * x), V::load(b + 2 * x)), 8));
+      break;
+    }
+  }
+  return x;
+}
+
+}
+}
+
+#endif
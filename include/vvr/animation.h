@@ -2,8 +2,15 @@
 #define VVR_ANIMATION_H
 
 #include "macros.h"
+#include "sim_clock.h"
 #include "utils.h"
 #include "vvrframework_DLL.h"
+#include <algorithm>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -38,7 +45,7 @@ overshoot(T const &a, T const &b)
 }
 
 template <>
-float
+inline float
 overshoot(float const &a, float const &b)
 {
   return (b - a) < 0;
@@ -48,6 +55,10 @@ overshoot(float const &a, float const &b)
 
 namespace vvr
 {
+    /**
+     * Runs on the simulation clock of the scene (see SimClock), so it
+     * follows pause, time scale and replays.
+     */
     struct Animation
     {
         Animation()
@@ -94,8 +105,8 @@ namespace vvr
             float sec;
             if (m_paused) {
                 if (!start) return 0;
-                m_last_update = sec = get_seconds();
-            } else sec = get_seconds();
+                m_last_update = sec = sim_seconds();
+            } else sec = sim_seconds();
             const float delta_time = (sec - m_last_update) * m_speed;
             m_time += delta_time;
             m_last_update = sec;
@@ -106,7 +117,7 @@ namespace vvr
         void setTime(float time)
         {
             m_time = time;
-            m_last_update = get_seconds();
+            m_last_update = sim_seconds();
         }
 
         void reset()
@@ -122,6 +133,200 @@ namespace vvr
         float m_speed;
     };
 
+    enum Easing { LINEAR, EASE_IN, EASE_OUT, EASE_IN_OUT };
+
+    /**
+     * Animates properties of any number of objects from one place.
+     *
+     * Tracks of the same property type live in parallel arrays. update()
+     * reads the clock once and runs each step over all of them in turn:
+     * progress, easing, then the writes. Every easing curve is
+     * u + u(1-u)(a + b u), so one branchless loop eases all tracks.
+     * Finished tracks write their end value and are swapped out.
+     *
+     * Scenes own one and update it before idle(); see Scene::getAnimator().
+     * A track writes through a pointer, so the property must outlive it, or
+     * be released with stop(), finish() or clear().
+     */
+    class Animator
+    {
+    public:
+        /**
+         * Animates `prop` from `from` to `to` in `dur` seconds, starting
+         * after `delay`. Replaces any track already animating `prop`.
+         */
+        template <typename P>
+        void animate(P &prop, const P &from, const P &to, float dur,
+                     Easing easing = LINEAR, float delay = 0)
+        {
+            m_count -= tracks<P>().remove(&prop, false);
+            if (dur <= 0 && delay <= 0) {
+                prop = to;
+                return;
+            }
+            const double start = sim_seconds() + delay;
+            m_count += tracks<P>().add(&prop, from, to, start, dur, easing);
+            prop = from;
+        }
+
+        //! From the current value.
+        template <typename P>
+        void animate(P &prop, const P &to, float dur, Easing easing = LINEAR)
+        {
+            animate(prop, P(prop), to, dur, easing);
+        }
+
+        //! Drops the track of `prop`, leaving it at its end value if `finish`.
+        template <typename P>
+        bool stop(P &prop, bool finish = true)
+        {
+            const size_t n = tracks<P>().remove(&prop, finish);
+            m_count -= n;
+            return n > 0;
+        }
+
+        //! Once per frame. Returns the number of tracks still running.
+        size_t update()
+        {
+            if (!m_count) return 0;
+            const double now = sim_seconds();
+            m_count = 0;
+            for (auto &s : m_sets) m_count += s.second->update(now);
+            return m_count;
+        }
+
+        //! Jumps all tracks to their end values.
+        void finish()
+        {
+            for (auto &s : m_sets) s.second->clear(true);
+            m_count = 0;
+        }
+
+        //! Drops all tracks, writing nothing.
+        void clear()
+        {
+            for (auto &s : m_sets) s.second->clear(false);
+            m_count = 0;
+        }
+
+        bool active() const { return m_count > 0; }
+        size_t size() const { return m_count; }
+
+    private:
+        struct TrackSetBase
+        {
+            virtual ~TrackSetBase() { }
+            virtual size_t update(double now) = 0;
+            virtual void clear(bool finish) = 0;
+        };
+
+        template <typename P>
+        struct TrackSet : TrackSetBase
+        {
+            std::vector<P*>     prop;
+            std::vector<P>      from;
+            std::vector<P>      delta;
+            std::vector<P>      to;
+            std::vector<double> start;
+            std::vector<float>  rate;       ///< 1 / duration
+            std::vector<float>  ease_a;
+            std::vector<float>  ease_b;
+            std::vector<float>  u;          ///< Eased progress, per update
+
+            size_t add(P *p, const P &f, const P &t, double s, float dur, Easing easing)
+            {
+                static const float coeffs[][2] = { { 0, 0 }, { -1, 0 }, { 1, 0 }, { -1, 2 } };
+                prop.push_back(p);
+                from.push_back(f);
+                delta.push_back(t - f);
+                to.push_back(t);
+                start.push_back(s);
+                rate.push_back(dur > 0 ? 1.0f / dur : 1e30f);
+                ease_a.push_back(coeffs[easing][0]);
+                ease_b.push_back(coeffs[easing][1]);
+                return 1;
+            }
+
+            //! Adding is rare, so finding the track of a property is a scan.
+            size_t remove(P *p, bool finish)
+            {
+                auto it = std::find(prop.begin(), prop.end(), p);
+                if (it == prop.end()) return 0;
+                const size_t i = it - prop.begin();
+                if (finish) *p = to[i];
+                erase(i);
+                return 1;
+            }
+
+            size_t update(double now) override
+            {
+                const size_t n = prop.size();
+                u.resize(n);
+
+                for (size_t i = 0; i < n; i++) {
+                    const float x = (float)((now - start[i]) * rate[i]);
+                    u[i] = std::min(std::max(x, 0.0f), 1.0f);
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                    const float x = u[i];
+                    u[i] = x + x * (1.0f - x) * (ease_a[i] + ease_b[i] * x);
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                    *prop[i] = from[i] + delta[i] * u[i];
+                }
+
+                for (size_t i = n; i-- > 0; ) {
+                    if (u[i] < 1.0f) continue;
+                    *prop[i] = to[i];
+                    erase(i);
+                }
+
+                return prop.size();
+            }
+
+            void clear(bool finish) override
+            {
+                if (finish) {
+                    for (size_t i = 0; i < prop.size(); i++) *prop[i] = to[i];
+                }
+                prop.clear(); from.clear(); delta.clear(); to.clear();
+                start.clear(); rate.clear(); ease_a.clear(); ease_b.clear();
+            }
+
+            //! Swaps in the last track. update() erases backwards, so the
+            //! moved track has been handled already.
+            void erase(size_t i)
+            {
+                const size_t last = prop.size() - 1;
+                if (i != last) {
+                    prop[i] = prop[last]; from[i] = from[last];
+                    delta[i] = delta[last]; to[i] = to[last];
+                    start[i] = start[last]; rate[i] = rate[last];
+                    ease_a[i] = ease_a[last]; ease_b[i] = ease_b[last];
+                }
+                prop.pop_back(); from.pop_back(); delta.pop_back(); to.pop_back();
+                start.pop_back(); rate.pop_back(); ease_a.pop_back(); ease_b.pop_back();
+            }
+        };
+
+        template <typename P>
+        TrackSet<P>& tracks()
+        {
+            const std::type_index type(typeid(P));
+            for (auto &s : m_sets) {
+                if (s.first == type) return static_cast<TrackSet<P>&>(*s.second);
+            }
+            m_sets.emplace_back(type, std::unique_ptr<TrackSetBase>(new TrackSet<P>));
+            return static_cast<TrackSet<P>&>(*m_sets.back().second);
+        }
+
+    private:
+        std::vector<std::pair<std::type_index, std::unique_ptr<TrackSetBase>>> m_sets;
+        size_t m_count = 0;
+    };
+
     template <typename P>
     struct PropertyAnimation : Animation
     {
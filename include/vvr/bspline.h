@@ -1,6 +1,9 @@
 #ifndef BSPLINE_H
 #define BSPLINE_H
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
 #include <vector>
 #include <type_traits>
 
@@ -20,12 +23,23 @@ namespace vvr {
         else return 0.0;
     }
 
+    /**
+     * B-spline of order knots.size() - cps.size(), i.e. degree p = order - 1.
+     * Control points are values or pointers to points that live elsewhere
+     * and may be moved by others (e.g. dragged).
+     *
+     * Evaluation is de Boor's algorithm on the knot span of t: O(p^2) work on
+     * p + 1 points on the stack, no allocation.
+     */
     template <typename T>
     struct BSpline
     {
         typedef typename std::remove_pointer<T>::type point_t;
+        typedef typename std::decay<decltype(ref(std::declval<const T&>()) * 1.0)>::type vec_t;
         typedef std::vector<std::vector<double>> double_vector_2d;
 
+        enum { MaxOrder = 16 };     ///< Higher orders are evaluated on the heap
+
         std::vector<double> knots;
         std::vector<T> cps;
 
@@ -36,50 +50,145 @@ namespace vvr {
             copy_cps(other.cps);
         }
 
-        point_t eval(const double t)
+        int degree() const { return (int)knots.size() - (int)cps.size() - 1; }
+
+        point_t eval(const double t) const
         {
-            const auto &X = knots;
-            const auto &B = cps;
-            const int kn = X.size();
-            const int kp = B.size();
-            const int mb = kn - kp;
-            int i = mb - 1;
-            int k = 0;
-            double_vector_2d N(kn, std::vector<double>(mb, 0.0));
-
-            /* Find knot span */
-            while (t > X[i + 1] && i < kn - mb) i++;
-            N[i][k] = 1;
-
-            for (k = 1; k < mb; k++) {
-                for (i = 0; i < kn - k - 1; i++) {
-                    const double A_num = (t - X[i]) * N[i][k - 1];
-                    const double A_den = X[i + k] - X[i];
-                    const double C_num = (X[i + k + 1] - t) * N[i + 1][k - 1];
-                    const double C_den = X[i + k + 1] - X[i + 1];
-                    const double A = bsp_div(A_num, A_den);
-                    const double C = bsp_div(C_num, C_den);
-                    N[i][k] = A + C;
-                }
+            vec_t p;
+            eval_many(&t, 1, &p);
+            return p;
+        }
+
+        /**
+         * Evaluates n parameters, and the first derivatives if `deriv` is
+         * given. For ascending parameters the knot span is found by walking
+         * from the previous one, so a whole tessellation costs O(n p^2).
+         */
+        template <typename P>
+        void eval_many(const double *t, size_t n, P *out, vec_t *deriv = nullptr) const
+        {
+            const int p = degree();
+            if (p < 0 || cps.empty()) return;
+
+            vec_t local[MaxOrder];
+            std::vector<vec_t> heap;
+            vec_t *d = local;
+            if (p + 1 > MaxOrder) {
+                heap.resize(p + 1);
+                d = heap.data();
             }
 
-            point_t p = ref(B[0]) * N[0][mb - 1];
-            for (i = 1; i < kp; i++) {
-                p += ref(B[i]) * N[i][mb - 1];
+            int k = p;
+            for (size_t i = 0; i < n; i++) {
+                k = span(t[i], k);
+                vec_t dt;
+                out[i] = de_boor(t[i], k, d, deriv ? &dt : nullptr);
+                if (deriv) deriv[i] = dt;
             }
+        }
 
-            return p;
+        //! Knot span of t: X[k] <= t < X[k+1], clamped to [p, n-1]. Starts from `hint`.
+        int span(double t, int hint = -1) const
+        {
+            const auto &X = knots;
+            const int p = degree();
+            const int last = (int)cps.size() - 1;
+            int k = hint;
+            if (k < p || k > last || t < X[k]) {
+                k = (int)(std::upper_bound(X.begin() + p + 1, X.begin() + last + 1, t) - X.begin()) - 1;
+            }
+            while (k < last && t >= X[k + 1]) k++;
+            return k;
         }
 
-        const auto range()
+        std::pair<double, double> range() const
         {
             const int mb = knots.size() - cps.size();
             return std::make_pair(knots[mb - 1], (*(knots.end() - 1)));
         }
 
+        /**
+         * num_pts points at uniform parameter steps, cached until the curve
+         * or num_pts changes.
+         */
+        const std::vector<vec_t> &tessellate(size_t num_pts) const
+        {
+            if (num_pts < 2) num_pts = 2;
+            const unsigned rev = revision();
+            if (m_tess.size() == num_pts && m_tess_rev == rev) return m_tess;
+
+            const auto r = range();
+            const double dt = (r.second - r.first) / (num_pts - 1);
+            m_params.resize(num_pts);
+            for (size_t i = 0; i < num_pts; i++) m_params[i] = r.first + dt * i;
+            m_params.back() = r.second;
+            m_tess.resize(num_pts);
+            eval_many(m_params.data(), num_pts, m_tess.data());
+            m_tess_rev = rev;
+            return m_tess;
+        }
+
+        /**
+         * Counts the changes of the curve's shape, so that users can cache
+         * what they derive from it. The knots and control point positions
+         * are compared to a snapshot; control points may be shared and moved
+         * by others, so there is no setter to hook on.
+         */
+        unsigned revision() const
+        {
+            if (changed()) {
+                m_snap_knots = knots;
+                m_snap_cps.resize(cps.size());
+                for (size_t i = 0; i < cps.size(); i++) m_snap_cps[i] = ref(cps[i]);
+                m_snapped = true;
+                m_revision++;
+            }
+            return m_revision;
+        }
+
+        //! Forces a new revision.
+        void touch() { m_snapped = false; }
+
     private:
+        //! The p + 1 control points of span k, blended down to one.
+        vec_t de_boor(double t, int k, vec_t *d, vec_t *deriv) const
+        {
+            const auto &X = knots;
+            const int p = degree();
+            for (int j = 0; j <= p; j++) {
+                d[j] = ref(cps[j + k - p]);
+            }
+
+            for (int r = 1; r <= p; r++) {
+                //! The last level gives the derivative too.
+                if (r == p && deriv) {
+                    const double den = X[k + 1] - X[k];
+                    *deriv = den != 0.0 ? (d[p] - d[p - 1]) * (p / den) : d[p] * 0.0;
+                }
+                for (int j = p; j >= r; j--) {
+                    const double den = X[j + 1 + k - r] - X[j + k - p];
+                    const double a = den != 0.0 ? (t - X[j + k - p]) / den : 0.0;
+                    d[j] = d[j - 1] * (1.0 - a) + d[j] * a;
+                }
+            }
+
+            if (p == 0 && deriv) *deriv = d[0] * 0.0;
+            return d[p];
+        }
+
+        bool changed() const
+        {
+            if (!m_snapped || m_snap_knots != knots) return true;
+            if (m_snap_cps.size() != cps.size()) return true;
+            for (size_t i = 0; i < cps.size(); i++) {
+                const vec_t cp = ref(cps[i]);
+                if (std::memcmp(&m_snap_cps[i], &cp, sizeof(vec_t))) return true;
+            }
+            return false;
+        }
+
         template <typename R=T,
-            typename std::enable_if<std::is_pointer<R>::value,R>::type=nullptr>
+            typename std::enable_if<std::is_pointer<R>::value,int>::type=0>
             void copy_cps(std::vector<R> const &other_cps)
         {
             for (auto p : other_cps) {
@@ -88,13 +197,21 @@ namespace vvr {
         }
 
         template <typename R=T,
-            typename std::enable_if<!std::is_pointer<R>::value,R>::type=nullptr>
+            typename std::enable_if<!std::is_pointer<R>::value,int>::type=0>
             void copy_cps(std::vector<R> const &other_cps)
         {
             for (auto p : other_cps) {
                 cps.push_back(point_t(ref(p)));
             }
         }
+
+        mutable std::vector<vec_t>  m_tess;
+        mutable std::vector<double> m_params;
+        mutable unsigned            m_tess_rev = 0;
+        mutable std::vector<double> m_snap_knots;
+        mutable std::vector<vec_t>  m_snap_cps;
+        mutable bool                m_snapped = false;
+        mutable unsigned            m_revision = 0;
     };
 }
 
@@ -0,0 +1,160 @@
+#ifndef VVR_BVH_H
+#define VVR_BVH_H
+
+#include "vvrframework_DLL.h"
+#include "drawing.h"
+#include "mesh.h"
+#include <MathGeoLib.h>
+#include <vector>
+#include <unordered_map>
+
+namespace vvr {
+
+    /**
+     * Dynamic AABB tree (insert / remove / refit).
+     * Leaves hold fattened boxes, so that small motions don't restructure the tree.
+     * Proxies are indices to an internal node pool and stay valid until removed.
+     */
+    class VVRFramework_API AabbTree
+    {
+    public:
+        AabbTree(float margin = 0.1f);
+        int insert(const math::AABB &aabb, void *data);
+        void remove(int proxy);
+        bool update(int proxy, const math::AABB &aabb);  ///< Returns true if re-inserted
+        void clear();
+        void* getData(int proxy) const { return m_nodes[proxy].data; }
+        void setData(int proxy, void *data) { m_nodes[proxy].data = data; }
+        const math::AABB& getFatAABB(int proxy) const { return m_nodes[proxy].aabb; }
+        size_t size() const { return m_leaf_count; }
+        int height() const { return m_root < 0 ? 0 : m_nodes[m_root].height; }
+
+        /**
+         * Collect the proxies whose fat box is not outside the frustum.
+         */
+        void query(const math::Frustum &frustum, std::vector<int> &proxies) const;
+
+        /**
+         * Collect the proxies whose fat box overlaps the given box.
+         */
+        void query(const math::AABB &aabb, std::vector<int> &proxies) const;
+
+    private:
+        struct Node
+        {
+            math::AABB aabb;
+            void *data;
+            int parent;     // Next free node, when in the free list
+            int child1;
+            int child2;
+            int height;     // Leaf: 0, Free: -1
+            bool isLeaf() const { return child1 < 0; }
+        };
+
+        int allocNode();
+        void freeNode(int id);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        void refitFrom(int id);
+        int balance(int id);
+        void collectAll(int id, std::vector<int> &proxies) const;
+
+    private:
+        std::vector<Node>   m_nodes;
+        int                 m_root;
+        int                 m_free;
+        size_t              m_leaf_count;
+        float               m_margin;
+    };
+
+    /**
+     * Static hierarchy over the segments of a polyline, for closest segment
+     * queries in O(log n). Consecutive segments are close to each other, so
+     * nodes simply split the segment range in half; build() is O(n).
+     * Rebuild it when the polyline changes.
+     */
+    class VVRFramework_API PolylineBvh
+    {
+    public:
+        PolylineBvh() { }
+        void build(const math::vec *pts, size_t num_pts);
+        void clear();
+        bool empty() const { return m_nodes.empty(); }
+        size_t numSegments() const { return m_pts.size() < 2 ? 0 : m_pts.size() - 1; }
+
+        /**
+         * Squared distance from p to the closest segment, or -1 if none is
+         * within max_dsq. `seg` gets the index of its first point.
+         */
+        real closest(const math::vec &p, real max_dsq, size_t *seg = nullptr) const;
+
+    private:
+        enum { LeafSize = 4 };
+
+        struct Node
+        {
+            math::AABB aabb;
+            int first;      // Segment, or right child for inner nodes
+            int count;      // Segments, 0 for inner nodes; the left child follows
+        };
+
+        int buildRange(int first, int count);
+
+    private:
+        std::vector<Node>       m_nodes;
+        std::vector<math::vec>  m_pts;
+    };
+
+    /**
+     * Bounded drawables and meshes kept in an AabbTree, drawn only when they
+     * intersect the view frustum. Drawables without bounds are always drawn.
+     * Call refit() after moving the objects. Removal swaps the last object into
+     * the freed slot, so it is O(log n) and changes the order of unbounded ones.
+     * Adding an object again only updates its colour and style, for meshes.
+     */
+    class VVRFramework_API CullingGroup
+    {
+    public:
+        vvr_decl_shared_ptr(CullingGroup)
+
+        CullingGroup(float margin = 0.1f) : m_tree(margin), m_num_drawn(0) { }
+        void add(Drawable *drw);
+        void add(Mesh::Ptr mesh, Colour col, Style style);
+        void remove(Drawable *drw);
+        void remove(Mesh::Ptr mesh);
+        void refit();
+        void clear();
+        void draw(const math::Frustum &frustum, bool front_to_back = false);
+        size_t size() const { return m_entries.size(); }
+        size_t numDrawn() const { return m_num_drawn; }    ///< Objects drawn by last draw()
+
+    private:
+        struct Entry
+        {
+            Drawable *drw;
+            Mesh::Ptr mesh;
+            Colour col;
+            Style style;
+            int proxy;      // -1: unbounded
+            int unbounded;  // Index in m_unbounded, -1: bounded
+        };
+
+        bool getBounds(const Entry &entry, math::AABB &aabb) const;
+        void drawEntry(Entry &entry);
+        void removeAt(size_t index);
+        void addUnbounded(size_t index);
+        void removeUnbounded(size_t index);
+
+    private:
+        AabbTree            m_tree;
+        std::vector<Entry>  m_entries;
+        std::unordered_map<const void*, size_t> m_index;   // Drawable or Mesh -> entry
+        std::vector<size_t> m_unbounded;                    // Entries drawn every time
+        std::vector<int>    m_visible;                      // Reused by draw()
+        std::vector<std::pair<float, size_t>> m_order;      // Reused by draw()
+        size_t              m_num_drawn;
+    };
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef VVR_CURVE_H
+#define VVR_CURVE_H
+
+#include "vvrframework_DLL.h"
+#include "drawing.h"
+#include <MathGeoLib.h>
+#include <algorithm>
+#include <vector>
+
+namespace vvr {
+
+    struct CurveSampling
+    {
+        real tolerance = 0.25;  ///< Max distance of the curve from its chords
+        int min_segments = 8;   ///< Initial uniform split
+        int max_depth = 12;     ///< Max halvings of each initial segment
+    };
+
+    /**
+     * Samples eval(t) over [t0, t1] so that no chord strays more than
+     * cs.tolerance from the curve: a span is halved while its midpoint is
+     * too far from the chord. Flat parts get few points, tight bends many.
+     * The midpoint test can't see features that are symmetric about it,
+     * which the initial uniform split guards against.
+     */
+    template <typename EvalFn>
+    void tessellate_adaptive(EvalFn eval, double t0, double t1,
+                             const CurveSampling &cs, std::vector<math::vec> &pts)
+    {
+        struct Span { double ta, tb; math::vec b; int depth; };
+
+        const int n = std::max(1, cs.min_segments);
+        const real tol_sq = cs.tolerance * cs.tolerance;
+        std::vector<Span> stack;
+
+        pts.clear();
+        pts.push_back(eval(t0));
+
+        for (int i = 0; i < n; i++)
+        {
+            const double ta = t0 + (t1 - t0) * i / n;
+            const double tb = i == n - 1 ? t1 : t0 + (t1 - t0) * (i + 1) / n;
+            stack.push_back({ ta, tb, eval(tb), 0 });
+
+            //! Left halves are on top, so points come out in order.
+            while (!stack.empty())
+            {
+                const Span s = stack.back();
+                const double tm = 0.5 * (s.ta + s.tb);
+                const math::vec m = eval(tm);
+                if (s.depth < cs.max_depth &&
+                    math::LineSegment(pts.back(), s.b).DistanceSq(m) > tol_sq) {
+                    stack.back() = { tm, s.tb, s.b, s.depth + 1 };
+                    stack.push_back({ s.ta, tm, m, s.depth + 1 });
+                } else {
+                    pts.push_back(s.b);
+                    stack.pop_back();
+                }
+            }
+        }
+    }
+
+    /**
+     * A curve given by its points, e.g. a Hilbert curve.
+     * Call touch() after editing them.
+     */
+    struct PolylineCurve
+    {
+        std::vector<math::vec> pts;
+
+        unsigned revision() const { return m_revision; }
+        void touch() { m_revision++; }
+
+    private:
+        unsigned m_revision = 1;
+    };
+
+    /**
+     * How drawables turn a curve into points. Parametric curves, having
+     * eval(), range() and revision(), are sampled adaptively. Specialise
+     * for curves that have their own points or a better way to sample.
+     */
+    template <typename C>
+    struct CurveSampler
+    {
+        static unsigned revision(const C &curve) { return curve.revision(); }
+
+        static void sample(const C &curve, const CurveSampling &cs, std::vector<math::vec> &pts)
+        {
+            const auto r = curve.range();
+            tessellate_adaptive([&curve](double t) { return math::vec(curve.eval(t)); },
+                                r.first, r.second, cs, pts);
+        }
+    };
+
+    template <>
+    struct CurveSampler<PolylineCurve>
+    {
+        static unsigned revision(const PolylineCurve &curve) { return curve.revision(); }
+
+        static void sample(const PolylineCurve &curve, const CurveSampling &, std::vector<math::vec> &pts)
+        {
+            pts = curve.pts;
+        }
+    };
+}
+
+#endif
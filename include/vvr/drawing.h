@@ -30,6 +30,37 @@ namespace vvr
 
     VVRFramework_API void collect(Canvas&, Drawable*);
 
+    /*---------------------------------------------------------------[Geometry cache]---*/
+    enum Lod { LOD_LOW = 0, LOD_MEDIUM, LOD_HIGH, LOD_COUNT };
+
+    enum UnitShape { UNIT_SPHERE = 0, UNIT_CYLINDER, UNIT_BOX, UNIT_SHAPE_COUNT };
+
+    //! Unit sized geometry tessellated once and shared by every shape of its kind.
+    //! Sphere: radius 1, centered at the origin.
+    //! Cylinder: radius 1, base at z=0, top at z=-1. Parts: {base, sides, top}.
+    //! Box: the [0,1]^3 cube.
+    struct VVRFramework_API UnitMesh
+    {
+        struct Part
+        {
+            unsigned mode;  // GL primitive
+            int first;
+            int count;
+        };
+
+        std::vector<vec> vertices;
+        std::vector<vec> normals;
+        std::vector<Part> parts;
+
+        //! Enables the vertex arrays. Call once before a series of drawParts() calls.
+        void bind() const;
+        void unbind() const;
+        void drawParts(unsigned part_mask = ~0u) const;
+        void draw(unsigned part_mask = ~0u) const { bind(); drawParts(part_mask); unbind(); }
+    };
+
+    VVRFramework_API const UnitMesh& getUnitMesh(UnitShape shape, Lod lod = LOD_MEDIUM);
+
     /*--------------------------------------------------------------------[Drawables]---*/
     struct VVRFramework_API Drawable
     {
@@ -37,13 +68,21 @@ namespace vvr
         virtual void draw() const = 0;
         virtual real pickdist(int x, int y) const { return real(-1); }
         virtual real pickdist(const math::Ray&) const { return real(-1); }
+        virtual bool getBounds(math::AABB &aabb) const { return false; } // false: unbounded
         virtual Drawable* clone() { return nullptr; }
         virtual void collect(Canvas &canvas);
         void drawif() const { if (visible) draw(); }
         bool show() { return (visible = true); }
         bool hide() { return (visible = false); }
         bool toggle() { return (visible = !visible); }
+        //! Bumped by the setters, so that baked canvas frames notice the change.
+        //! Call touch() after writing to public members directly.
+        unsigned revision() const { return m_revision; }
+        void touch() { m_revision++; }
         bool visible = true;
+
+    private:
+        unsigned m_revision = 1;
     };
 
     struct VVRFramework_API Shape : Drawable
@@ -70,15 +109,21 @@ namespace vvr
     private:
         struct Frame
         {
-            Frame(bool show_old = true) : show_old(show_old) { }
+            Frame(bool show_old = true) : show_old(show_old), list(0), signature(0) { }
             std::vector<Drawable*> drvec;
             bool show_old;
+            mutable unsigned list;      // GL display list holding the baked frame
+            mutable size_t signature;   // State the display list was recorded with
         };
 
         size_t fid;
         bool del_on_clear;
+        bool bake;
         std::vector<Frame> frames;
 
+        void drawFrame(const Frame &frame, bool sealed) const;
+        void releaseFrames(size_t from, size_t to);
+
     public:
         Canvas();
         ~Canvas();
@@ -88,6 +133,12 @@ namespace vvr
         size_t size() const { return frames.size(); }
         size_t frameIndex() const { return fid; }
         void setDelOnClear(bool del) { del_on_clear = del; }
+        //! Record frames that are no longer being built into display lists and replay
+        //! them with a single call. Adding, clearing, hiding or changing drawables
+        //! through their setters re-records a frame; after writing to their public
+        //! members directly, touch() them or invalidate() the canvas.
+        void setBaking(bool bake_frames) { bake = bake_frames; invalidate(); }
+        void invalidate();
         bool isAtStart() const { return fid == 0; }
         bool isAtEnd() const { return fid == frames.size() - 1; }
         void newFrame(bool show_old_frames = true);
@@ -146,6 +197,7 @@ namespace vvr
             vvr_setmemb(y1);
             vvr_setmemb(x2);
             vvr_setmemb(y2);
+            touch();
         }
 
     private:
@@ -173,6 +225,7 @@ namespace vvr
             vvr_setmemb(y1);
             vvr_setmemb(x2);
             vvr_setmemb(y2);
+            touch();
         }
 
     private:
@@ -216,6 +269,7 @@ namespace vvr
             vvr_setmemb(y2);
             vvr_setmemb(x3);
             vvr_setmemb(y3);
+            touch();
         }
 
     private:
@@ -237,11 +291,13 @@ namespace vvr
         {
             range_from = from;
             range_to = to;
+            touch();
         }
 
         void setClosedLoop(bool closed)
         {
             closed_loop = closed;
+            touch();
         }
 
         real pickdist(int x, int y) const override
@@ -281,6 +337,12 @@ namespace vvr
             return (d < PointSize) ? d : -1;
         }
 
+        bool getBounds(math::AABB &aabb) const override
+        {
+            aabb = math::AABB(*this, *this);
+            return true;
+        }
+
     private:
         void drawShape() const override;
     };
@@ -302,6 +364,14 @@ namespace vvr
             return d <= Point3D::PointSize ? d : -1.0f;
         }
 
+        bool getBounds(math::AABB &aabb) const override
+        {
+            aabb.SetNegativeInfinity();
+            aabb.Enclose(a);
+            aabb.Enclose(b);
+            return true;
+        }
+
     private:
         void drawShape() const override;
     };
@@ -315,6 +385,13 @@ namespace vvr
             , math::Sphere({x,y,z}, r)
         { }
 
+        bool getBounds(math::AABB &aabb) const override
+        {
+            aabb.SetNegativeInfinity();
+            aabb.Enclose(static_cast<const math::Sphere&>(*this));
+            return true;
+        }
+
     private:
         void drawShape() const override;
     };
@@ -341,6 +418,13 @@ namespace vvr
         void setTransparency(real a)
         {
             transparency = a;
+            touch();
+        }
+
+        bool getBounds(math::AABB &aabb) const override
+        {
+            aabb = static_cast<const math::AABB&>(*this);
+            return true;
         }
 
         real transparency;
@@ -361,6 +445,7 @@ namespace vvr
         Obb3D(const Obb3D&) = delete;
         void set(const math::AABB& aabb, const math::float4x4& transform);
         void drawShape() const override;
+        bool getBounds(math::AABB &aabb) const override;
         Colour col_edge;
 
     private:
@@ -402,11 +487,19 @@ namespace vvr
             return intr ? Distance(ip) : real(-1);
         }
 
+        bool getBounds(math::AABB &aabb) const override
+        {
+            aabb.SetNegativeInfinity();
+            aabb.Enclose(static_cast<const math::Triangle&>(*this));
+            return true;
+        }
+
         void setColourPerVertex(const Colour &c1, const Colour &c2, const Colour &c3)
         {
             vertex_col[0] = c1;
             vertex_col[1] = c2;
             vertex_col[2] = c3;
+            touch();
         }
 
         Colour vertex_col[3];
@@ -450,6 +543,8 @@ namespace vvr
             return math::Circle(basecenter + normal*height, normal, radius);
         }
 
+        bool getBounds(math::AABB &aabb) const override;
+
         vec basecenter;
         vec normal;
         real radius;
@@ -473,6 +568,7 @@ namespace vvr
         Quad3D(const math::vec &pos, const math::vec &norm, float halfside, const vvr::Colour &col);
         void draw() const override;
         real pickdist(const math::Ray &ray) const override;
+        bool getBounds(math::AABB &aabb) const override;
 
         math::vec pos;
         math::vec X, Y;
@@ -508,6 +604,7 @@ namespace vvr
             x = vvr::LineSeg3D(0, 0, 0, d, 0, 0, vvr::red);
             y = vvr::LineSeg3D(0, 0, 0, 0, d, 0, vvr::green);
             z = vvr::LineSeg3D(0, 0, 0, 0, 0, d, vvr::blue);
+            touch();
         }
 
         virtual void draw() const override
@@ -521,6 +618,42 @@ namespace vvr
         LineSeg3D x, y, z;
     };
 
+    /*---[Batching]---------------------------------------------------------------------*/
+    //! Collects spheres, cylinders and boxes and bakes them from the cached unit meshes
+    //! into world space vertex arrays, so that each primitive type takes one draw call.
+    //! The meshes are taken at the `lod` set when a shape is added.
+    struct VVRFramework_API InstanceBatch : Drawable
+    {
+        vvr_decl_shared_ptr(InstanceBatch)
+
+        InstanceBatch(Lod lod = LOD_MEDIUM) : lod(lod), m_count(0) { }
+        void add(const Sphere3D &sphere);
+        void add(const Cylinder3D &cylinder);
+        void add(const Aabb3D &aabb);
+        void clear();
+        size_t size() const;
+        void draw() const override;
+
+        Lod lod;
+
+    private:
+        enum { FILL = 0, LINE, POLYGON_MODES };
+        enum { TRIANGLES = 0, QUADS, PRIMITIVES };
+
+        struct Bucket
+        {
+            std::vector<vec> vertices;
+            std::vector<vec> normals;
+            std::vector<Colour> colours;
+        };
+
+        void bake(UnitShape shape, const math::float4x4 &transform, Colour colour,
+            unsigned part_mask, int polygon_mode);
+
+        Bucket m_buckets[POLYGON_MODES][PRIMITIVES];
+        size_t m_count;
+    };
+
     /*---[Composite]--------------------------------------------------------------------*/
     template <class WholeT, class BlockT, size_t N>
     struct Composite : public Drawable
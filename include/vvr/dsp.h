@@ -2,12 +2,61 @@
 #define DSP_H
 
 #include "vvrframework_DLL.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <type_traits>
 #include <vector>
 
 namespace vvr { namespace dsp
 {
     typedef std::vector<double> Signal;
 
+    /**
+     * Non-owning view of samples: a pointer, a length and a stride, in
+     * elements. A stride other than 1 views one channel of an interleaved
+     * recording without copying it.
+     */
+    template <typename T>
+    class View
+    {
+    public:
+        typedef typename std::remove_const<T>::type value_type;
+
+        View() : m_data(nullptr), m_size(0), m_stride(1) { }
+        View(T *data, size_t size, ptrdiff_t stride = 1) : m_data(data), m_size(size), m_stride(stride) { }
+        View(std::vector<value_type> &v) : View(v.data(), v.size()) { }
+        View(const std::vector<value_type> &v) : View(v.data(), v.size()) { }
+        View(const View<value_type> &v) : View(v.data(), v.size(), v.stride()) { }
+
+        //! Channel `c` of `frames` interleaved frames of `channels` samples.
+        static View channel(T *interleaved, size_t frames, size_t channels, size_t c) {
+            return View(interleaved + c, frames, (ptrdiff_t)channels);
+        }
+
+        T &operator[](size_t i) const { return m_data[(ptrdiff_t)i * m_stride]; }
+        T *data() const { return m_data; }
+        size_t size() const { return m_size; }
+        ptrdiff_t stride() const { return m_stride; }
+        bool empty() const { return !m_size; }
+
+        View sub(size_t offset, size_t count) const {
+            offset = std::min(offset, m_size);
+            return View(m_data + (ptrdiff_t)offset * m_stride, std::min(count, m_size - offset), m_stride);
+        }
+
+    private:
+        T          *m_data;
+        size_t      m_size;
+        ptrdiff_t   m_stride;
+    };
+
+    typedef View<const double>  SignalView;
+    typedef View<double>        SignalSpan;
+    typedef View<const float>   SignalViewF;
+    typedef View<float>         SignalSpanF;
+
     Signal
     VVRFramework_API diff(const Signal &in, size_t stride = 1);
 
@@ -26,11 +75,239 @@ namespace vvr { namespace dsp
     size_t
     VVRFramework_API detect_nonzero(const Signal &signal, size_t offset, double tol = 0, bool reverse_dir = false);
 
+    /**
+     * Output buffer variants of the above. They write in.size() samples to
+     * `out`, which may be `in` itself (in place), or must not overlap it.
+     * They allocate nothing, except smooth(), which keeps a window of input.
+     */
+    void
+    VVRFramework_API diff(SignalView in, SignalSpan out, size_t stride = 1);
+
+    void
+    VVRFramework_API smooth(SignalView in, SignalSpan out, size_t window_size);
+
+    void
+    VVRFramework_API threshold(SignalView in, SignalSpan out, double threshold);
+
+    void
+    VVRFramework_API consecutive_threshold(SignalView in, SignalSpan out, size_t max_cons_vals);
+
     double
     VVRFramework_API interp_linear(double x0, double x1, double y0, double y1, double x);
 
     double
     VVRFramework_API interp_smooth_01(size_t i, size_t imax);
+
+    /*---[Streaming filters]--------------------------------------------------------*/
+
+    /**
+     * Stateful filter, fed a signal in chunks of any size.
+     *
+     * process() may be called with in == out. The output depends only on the
+     * samples seen since reset(), never on how they were chunked: feeding a
+     * signal at once or in pieces gives bit-identical results.
+     */
+    class VVRFramework_API Filter
+    {
+    public:
+        virtual ~Filter() { }
+        virtual void process(const double *in, double *out, size_t n) = 0;
+        virtual void reset() = 0;
+
+        Signal apply(const Signal &in);     ///< Continues from the current state
+    };
+
+    /**
+     * Causal moving average of the last `window` samples, O(1) per sample.
+     * Until the window fills, averages the samples seen so far. The running
+     * sum is compensated, so it does not drift on long recordings.
+     */
+    class VVRFramework_API MovingAverage : public Filter
+    {
+    public:
+        explicit MovingAverage(size_t window);
+        void process(const double *in, double *out, size_t n) override;
+        void reset() override;
+        double step(double x);
+        size_t window() const { return m_ring.size(); }
+
+    private:
+        std::vector<double> m_ring;
+        size_t      m_pos;
+        size_t      m_count;
+        double      m_sum;
+        double      m_comp;     ///< Kahan-Babuska compensation of m_sum
+    };
+
+    /**
+     * Exponential moving average: y += alpha * (x - y).
+     * Starts from the first sample.
+     */
+    class VVRFramework_API Ema : public Filter
+    {
+    public:
+        explicit Ema(double alpha);
+        static Ema fromTimeConstant(double tau_sec, double sample_rate);
+        void process(const double *in, double *out, size_t n) override;
+        void reset() override { m_started = false; m_y = 0; }
+        double step(double x);
+
+    private:
+        double      m_alpha;
+        double      m_y;
+        bool        m_started;
+    };
+
+    /**
+     * Second order IIR section, transposed direct form II:
+     * y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2].
+     * The factories design the RBJ cookbook responses.
+     */
+    class VVRFramework_API Biquad : public Filter
+    {
+    public:
+        Biquad(double b0, double b1, double b2, double a1, double a2);
+        static Biquad lowpass(double cutoff, double sample_rate, double q = 0.70710678118654752);
+        static Biquad highpass(double cutoff, double sample_rate, double q = 0.70710678118654752);
+        static Biquad bandpass(double center, double sample_rate, double q = 0.70710678118654752);
+        static Biquad notch(double center, double sample_rate, double q = 0.70710678118654752);
+        void process(const double *in, double *out, size_t n) override;
+        void reset() override { m_z1 = m_z2 = 0; }
+        double step(double x);
+
+    private:
+        double      m_b0, m_b1, m_b2, m_a1, m_a2;
+        double      m_z1, m_z2;
+    };
+
+    /**
+     * Causal moving median of the last `window` samples, O(log window) per
+     * sample. The window is split in a low and a high half, kept balanced,
+     * so the median is always at the top of the low half. Until the window
+     * fills, the median of the samples seen so far.
+     */
+    class VVRFramework_API MovingMedian : public Filter
+    {
+    public:
+        explicit MovingMedian(size_t window);
+        void process(const double *in, double *out, size_t n) override;
+        void reset() override;
+        double step(double x);
+        size_t window() const { return m_ring.size(); }
+
+    private:
+        void rebalance();
+
+        std::vector<double> m_ring;
+        size_t      m_pos;
+        size_t      m_count;
+        std::multiset<double> m_low;    ///< Smaller half; its max is the median
+        std::multiset<double> m_high;
+    };
+
+    /**
+     * Backward difference over `stride` samples, scaled to units per second:
+     * y = (x - x[-stride]) * sample_rate / stride.
+     * Until `stride` samples are seen, differences against the first sample.
+     */
+    class VVRFramework_API Derivative : public Filter
+    {
+    public:
+        explicit Derivative(size_t stride = 1, double sample_rate = 1);
+        void process(const double *in, double *out, size_t n) override;
+        void reset() override;
+        double step(double x);
+
+    private:
+        std::vector<double> m_ring;
+        size_t      m_pos;
+        size_t      m_count;
+        double      m_rate;
+    };
+
+    /*---[Pipeline]-----------------------------------------------------------------*/
+
+    /**
+     * Chain of signal stages, run as one pass over the input.
+     *
+     * The input is read in blocks that stay in cache; every stage processes a
+     * block in place before the next block is read, and the result is written
+     * straight to the output. No intermediate signals are allocated, and
+     * run() allocates nothing. Views of float or double, of any stride, can
+     * be read and written, e.g. one channel of an interleaved recording.
+     *
+     * The diff / smooth / threshold / consecutive_threshold stages give the
+     * same output as the functions of the same name applied one after the
+     * other. smooth() is centered: it holds back half a window of samples,
+     * which come out at the end of the run. Every run() starts from a clean
+     * state, so one pipeline can be run over each channel in turn.
+     *
+     *     Pipeline p;
+     *     p.diff().smooth(15).threshold(0.5).consecutive_threshold(20);
+     *     p.run(SignalView::channel(imu, frames, channels, 3), SignalSpan(steps));
+     */
+    class VVRFramework_API Pipeline
+    {
+    public:
+        struct Stage;
+
+        Pipeline();
+        ~Pipeline();
+        Pipeline(Pipeline &&);
+        Pipeline &operator=(Pipeline &&);
+
+        Pipeline &diff(size_t stride = 1);      ///< Differs from dsp::diff() only if stride > size
+        Pipeline &smooth(size_t window_size);
+        Pipeline &threshold(double threshold);
+        Pipeline &consecutive_threshold(size_t max_cons_vals);
+        Pipeline &filter(std::shared_ptr<Filter> filter);   ///< Reset on every run
+        Pipeline &add(std::unique_ptr<Stage> stage);
+
+        //! Writes in.size() samples. `out` may be `in`.
+        template <typename In, typename Out>
+        void run(View<In> in, View<Out> out);
+
+        Signal run(const Signal &in);
+
+        enum { BlockSize = 1024 };  ///< Samples; 8 KB of doubles
+
+    private:
+        void reset();
+        size_t pass(double *block, size_t n);   ///< Returns the samples that came out
+        size_t finish(double *block);           ///< Flushes held back samples
+
+        std::vector<std::unique_ptr<Stage>> m_stages;
+        std::vector<double> m_block;
+    };
+
+    /**
+     * A pipeline stage works in place on a block. It may hold samples back
+     * and emit fewer than it was given; finish() then gets the rest out.
+     */
+    struct VVRFramework_API Pipeline::Stage
+    {
+        virtual ~Stage() { }
+        virtual void reset() = 0;
+        virtual size_t process(double *block, size_t n) = 0;     ///< Returns the samples emitted
+        virtual size_t finish(double *) { return 0; }            ///< Emits the held back samples
+        virtual size_t latency() const { return 0; }             ///< Most samples held back
+    };
+
+    template <typename In, typename Out>
+    void Pipeline::run(View<In> in, View<Out> out)
+    {
+        reset();
+        double *block = m_block.data();
+        size_t w = 0;
+        for (size_t i = 0; i < in.size(); i += BlockSize) {
+            const size_t n = std::min((size_t)BlockSize, in.size() - i);
+            for (size_t j = 0; j < n; j++) block[j] = in[i + j];
+            const size_t m = pass(block, n);
+            for (size_t j = 0; j < m; j++) out[w++] = (Out)block[j];
+        }
+        const size_t m = finish(block);
+        for (size_t j = 0; j < m; j++) out[w++] = (Out)block[j];
+    }
 }}
 
 #endif
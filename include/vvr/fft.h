@@ -0,0 +1,105 @@
+#ifndef VVR_FFT_H
+#define VVR_FFT_H
+
+#include "vvrframework_DLL.h"
+#include "dsp.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace vvr { namespace dsp
+{
+    typedef std::complex<double> Complex;
+    typedef std::vector<Complex> Spectrum;
+
+    /**
+     * Discrete Fourier transform of a fixed size, with its twiddle factors
+     * precomputed. Any size works: sizes made of 2, 3 and 5 run mixed radix,
+     * other factors as generic butterflies, and sizes with a large prime
+     * factor through Bluestein's chirp-z on a power of 2.
+     *
+     * Plans are immutable once built, so one plan can be shared by threads.
+     * get() caches a plan per size.
+     *
+     * forward() computes X[k] = sum x[j] e^(-2 pi i jk / n), unscaled;
+     * inverse() scales by 1/n, so inverse(forward(x)) == x.
+     */
+    class VVRFramework_API FftPlan
+    {
+    public:
+        explicit FftPlan(size_t n);
+        ~FftPlan();
+
+        static std::shared_ptr<const FftPlan> get(size_t n);
+
+        size_t size() const { return m_n; }
+
+        //! `out` may be `in`.
+        void forward(const Complex *in, Complex *out) const;
+        void inverse(const Complex *in, Complex *out) const;
+
+        //! n real samples to the n/2 + 1 non-redundant bins.
+        void forwardReal(const double *in, Complex *out) const;
+
+        //! n/2 + 1 bins back to n real samples.
+        void inverseReal(const Complex *in, double *out) const;
+
+    private:
+        void transform(const Complex *in, Complex *out) const;
+        void work(Complex *out, const Complex *in, size_t fstride, const size_t *factors) const;
+        void butterfly2(Complex *out, size_t fstride, size_t m) const;
+        void butterfly3(Complex *out, size_t fstride, size_t m) const;
+        void butterfly4(Complex *out, size_t fstride, size_t m) const;
+        void butterfly(Complex *out, size_t fstride, size_t m, size_t p) const;
+        void bluestein(const Complex *in, Complex *out) const;
+
+        size_t                  m_n;
+        std::vector<size_t>     m_factors;      ///< (radix, remaining length) pairs
+        std::vector<Complex>    m_twiddles;     ///< e^(-2 pi i k / n)
+
+        //! Bluestein
+        std::shared_ptr<const FftPlan> m_conv;  ///< Power of 2 >= 2n - 1
+        std::vector<Complex>    m_chirp;        ///< e^(-pi i k^2 / n)
+        std::vector<Complex>    m_chirp_fft;    ///< Transform of the conjugate chirp, scaled
+
+        //! Real transforms of even sizes run as a complex one of half the size.
+        std::shared_ptr<const FftPlan> m_half;
+        std::vector<Complex>    m_real_twiddles;
+    };
+
+    Spectrum
+    VVRFramework_API fft(const Spectrum &in);
+
+    Spectrum
+    VVRFramework_API ifft(const Spectrum &in);
+
+    //! n / 2 + 1 bins
+    Spectrum
+    VVRFramework_API rfft(const Signal &in);
+
+    //! `n` is the length of the real signal.
+    Signal
+    VVRFramework_API irfft(const Spectrum &in, size_t n);
+
+    /**
+     * Real transforms of every channel of an interleaved recording, with one
+     * plan and one scratch buffer. out[c] gets frames / 2 + 1 bins.
+     */
+    void
+    VVRFramework_API rfft_channels(const double *interleaved, size_t frames, size_t channels, std::vector<Spectrum> &out);
+
+    /**
+     * Linear convolution. Long kernels go through the FFT, O(n log n), short
+     * ones are convolved directly. The full result has in.size() +
+     * kernel.size() - 1 samples; with same_size, the in.size() samples
+     * centered on the kernel, e.g. for smoothing.
+     */
+    Signal
+    VVRFramework_API convolve(const Signal &in, const Signal &kernel, bool same_size = false);
+
+    //! Smallest size >= n made of the factors 2, 3 and 5.
+    size_t
+    VVRFramework_API fft_fast_size(size_t n);
+}}
+
+#endif
@@ -4,6 +4,7 @@
 #include "vvrframework_DLL.h"
 #include "scene.h"
 #include <QOpenGLWidget>
+#include <QElapsedTimer>
 #include <QInputEvent>
 #include <QTimer>
 
@@ -17,13 +18,20 @@ public:
     GlWidget(vvr::Scene *scene=0, QWidget *parent = 0);
 
 public slots:
-    void idle();
+    void idle();                    ///< Schedule a frame: Scene::idle() then repaint
     void setScene(vvr::Scene *scene);
+    void setTargetFps(float fps);   ///< Frame rate cap of the scene. 0: display refresh rate
+
+private slots:
+    void tick();
+    void onFrameSwapped();
+    void onSwapTimeout();
 
 protected:
     void initializeGL() override;
     void paintGL() override;
     void resizeGL(int w, int h) override;
+    void showEvent(QShowEvent*) override;
     void mousePressEvent(QMouseEvent*) override;
     void mouseReleaseEvent(QMouseEvent*) override;
     void mouseMoveEvent(QMouseEvent*) override;
@@ -32,9 +40,18 @@ protected:
     bool eventFilter(QObject*, QEvent*) override;
     void keyEventCore(QKeyEvent *, bool pressed);
 
+private:
+    int frameBudget() const;        ///< Milliseconds per frame
+
 private:
     Scene *m_scene;
     QTimer m_timer;
+    QTimer m_swap_timer;            ///< Fallback for frames that are never swapped
+    QElapsedTimer m_clock;
+    qint64 m_last_tick;
+    bool m_frame_pending;           ///< Tick scheduled or frame not yet swapped
+    bool m_animating;               ///< Last Scene::idle() asked for more frames
+    bool m_dirty;                   ///< Requested while a frame was pending
 };
 
 }
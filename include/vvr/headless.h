@@ -0,0 +1,49 @@
+#ifndef VVR_HEADLESS_H
+#define VVR_HEADLESS_H
+
+#include "vvrframework_DLL.h"
+#include <string>
+
+namespace vvr {
+
+    class Scene;
+
+    struct VVRFramework_API HeadlessOptions
+    {
+        int         frames = 300;       ///< Measured frames
+        int         warmup = 30;        ///< Frames run before measuring
+        int         width = 1280;
+        int         height = 720;
+        float       dt = 1.0f / 60;     ///< Synthetic seconds per frame
+        bool        input = true;       ///< Drag the mouse in a circle while running
+        bool        render = true;      ///< Off: simulate only, as fast as possible
+        std::string output;             ///< JSON report file. Empty: stdout
+        std::string record;             ///< Save a SimRecording of the run
+        std::string replay;             ///< Replay a SimRecording instead of live input
+        unsigned    seed = 0;           ///< Seed of a new recording
+
+        /**
+         * Parse --bench [--frames N] [--warmup N] [--size WxH] [--dt SEC]
+         * [--no-input] [--no-render] [--bench-out FILE]. Returns false
+         * without --bench. The record / replay options, [--record FILE]
+         * [--seed N] [--replay FILE], are parsed in any case, since windowed
+         * runs can record and replay too.
+         */
+        static bool parse(int argc, char* argv[], HeadlessOptions &opt);
+    };
+
+    /**
+     * Hosts a Scene on an offscreen GL surface, without Window or GlWidget.
+     * Runs a fixed number of idle() / render iterations on synthetic time
+     * and reports per-frame CPU and GPU timings as JSON. With no display,
+     * the Qt "offscreen" platform is used, so software GL (llvmpipe) works.
+     */
+    class VVRFramework_API HeadlessRunner
+    {
+    public:
+        static int run(int argc, char* argv[], Scene *scene, const HeadlessOptions &opt);
+    };
+
+}
+
+#endif
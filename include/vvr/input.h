@@ -0,0 +1,38 @@
+#ifndef VVR_INPUT_H
+#define VVR_INPUT_H
+
+namespace vvr {
+
+    /**
+     * A user input event, as delivered to a Scene.
+     * Mouse coordinates are in VVR pixel coordinates (origin in the center).
+     * Events are queued on arrival and delivered once per frame, before
+     * Scene::idle(); see Scene::getMotionSamples().
+     */
+    struct InputEvent
+    {
+        enum Type
+        {
+            MousePress = 0,
+            MouseRelease,
+            MouseMove,
+            MouseHover,
+            MouseWheel,
+            Key,
+            Arrow,
+            Slider,
+        };
+
+        Type    type = MousePress;
+        int     x = 0;              ///< Mouse x. Wheel direction. Slider id.
+        int     y = 0;              ///< Mouse y.
+        int     modif = 0;
+        int     key = 0;            ///< Key code. ArrowDir for arrows.
+        bool    up = false;         ///< Key / arrow released
+        float   value = 0;          ///< Slider value [0,1]
+        double  time = 0;           ///< Seconds, from the OS timestamp. Not recorded.
+    };
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef VVR_LOG_H
+#define VVR_LOG_H
+
+#include "vvrframework_DLL.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vvr {
+
+    /**
+     * Asynchronous sink for the text written to std::cout / std::cerr.
+     *
+     * write() copies the text into a fixed ring of slots and returns; it
+     * never allocates, from any thread, and locks only briefly to wake the
+     * background thread when that was idle. The background thread echoes
+     * the text to the console, appends it to the log file and formats it
+     * into lines of HTML for the log widget, which takes them when notified.
+     *
+     * The console and the file get every write: when the ring is full,
+     * write() waits for room. Writes to Err return once they are written,
+     * so that the last errors before a crash are not lost. Only the lines
+     * for the widget are dropped, beyond MaxPendingLines untaken ones.
+     *
+     * Set VVR_LOG_FILE in the environment, or call setFile(), to keep a
+     * log of long runs.
+     */
+    class VVRFramework_API LogSink
+    {
+    public:
+        enum Stream { Out = 0, Err };
+
+        struct Line
+        {
+            std::string html;
+            bool        complete;   ///< Ended with a newline; else continued by the next line
+        };
+
+        static const size_t SlotSize = 240;         ///< Longer writes take more slots
+        static const size_t NumSlots = 1 << 12;
+        static const size_t MaxPendingLines = 2000; ///< Older lines are dropped
+
+        typedef void (*Notify)(void *user);
+
+        static void write(Stream stream, const char *text, size_t len);
+
+        /**
+         * The lines formatted since the last call, appended to `lines`.
+         * Returns the number of lines dropped meanwhile.
+         */
+        static size_t take(std::vector<Line> &lines);
+
+        /**
+         * Called from the background thread when new lines are ready, once
+         * until take() is called. Must not block or call back into LogSink.
+         */
+        static void setNotify(Notify notify, void *user);
+
+        static bool setFile(const std::string &filename);   ///< Empty to close
+        static void setEcho(bool on);                       ///< Console output, on by default
+        static uint64_t dropped();                          ///< Lines, since start
+
+        //! Waits until everything written so far is formatted.
+        static void flush();
+    };
+
+}
+
+#endif
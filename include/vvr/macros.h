@@ -50,6 +50,7 @@
     void setGeom(const Base& gmb)                                                       \
     {                                                                                   \
         static_cast<Base&>(*this) = gmb;                                                \
+        touch();                                                                        \
     }                                                                                   \
     Name(const vvr::Colour& col=vvr::Colour())                                          \
         : Shape(col, filled)                                                            \
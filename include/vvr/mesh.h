@@ -93,7 +93,7 @@ public:
     Mesh(const std::string &objFile, const std::string &texFile=std::string(), bool ccw = true);
     Mesh(const Mesh &original);
     void operator=(const Mesh &src);
-    void exportToObj(const std::string &filename);
+    void exportToObj(const std::string &filename) const;
 
 private:
     std::vector<math::vec>  mVertices;              ///< Vertex list
@@ -102,6 +102,7 @@ private:
     math::float3x4          mMatrix;                ///< Model rotation around its local axis
     math::AABB              mAABB;                  ///< The bounding box of the model
     bool                    mCCW;                   ///< Clockwise-ness
+    std::vector<Ptr>        mLods;                  ///< Simplified copies, each coarser than the previous
 
 private:
     void updateTriangleData();                      ///< Recalculates the plane equations of the triangles
@@ -109,9 +110,12 @@ private:
     void drawTriangles(Colour col, bool wire = 0);  ///< Draw the triangles. This is the actual model drawing.
     void drawNormals(Colour col);                   ///< Draw the normals of each vertex
     void drawAxes();
+    void drawLevel(Mesh &geom, Colour col, Style style);    ///< Draw the geometry of 'geom' with this mesh's transform
+    Ptr simplify(size_t max_triangles, int axis_shift) const;
 
 public:
     void draw(Colour col, Style style);             ///< Draw the mesh with the specified style
+    void draw(Colour col, Style style, const math::Frustum &frustum); ///< Draw the LOD that suits the projected size
     void move(const math::vec &p);                  ///< Move the mesh in the world.
     void setBigSize(float size);                    ///< Set the meshes size according to the max size of three (x|y|z)
     void cornerAlign();                             ///< Align the mesh to the corner of each local axis
@@ -127,6 +131,30 @@ public:
     void setTransform(const math::float3x4 &t);
     math::AABB getAABB() const;
     float getMaxSize() const;
+
+    /**
+     * Merge vertices closer than 'tolerance' (0: exact duplicates) and drop the
+     * triangles that become degenerate. Uses a spatial hash, so it is O(n) expected.
+     * Returns the number of vertices removed.
+     */
+    size_t weld(float tolerance = 0.0f);
+
+    /**
+     * Quadric error edge collapse, down to (about) max_triangles.
+     * The mesh is split in a fixed number of slabs that are simplified in
+     * parallel, with their shared border vertices kept in place, so the
+     * result doesn't depend on the number of cores.
+     */
+    Ptr simplified(size_t max_triangles) const;
+
+    /**
+     * Build 'levels' simplified copies, each with 'ratio' of the
+     * triangles of the previous one. Editing the mesh drops them.
+     */
+    void buildLods(int levels = 3, float ratio = 0.5f);
+    int getLodCount() const { return (int)mLods.size() + 1; }
+    const Mesh& getLod(int level) const { return level > 0 ? *mLods[level - 1] : *this; }
+    int selectLod(const math::Frustum &frustum) const;  ///< Level to use for the given view
 };
 
 }
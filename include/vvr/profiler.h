@@ -0,0 +1,103 @@
+#ifndef VVR_PROFILER_H
+#define VVR_PROFILER_H
+
+#include "vvrframework_DLL.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vvr {
+
+    /**
+     * Frame profiler with nestable CPU scopes and GL timer queries.
+     *
+     * Scopes are recorded in a fixed size ring buffer per thread, so recording
+     * never allocates or locks. Disabled scopes cost one relaxed atomic load.
+     * It is off by default; set VVR_PROFILE=1 in the environment, call
+     * setEnabled(), or press F12 in a window (Ctrl+F12 exports a trace).
+     */
+    class VVRFramework_API Profiler
+    {
+    public:
+        struct Event
+        {
+            const char *name;   ///< Must outlive the profiler (string literals)
+            int64_t     begin;  ///< Nanoseconds since the profiler's epoch
+            int64_t     end;
+            int         depth;
+        };
+
+        struct FrameStats
+        {
+            float cpu_ms;
+            float gpu_ms;       ///< Negative when not (yet) available
+        };
+
+        static const size_t RingSize = 1 << 16;    ///< Events kept per thread
+        static const size_t FrameHistory = 240;     ///< Frames kept for the overlay
+
+        static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool on);
+        static bool overlayVisible() { return s_overlay; }
+        static void setOverlayVisible(bool on) { s_overlay = on; }
+        static int64_t now();
+
+        static void begin(const char *name);
+        static void end();
+
+        /**
+         * Frame boundaries, called by GlWidget around paintGL.
+         * Must be called with the GL context current.
+         */
+        static void beginFrame();
+        static void endFrame();
+
+        static std::vector<FrameStats> frameStats();  ///< Oldest first
+        static void drawOverlay(int width, int height);
+
+        /**
+         * Write all buffered events in the Chrome trace event format,
+         * which chrome://tracing and ui.perfetto.dev open. Safe to call while
+         * other threads keep recording; their oldest events may be dropped.
+         */
+        static bool exportChromeTrace(const std::string &filename);
+        static void clear();
+
+    private:
+        static std::atomic<bool> s_enabled;
+        static bool s_overlay;
+    };
+
+    /**
+     * RAII scope marker. Use through vvr_profile_scope().
+     */
+    struct ProfileScope
+    {
+        explicit ProfileScope(const char *name) : active(Profiler::enabled())
+        {
+            if (active) Profiler::begin(name);
+        }
+        ~ProfileScope()
+        {
+            if (active) Profiler::end();
+        }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+    private:
+        const bool active;
+    };
+
+}
+
+/*----[VVR MACRO]-----------------------------------------------------------------------*/
+#define vvr_profile_concat_(a, b) a##b
+#define vvr_profile_concat(a, b) vvr_profile_concat_(a, b)
+
+/*----[VVR MACRO]-----------------------------------------------------------------------*/
+#define vvr_profile_scope(name) vvr::ProfileScope vvr_profile_concat(vvr_profile_scope_, __LINE__)(name)
+
+/*----[VVR MACRO]-----------------------------------------------------------------------*/
+#define vvr_profile_function() vvr_profile_scope(__FUNCTION__)
+
+#endif
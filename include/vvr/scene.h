@@ -5,17 +5,25 @@
 #include "vvrframework_DLL.h"
 #include <vvr/drawing.h>
 #include <vvr/command.h>
+#include <vvr/input.h>
+#include <vvr/sim_clock.h>
+#include <vvr/animation.h>
 #include <MathGeoLib.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace vvr
 {
     enum ArrowDir { UP = 0, DOWN, RIGHT, LEFT, SIZE };
 
+    class CullingGroup;
+
     class VVRFramework_API Scene
     {
     public:
         Scene();
-        virtual ~Scene() {}
+        virtual ~Scene();
         virtual const char* getName() const {
             return "VVRFramework Application";
         }
@@ -24,6 +32,19 @@ namespace vvr
         static inline bool shiftDown(int modif) { return modif & (1 << 1); }
         static inline bool altDown(int modif) { return modif & (1 << 2); }
 
+        /*---[Record / Replay]----------------------------------------------------------*/
+        /**
+         * Seeds rand() and resets the scene, then records frame times and
+         * input until the scene is destroyed. Replaying the recording runs
+         * the exact same sequence of simulation steps and events, as long as
+         * the scene steps its simulation with getClock().
+         */
+        void startRecording(uint32_t seed);
+        void startReplay(const SimRecording &recording);
+        const SimRecording* getRecording() const { return m_recording.get(); }
+        bool isReplaying() const { return m_replaying; }
+        uint32_t getSeed() const { return m_seed; }
+
     protected:
         /*---[Events]-------------------------------------------------------------------*/
         virtual bool idle() { return false; }
@@ -45,13 +66,26 @@ namespace vvr
         float getSceneHeight() const { return m_scene_height; }
         float getCameraDist() const { return m_camera_dist; }
         bool getFullScreen() const { return m_fullscreen; }
+        float getTargetFps() const { return m_target_fps; }
         bool getCreateMenus() const { return m_create_menus; }
         bool shouldShowLog() const { return m_show_log; }
         bool shouldShowSliders() const { return m_show_sliders; }
         void setFrustum(const math::Frustum &frustum) { m_frustum = frustum; }
+        void setTargetFps(float fps) { m_target_fps = fps; }
         void setSliderVal(int slider_id, float val);
         void setCameraPos(const math::vec &pos);
         bool isArrowDown(ArrowDir dir) const { return m_arrow_state[dir]; }
+        SimClock& getClock() { return m_sim_clock; }
+        Animator& getAnimator() { return m_animator; }  ///< Updated before idle(); cleared on reset()
+
+        /**
+         * Runs of mouse motion that arrive between two frames are delivered
+         * as one mouseMoved() / mouseHovered() call, at the latest position.
+         * During that call, this holds every sample of the run, oldest
+         * first, e.g. for capturing strokes; replays hold the same ones.
+         * Empty for other events.
+         */
+        const std::vector<InputEvent>& getMotionSamples() const { return m_motion; }
 
         /*---[Virtual]------------------------------------------------------------------*/
         virtual void draw() = 0;
@@ -65,11 +99,19 @@ namespace vvr
         void enterPixelMode();
         void exitPixelMode();
         void drawAxes();
+        void drawCulled(CullingGroup &group, bool front_to_back = false);  ///< Draws what the camera sees
 
     private:
         void mouse2pix(int &x, int &y);
         void pix2mouse(int &x, int &y);
 
+        /*---[Frame / Input dispatch]---------------------------------------------------*/
+        bool advance();                         ///< Delivers input, advances the clock and animator, then idle()
+        void dispatch(const InputEvent &e);     ///< Queues live input for the next advance()
+        void flushInput();                      ///< Coalesces, records and delivers queued input
+        void deliver(const InputEvent &e);
+        void restartSimulation();
+
     private:
         /*---[OpenGL Callbacks]---------------------------------------------------------*/
         void glRender();
@@ -85,6 +127,7 @@ namespace vvr
         bool            m_show_log;
         bool            m_show_sliders;
         bool            m_first_resize;
+        float           m_target_fps;       ///< Frame rate cap. 0: display refresh rate
 
     protected:
         MacroCmd        cursorShow;
@@ -109,10 +152,22 @@ namespace vvr
         math::float2    m_2d_center;
         math::float2    m_2d_size;
         volatile bool   m_arrow_state[ArrowDir::SIZE];
+        SimClock        m_sim_clock;
+        Animator        m_animator;
+        uint32_t        m_seed;
+        std::unique_ptr<SimRecording> m_recording;
+        SimRecording    m_replay;
+        std::vector<InputEvent> m_input;        ///< Queued since the last frame
+        std::vector<InputEvent> m_motion;
+        size_t          m_replay_frame;
+        size_t          m_replay_event;
+        bool            m_replaying;
 
         /*---[Friends]------------------------------------------------------------------*/
         friend class GlWidget;
         friend class Window;
+        friend class HeadlessRunner;
+        friend class SceneCheck;                ///< Bench/check_scene.cpp
     };
 
     int VVRFramework_API  main_with_scene(int argc, char* argv[], Scene *scene);
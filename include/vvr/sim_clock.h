@@ -0,0 +1,100 @@
+#ifndef VVR_SIM_CLOCK_H
+#define VVR_SIM_CLOCK_H
+
+#include "vvrframework_DLL.h"
+#include "input.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vvr {
+
+    /**
+     * Fixed timestep simulation clock.
+     *
+     * Once per frame, advance() accumulates the scaled frame time and reports
+     * how many fixed steps are due; the scene runs exactly that many steps of
+     * step() seconds. alpha() is the leftover fraction of a step, for
+     * interpolating between the last two simulated states. While paused, the
+     * simulated time stands still and singleStep() releases single steps.
+     */
+    class VVRFramework_API SimClock
+    {
+    public:
+        explicit SimClock(double step = 1.0 / 60);
+
+        void setStep(double sec);
+        double step() const { return m_step; }
+        void setTimeScale(double scale) { m_scale = scale < 0 ? 0 : scale; }
+        double timeScale() const { return m_scale; }
+        void setMaxSteps(int n) { m_max_steps = n < 1 ? 1 : n; }
+        int maxSteps() const { return m_max_steps; }   ///< Per frame. Excess time is dropped.
+
+        void pause() { m_paused = true; }
+        void resume() { m_paused = false; }
+        bool paused() const { return m_paused; }
+        bool toggle() { m_paused = !m_paused; return !m_paused; }
+        void singleStep(int n = 1) { m_single_steps += n; }
+
+        int advance();                          ///< Frame time from get_seconds()
+        int advance(double frame_sec);          ///< Explicit frame time, e.g. from a replay
+
+        int steps() const { return m_steps; }   ///< Steps due this frame
+        float alpha() const { return (float)(m_accum / m_step); }
+        uint64_t stepCount() const { return m_count; }
+        double time() const { return m_count * m_step; }    ///< At the last due step
+        double seconds() const { return time() + m_accum; } ///< Continuous
+        double frameTime() const { return m_frame_sec; }    ///< Real seconds of the last frame
+        void reset();
+
+        /**
+         * The clock animations run on, through sim_seconds().
+         * Scenes install their own clock; see Scene::getClock().
+         */
+        static SimClock *current();
+        static void setCurrent(SimClock *clock);
+
+    private:
+        double      m_step;
+        double      m_scale;
+        double      m_accum;
+        double      m_last_real;
+        double      m_frame_sec;
+        uint64_t    m_count;
+        int         m_steps;
+        int         m_max_steps;
+        int         m_single_steps;
+        bool        m_paused;
+    };
+
+    /**
+     * Seconds of the current SimClock, or the wall clock when there is none.
+     */
+    double
+    VVRFramework_API sim_seconds();
+
+    /**
+     * Everything needed to replay a session deterministically: the random
+     * seed, the frame time of every frame and the input events, each tagged
+     * with the frame it arrived before.
+     */
+    struct VVRFramework_API SimRecording
+    {
+        struct Event
+        {
+            uint32_t    frame;
+            InputEvent  event;
+        };
+
+        uint32_t            seed = 0;
+        double              step = 1.0 / 60;
+        std::vector<double> frames;
+        std::vector<Event>  events;
+
+        bool save(const std::string &filename) const;
+        bool load(const std::string &filename);
+    };
+
+}
+
+#endif
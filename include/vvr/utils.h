@@ -15,6 +15,13 @@ namespace vvr
     float
     VVRFramework_API get_seconds();
 
+    /**
+     * Make get_seconds() return the given time instead of the wall clock,
+     * e.g. for headless runs. A negative value restores the wall clock.
+     */
+    void
+    VVRFramework_API set_synthetic_seconds(float sec);
+
     double
     VVRFramework_API normalize_deg(double deg);
 